@@ -0,0 +1,141 @@
+/*****************************************************************//**
+ * \file   concurrent_queue_benchmark.cpp
+ * \brief  MpmcQueue and SpscQueue throughput against a mutex protected deque
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <utils/container/ConcurrentQueue.h>
+
+namespace {
+
+constexpr uint64_t DEFAULT_ITEM_COUNT = 1 << 22;
+constexpr size_t QUEUE_CAPACITY = 1024;
+
+using Clock = std::chrono::steady_clock;
+
+// the baseline the lock free queues replace
+class LockedQueue {
+  public:
+    bool try_push(uint64_t value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_items.size() == QUEUE_CAPACITY) {
+            return false;
+        }
+        m_items.push_back(value);
+        return true;
+    }
+
+    bool try_pop(uint64_t &value) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_items.empty()) {
+            return false;
+        }
+        value = m_items.front();
+        m_items.pop_front();
+        return true;
+    }
+
+  private:
+    std::mutex m_mutex;
+    std::deque<uint64_t> m_items;
+};
+
+// millions of items per second through the queue, item_count is split evenly over the producers
+template <typename Queue>
+double MeasureThroughput(Queue &queue, uint32_t producer_count, uint32_t consumer_count, uint64_t item_count) {
+    const uint64_t items_per_producer = item_count / producer_count;
+    const uint64_t total = items_per_producer * producer_count;
+    std::atomic<uint64_t> popped{0};
+    std::atomic<uint64_t> checksum{0};
+    std::atomic<bool> start{false};
+
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producer_count; p++) {
+        threads.emplace_back([&] {
+            while (!start.load(std::memory_order_acquire)) {
+            }
+            for (uint64_t i = 0; i < items_per_producer; i++) {
+                while (!queue.try_push(i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (uint32_t c = 0; c < consumer_count; c++) {
+        threads.emplace_back([&] {
+            while (!start.load(std::memory_order_acquire)) {
+            }
+            uint64_t sum = 0, item;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (queue.try_pop(item)) {
+                    sum += item;
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+
+    const auto begin = Clock::now();
+    start.store(true, std::memory_order_release);
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    const uint64_t expected = producer_count * (items_per_producer * (items_per_producer - 1) / 2);
+    if (checksum.load() != expected) {
+        std::fprintf(stderr, "checksum mismatch, items were lost or duplicated\n");
+    }
+    return static_cast<double>(total) / seconds * 1e-6;
+}
+
+void BenchmarkMpmc(uint32_t producer_count, uint32_t consumer_count, uint64_t item_count) {
+    Fract::Container::MpmcQueue<uint64_t> lock_free(QUEUE_CAPACITY);
+    LockedQueue locked;
+    const double lock_free_rate = MeasureThroughput(lock_free, producer_count, consumer_count, item_count);
+    const double locked_rate = MeasureThroughput(locked, producer_count, consumer_count, item_count);
+    std::printf("mpmc %2u x %-2u %12.2f %12.2f %8.2fx\n", producer_count, consumer_count, lock_free_rate, locked_rate,
+                lock_free_rate / locked_rate);
+}
+
+} // namespace
+
+// usage: concurrent_queue_benchmark [item count]
+int main(int argc, char **argv) {
+    const uint64_t item_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_ITEM_COUNT;
+    if (item_count == 0) {
+        std::fprintf(stderr, "usage: %s [item count]\n", argv[0]);
+        return 1;
+    }
+    const uint32_t hardware_threads = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() : 2;
+    const uint32_t half = hardware_threads / 2 > 1 ? hardware_threads / 2 : 2;
+
+    std::printf("%llu items, million items per second\n", static_cast<unsigned long long>(item_count));
+    std::printf("%-12s %12s %12s %9s\n", "", "lock free", "mutex", "speedup");
+
+    Fract::Container::SpscQueue<uint64_t> spsc(QUEUE_CAPACITY);
+    LockedQueue locked;
+    const double spsc_rate = MeasureThroughput(spsc, 1, 1, item_count);
+    const double locked_rate = MeasureThroughput(locked, 1, 1, item_count);
+    std::printf("%-12s %12.2f %12.2f %8.2fx\n", "spsc", spsc_rate, locked_rate, spsc_rate / locked_rate);
+
+    BenchmarkMpmc(1, 1, item_count);
+    BenchmarkMpmc(4, 4, item_count);
+    BenchmarkMpmc(half, half, item_count);
+    return 0;
+}
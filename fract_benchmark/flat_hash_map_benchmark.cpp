@@ -0,0 +1,154 @@
+/*****************************************************************//**
+ * \file   flat_hash_map_benchmark.cpp
+ * \brief  FlatHashMap against pmr::unordered_map for insert, hit, miss and string_view lookups
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/container/FlatHashMap.h>
+
+namespace {
+
+constexpr size_t DEFAULT_KEY_COUNT = 1 << 20;
+constexpr uint32_t REPEAT_COUNT = 5; // the fastest run is reported
+
+using Clock = std::chrono::steady_clock;
+
+// keeps the lookups from being optimized away
+volatile uint64_t sink;
+
+template <typename Function> double MeasureNanoseconds(size_t operation_count, Function &&function) {
+    double best = 0.0;
+    for (uint32_t run = 0; run < REPEAT_COUNT; run++) {
+        const auto begin = Clock::now();
+        function();
+        const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+        best = run == 0 || elapsed < best ? elapsed : best;
+    }
+    return best / static_cast<double>(operation_count);
+}
+
+void Report(const char *name, double flat, double unordered) {
+    std::printf("%-20s %10.2f %10.2f %8.2fx\n", name, flat, unordered, unordered / flat);
+}
+
+template <typename Map> void InsertIntegers(Map &map, const std::vector<uint64_t> &keys) {
+    for (size_t i = 0; i < keys.size(); i++) {
+        map[keys[i]] = static_cast<uint32_t>(i);
+    }
+}
+
+template <typename Map> void FindIntegers(const Map &map, const std::vector<uint64_t> &keys) {
+    uint64_t found = 0;
+    for (uint64_t key : keys) {
+        auto it = map.find(key);
+        found += it != map.end() ? it->second : 1;
+    }
+    sink = found;
+}
+
+void BenchmarkIntegers(size_t key_count) {
+    std::mt19937_64 random(1);
+    std::vector<uint64_t> keys(key_count);
+    std::vector<uint64_t> missing_keys(key_count);
+    for (size_t i = 0; i < key_count; i++) {
+        // even keys are inserted, odd keys are never found
+        keys[i] = random() & ~1ull;
+        missing_keys[i] = random() | 1ull;
+    }
+    std::pmr::memory_resource *resource = std::pmr::new_delete_resource();
+
+    const double flat_insert = MeasureNanoseconds(key_count, [&] {
+        Fract::Container::FlatHashMap<uint64_t, uint32_t> map(resource);
+        InsertIntegers(map, keys);
+        sink = map.size();
+    });
+    const double unordered_insert = MeasureNanoseconds(key_count, [&] {
+        std::pmr::unordered_map<uint64_t, uint32_t> map(resource);
+        InsertIntegers(map, keys);
+        sink = map.size();
+    });
+    Report("insert", flat_insert, unordered_insert);
+
+    Fract::Container::FlatHashMap<uint64_t, uint32_t> flat_map(resource);
+    std::pmr::unordered_map<uint64_t, uint32_t> unordered_map(resource);
+    InsertIntegers(flat_map, keys);
+    InsertIntegers(unordered_map, keys);
+
+    // lookups in a shuffled order so neither map benefits from insertion order
+    std::vector<uint64_t> hit_keys = keys;
+    std::shuffle(hit_keys.begin(), hit_keys.end(), random);
+    Report("find hit", MeasureNanoseconds(key_count, [&] { FindIntegers(flat_map, hit_keys); }),
+           MeasureNanoseconds(key_count, [&] { FindIntegers(unordered_map, hit_keys); }));
+    Report("find miss", MeasureNanoseconds(key_count, [&] { FindIntegers(flat_map, missing_keys); }),
+           MeasureNanoseconds(key_count, [&] { FindIntegers(unordered_map, missing_keys); }));
+}
+
+void BenchmarkStrings(size_t key_count) {
+    std::mt19937_64 random(2);
+    std::vector<std::string> names(key_count);
+    for (size_t i = 0; i < key_count; i++) {
+        // longer than the small string buffer, like resource paths and binding names
+        names[i] = "resources/binding_" + std::to_string(random()) + "_" + std::to_string(i);
+    }
+    std::vector<std::string_view> views(names.begin(), names.end());
+    std::shuffle(views.begin(), views.end(), random);
+    std::pmr::memory_resource *resource = std::pmr::new_delete_resource();
+
+    Fract::Container::FlatHashMap<std::pmr::string, uint32_t> flat_map(resource);
+    std::pmr::unordered_map<std::pmr::string, uint32_t> unordered_map(resource);
+    for (size_t i = 0; i < key_count; i++) {
+        flat_map.try_emplace(std::pmr::string(names[i], resource), static_cast<uint32_t>(i));
+        unordered_map.try_emplace(std::pmr::string(names[i], resource), static_cast<uint32_t>(i));
+    }
+
+    // the flat map hashes the view directly, pmr::unordered_map has no heterogeneous lookup in c++17 and needs a
+    // temporary string per lookup
+    const double flat = MeasureNanoseconds(key_count, [&] {
+        uint64_t found = 0;
+        for (std::string_view view : views) {
+            auto it = flat_map.find(view);
+            found += it != flat_map.end() ? it->second : 1;
+        }
+        sink = found;
+    });
+    const double unordered = MeasureNanoseconds(key_count, [&] {
+        uint64_t found = 0;
+        for (std::string_view view : views) {
+            auto it = unordered_map.find(std::pmr::string(view, resource));
+            found += it != unordered_map.end() ? it->second : 1;
+        }
+        sink = found;
+    });
+    Report("find string_view", flat, unordered);
+}
+
+} // namespace
+
+// usage: flat_hash_map_benchmark [key count]
+int main(int argc, char **argv) {
+    const size_t key_count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : DEFAULT_KEY_COUNT;
+    if (key_count == 0) {
+        std::fprintf(stderr, "usage: %s [key count]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%zu keys, ns per operation\n", key_count);
+    std::printf("%-20s %10s %10s %9s\n", "", "flat", "unordered", "speedup");
+    BenchmarkIntegers(key_count);
+    BenchmarkStrings(key_count);
+    return 0;
+}
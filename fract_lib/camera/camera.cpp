@@ -0,0 +1,45 @@
+/*****************************************************************//**
+ * \file   camera.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "camera.h"
+
+#include <algorithm>
+
+namespace Fract {
+
+Camera::Camera(const CameraCreateInfo &create_info) noexcept
+    : m_position(create_info.position), m_tan_half_fov(std::tan(create_info.vertical_fov * 0.5f)) {
+    m_forward = Math::Normalize(create_info.target - create_info.position);
+    m_right = Math::Normalize(Math::Cross(m_forward, create_info.up));
+    m_up = Math::Cross(m_right, m_forward);
+    SetResolution(create_info.width, create_info.height);
+}
+
+Camera::~Camera() noexcept {}
+
+void Camera::SetResolution(u32 width, u32 height) noexcept {
+    m_width = std::max(width, 1u);
+    m_height = std::max(height, 1u);
+    // angle covered by one pixel at the center of the image
+    m_pixel_spread = std::atan(2.0f * m_tan_half_fov / static_cast<f32>(m_height));
+}
+
+Ray Camera::GenerateRay(f32 x, f32 y) const noexcept {
+    const f32 aspect_ratio = static_cast<f32>(m_width) / static_cast<f32>(m_height);
+    const f32 ndc_x = (2.0f * x / static_cast<f32>(m_width) - 1.0f) * aspect_ratio * m_tan_half_fov;
+    const f32 ndc_y = (1.0f - 2.0f * y / static_cast<f32>(m_height)) * m_tan_half_fov;
+
+    Ray ray{};
+    ray.origin = m_position;
+    ray.direction = Math::Normalize(m_forward + m_right * ndc_x + m_up * ndc_y);
+    ray.cone_width = 0.0f;
+    ray.cone_spread = m_pixel_spread;
+    return ray;
+}
+
+} // namespace Fract
@@ -0,0 +1,50 @@
+/*****************************************************************//**
+ * \file   camera.h
+ * \brief  pinhole camera for the path tracer
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "ray/ray.h"
+
+namespace Fract {
+
+struct CameraCreateInfo {
+    Math::float3 position{};
+    Math::float3 target{0.0f, 0.0f, -1.0f};
+    Math::float3 up{0.0f, 1.0f, 0.0f};
+    f32 vertical_fov = 1.04719755f; // radians
+    u32 width = 1;
+    u32 height = 1;
+};
+
+class Camera {
+  public:
+    Camera(const CameraCreateInfo &create_info) noexcept;
+    ~Camera() noexcept;
+
+    void SetResolution(u32 width, u32 height) noexcept;
+
+    // (x, y) in pixels from the top left corner, rays start with the cone
+    // of a single pixel
+    Ray GenerateRay(f32 x, f32 y) const noexcept;
+
+    u32 GetWidth() const noexcept { return m_width; }
+    u32 GetHeight() const noexcept { return m_height; }
+    const Math::float3 &GetPosition() const noexcept { return m_position; }
+
+  private:
+    Math::float3 m_position{};
+    Math::float3 m_forward{};
+    Math::float3 m_right{};
+    Math::float3 m_up{};
+    f32 m_tan_half_fov{};
+    f32 m_pixel_spread{};
+    u32 m_width{};
+    u32 m_height{};
+};
+
+} // namespace Fract
@@ -0,0 +1,445 @@
+/*****************************************************************//**
+ * \file   mesh.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "utils/log/log.h"
+#include "utils/math/Packing.h"
+
+namespace Fract {
+
+namespace {
+
+// spread the low 10 bits of v so that there are two zero bits between each
+u32 ExpandBits(u32 v) {
+    v = (v * 0x00010001u) & 0xff0000ffu;
+    v = (v * 0x00000101u) & 0x0f00f00fu;
+    v = (v * 0x00000011u) & 0xc30c30c3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+f32 VertexCacheScore(i32 cache_position, u32 remaining_valence) {
+    if (remaining_valence == 0) {
+        return -1.0f;
+    }
+    f32 score = 0.0f;
+    if (cache_position >= 0) {
+        if (cache_position < 3) {
+            // vertices of the last triangle, don't favour them over the rest of the cache
+            score = 0.75f;
+        } else {
+            constexpr f32 scaler = 1.0f / (MESH_VERTEX_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<f32>(cache_position - 3) * scaler, 1.5f);
+        }
+    }
+    // boost vertices with few triangles left so we don't leave lonely triangles behind
+    score += 2.0f / std::sqrt(static_cast<f32>(remaining_valence));
+    return score;
+}
+
+} // namespace
+
+Mesh::Mesh(std::pmr::memory_resource *resource) noexcept
+    : positions(resource), normals(resource), tangents(resource), uvs(resource), indices(resource),
+      m_compressed_vertices(resource), m_clusters(resource) {}
+
+Mesh::~Mesh() noexcept {}
+
+void Mesh::Resize(u32 vertex_count, u32 triangle_count, bool has_normals, bool has_tangents, bool has_uvs) {
+    ClearNumaReplicas();
+    m_storage_mode = MeshStorageMode::FULL_PRECISION;
+    m_vertex_count = vertex_count;
+    m_layout_optimized = false;
+
+    positions.resize(vertex_count);
+    normals.resize(has_normals ? vertex_count : 0);
+    tangents.resize(has_tangents ? vertex_count : 0);
+    uvs.resize(has_uvs ? vertex_count : 0);
+    indices.resize(static_cast<size_t>(triangle_count) * 3);
+    m_compressed_vertices.clear();
+    m_clusters.clear();
+}
+
+bool Mesh::OptimizeLayout() {
+    if (m_storage_mode != MeshStorageMode::FULL_PRECISION) {
+        LOG_ERROR("can't reorder a compressed mesh");
+        return false;
+    }
+    ClearNumaReplicas();
+    const u32 triangle_count = GetTriangleCount();
+    if (triangle_count == 0 || m_layout_optimized) {
+        return true;
+    }
+    if (positions.empty()) {
+        LOG_ERROR("can't reorder a mesh with {} triangles and no vertices", triangle_count);
+        return false;
+    }
+    const u32 vertex_count = static_cast<u32>(positions.size());
+    const auto invalid_index = std::find_if(indices.begin(), indices.end(), [=](u32 i) { return i >= vertex_count; });
+    if (invalid_index != indices.end()) {
+        LOG_ERROR("can't reorder a mesh with index {} out of its {} vertices", *invalid_index, vertex_count);
+        return false;
+    }
+    auto *resource = indices.get_allocator().resource();
+
+    // sort triangles along a morton curve of their centroids
+    Math::float3 bounds_min = positions[0];
+    Math::float3 bounds_max = positions[0];
+    for (const auto &p : positions) {
+        bounds_min = Math::Min(bounds_min, p);
+        bounds_max = Math::Max(bounds_max, p);
+    }
+    const Math::float3 extent = bounds_max - bounds_min;
+    const Math::float3 scale{1023.0f / std::max(extent.x, 1e-20f), 1023.0f / std::max(extent.y, 1e-20f),
+                             1023.0f / std::max(extent.z, 1e-20f)};
+
+    Container::Array<u64> keys(triangle_count, resource);
+    for (u32 t = 0; t < triangle_count; t++) {
+        u32 i0, i1, i2;
+        GetTriangleIndices(t, i0, i1, i2);
+        const Math::float3 centroid = (positions[i0] + positions[i1] + positions[i2]) / 3.0f;
+        const Math::float3 q = (centroid - bounds_min) * scale;
+        const u32 code = (ExpandBits(static_cast<u32>(std::clamp(q.x, 0.0f, 1023.0f))) << 2) |
+                         (ExpandBits(static_cast<u32>(std::clamp(q.y, 0.0f, 1023.0f))) << 1) |
+                         ExpandBits(static_cast<u32>(std::clamp(q.z, 0.0f, 1023.0f)));
+        keys[t] = (static_cast<u64>(code) << 32) | t;
+    }
+    std::sort(keys.begin(), keys.end());
+
+    Container::Array<u32> sorted_indices(indices.size(), resource);
+    for (u32 t = 0; t < triangle_count; t++) {
+        const u32 src = static_cast<u32>(keys[t] & 0xffffffffu);
+        sorted_indices[t * 3 + 0] = indices[src * 3 + 0];
+        sorted_indices[t * 3 + 1] = indices[src * 3 + 1];
+        sorted_indices[t * 3 + 2] = indices[src * 3 + 2];
+    }
+    indices.swap(sorted_indices);
+
+    OptimizeVertexCache();
+    ReorderVertices();
+    m_layout_optimized = true;
+    return true;
+}
+
+void Mesh::OptimizeVertexCache() {
+    const u32 triangle_count = GetTriangleCount();
+    auto *resource = indices.get_allocator().resource();
+
+    // vertex -> triangle adjacency, the first remaining_valence[v] entries of a
+    // vertex are the triangles not emitted yet
+    Container::Array<u32> adjacency_offset(static_cast<size_t>(m_vertex_count) + 1, 0, resource);
+    for (u32 index : indices) {
+        adjacency_offset[index + 1]++;
+    }
+    std::partial_sum(adjacency_offset.begin(), adjacency_offset.end(), adjacency_offset.begin());
+
+    Container::Array<u32> adjacency(indices.size(), resource);
+    Container::Array<u32> remaining_valence(m_vertex_count, 0, resource);
+    for (u32 t = 0; t < triangle_count; t++) {
+        for (u32 k = 0; k < 3; k++) {
+            const u32 v = indices[t * 3 + k];
+            adjacency[adjacency_offset[v] + remaining_valence[v]++] = t;
+        }
+    }
+
+    Container::Array<i32> cache_position(m_vertex_count, -1, resource);
+    Container::Array<f32> vertex_score(m_vertex_count, resource);
+    for (u32 v = 0; v < m_vertex_count; v++) {
+        vertex_score[v] = VertexCacheScore(-1, remaining_valence[v]);
+    }
+
+    Container::Array<u8> emitted(triangle_count, 0, resource);
+    Container::Array<u32> output(indices.size(), resource);
+
+    // lru cache, the 3 extra slots hold the vertices pushed out by the last triangle
+    Container::FixedArray<u32, MESH_VERTEX_CACHE_SIZE + 3> cache{}, next_cache{};
+    u32 cache_size = 0;
+
+    // triangles are morton ordered, so when nothing in the cache is worth
+    // continuing with we resume from the next triangle in that order
+    u32 cursor = 0;
+    i64 best = 0;
+
+    for (u32 emitted_count = 0; emitted_count < triangle_count; emitted_count++) {
+        if (best < 0) {
+            while (emitted[cursor]) {
+                cursor++;
+            }
+            best = cursor;
+        }
+        const u32 triangle = static_cast<u32>(best);
+        emitted[triangle] = 1;
+
+        u32 next_cache_size = 0;
+        for (u32 k = 0; k < 3; k++) {
+            const u32 v = indices[triangle * 3 + k];
+            output[emitted_count * 3 + k] = v;
+            next_cache[next_cache_size++] = v;
+
+            const u32 begin = adjacency_offset[v];
+            const u32 end = begin + remaining_valence[v];
+            for (u32 i = begin; i < end; i++) {
+                if (adjacency[i] == triangle) {
+                    std::swap(adjacency[i], adjacency[end - 1]);
+                    break;
+                }
+            }
+            remaining_valence[v]--;
+        }
+
+        for (u32 i = 0; i < cache_size; i++) {
+            const u32 v = cache[i];
+            if (v == next_cache[0] || v == next_cache[1] || v == next_cache[2]) {
+                continue;
+            }
+            if (next_cache_size < next_cache.size()) {
+                next_cache[next_cache_size++] = v;
+            } else {
+                cache_position[v] = -1;
+                vertex_score[v] = VertexCacheScore(-1, remaining_valence[v]);
+            }
+        }
+
+        for (u32 i = 0; i < next_cache_size; i++) {
+            const u32 v = next_cache[i];
+            cache_position[v] = i < MESH_VERTEX_CACHE_SIZE ? static_cast<i32>(i) : -1;
+            vertex_score[v] = VertexCacheScore(cache_position[v], remaining_valence[v]);
+        }
+
+        // only triangles touching the cache can gain from the new state
+        best = -1;
+        f32 best_score = -1.0f;
+        for (u32 i = 0; i < next_cache_size; i++) {
+            const u32 v = next_cache[i];
+            const u32 begin = adjacency_offset[v];
+            for (u32 j = begin; j < begin + remaining_valence[v]; j++) {
+                const u32 t = adjacency[j];
+                const f32 score = vertex_score[indices[t * 3 + 0]] + vertex_score[indices[t * 3 + 1]] +
+                                  vertex_score[indices[t * 3 + 2]];
+                if (score > best_score) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        std::swap(cache, next_cache);
+        cache_size = next_cache_size;
+    }
+
+    indices.swap(output);
+}
+
+void Mesh::ReorderVertices() {
+    auto *resource = indices.get_allocator().resource();
+
+    constexpr u32 unused = ~0u;
+    Container::Array<u32> remap(m_vertex_count, unused, resource);
+    u32 vertex_count = 0;
+    for (u32 &index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = vertex_count++;
+        }
+        index = remap[index];
+    }
+
+    // vertices no triangle references are dropped
+    auto reorder = [&](auto &stream) {
+        if (stream.empty()) {
+            return;
+        }
+        std::remove_reference_t<decltype(stream)> reordered(vertex_count, resource);
+        for (u32 v = 0; v < m_vertex_count; v++) {
+            if (remap[v] != unused) {
+                reordered[remap[v]] = stream[v];
+            }
+        }
+        stream.swap(reordered);
+    };
+    reorder(positions);
+    reorder(normals);
+    reorder(tangents);
+    reorder(uvs);
+
+    m_vertex_count = vertex_count;
+}
+
+void Mesh::Compress() {
+    if (m_storage_mode == MeshStorageMode::COMPRESSED) {
+        return;
+    }
+    ClearNumaReplicas();
+    if (!OptimizeLayout()) {
+        return;
+    }
+
+    const u32 cluster_count = (m_vertex_count + MESH_CLUSTER_VERTEX_COUNT - 1) / MESH_CLUSTER_VERTEX_COUNT;
+    m_clusters.resize(cluster_count);
+    m_compressed_vertices.resize(m_vertex_count);
+
+    for (u32 c = 0; c < cluster_count; c++) {
+        const u32 first = c * MESH_CLUSTER_VERTEX_COUNT;
+        const u32 last = std::min(first + MESH_CLUSTER_VERTEX_COUNT, m_vertex_count);
+
+        Math::float3 bounds_min = positions[first];
+        Math::float3 bounds_max = positions[first];
+        for (u32 v = first; v < last; v++) {
+            bounds_min = Math::Min(bounds_min, positions[v]);
+            bounds_max = Math::Max(bounds_max, positions[v]);
+        }
+        const Math::float3 extent = bounds_max - bounds_min;
+        const Math::float3 inv_extent{extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                                      extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                                      extent.z > 0.0f ? 1.0f / extent.z : 0.0f};
+
+        m_clusters[c].bounds_min = bounds_min;
+        m_clusters[c].quantize_scale = extent * (1.0f / 65535.0f);
+
+        // positions and uvs are converted a cluster at a time with the batch kernels, then interleaved
+        const u32 count = last - first;
+        f32 normalized[MESH_CLUSTER_VERTEX_COUNT * 3];
+        for (u32 v = first; v < last; v++) {
+            const Math::float3 p = (positions[v] - bounds_min) * inv_extent;
+            normalized[(v - first) * 3 + 0] = p.x;
+            normalized[(v - first) * 3 + 1] = p.y;
+            normalized[(v - first) * 3 + 2] = p.z;
+        }
+        u16 quantized[MESH_CLUSTER_VERTEX_COUNT * 3];
+        Math::QuantizeUnorm16(normalized, quantized, count * 3);
+        u16 half_uvs[MESH_CLUSTER_VERTEX_COUNT * 2]{};
+        if (!uvs.empty()) {
+            static_assert(sizeof(Math::float2) == sizeof(f32) * 2, "uvs are converted as a flat float array");
+            Math::FloatToHalf(&uvs[first].x, half_uvs, count * 2);
+        }
+
+        for (u32 v = first; v < last; v++) {
+            CompressedVertex &cv = m_compressed_vertices[v];
+            std::memcpy(cv.position, &quantized[(v - first) * 3], sizeof(cv.position));
+
+            cv.normal = Math::PackOctahedral(normals.empty() ? Math::float3{0.0f, 0.0f, 1.0f} : normals[v]);
+            if (tangents.empty()) {
+                cv.tangent = Math::PackOctahedral(Math::float3{1.0f, 0.0f, 0.0f});
+                cv.tangent_sign = 1;
+            } else {
+                const Math::float4 &t = tangents[v];
+                cv.tangent = Math::PackOctahedral(Math::float3{t.x, t.y, t.z});
+                cv.tangent_sign = t.w < 0.0f ? -1 : 1;
+            }
+
+            std::memcpy(cv.uv, &half_uvs[(v - first) * 2], sizeof(cv.uv));
+        }
+    }
+
+    // release the full precision streams
+    auto *resource = indices.get_allocator().resource();
+    Container::Array<Math::float3>(resource).swap(positions);
+    Container::Array<Math::float3>(resource).swap(normals);
+    Container::Array<Math::float4>(resource).swap(tangents);
+    Container::Array<Math::float2>(resource).swap(uvs);
+
+    m_storage_mode = MeshStorageMode::COMPRESSED;
+}
+
+void Mesh::ReplicateAcrossNumaNodes() const {
+    m_index_replicas.Replicate(indices.data(), indices.size());
+    if (m_storage_mode == MeshStorageMode::FULL_PRECISION) {
+        m_position_replicas.Replicate(positions.data(), positions.size());
+    } else {
+        m_compressed_vertex_replicas.Replicate(m_compressed_vertices.data(), m_compressed_vertices.size());
+        m_cluster_replicas.Replicate(m_clusters.data(), m_clusters.size());
+    }
+}
+
+void Mesh::ClearNumaReplicas() noexcept {
+    m_index_replicas.Clear();
+    m_position_replicas.Clear();
+    m_compressed_vertex_replicas.Clear();
+    m_cluster_replicas.Clear();
+}
+
+u64 Mesh::GetVertexMemorySize() const noexcept {
+    if (m_storage_mode == MeshStorageMode::COMPRESSED) {
+        return m_compressed_vertices.size() * sizeof(CompressedVertex) + m_clusters.size() * sizeof(MeshCluster);
+    }
+    return positions.size() * sizeof(Math::float3) + normals.size() * sizeof(Math::float3) +
+           tangents.size() * sizeof(Math::float4) + uvs.size() * sizeof(Math::float2);
+}
+
+Math::float3 Mesh::GetPosition(u32 vertex) const noexcept {
+    if (m_storage_mode == MeshStorageMode::FULL_PRECISION) {
+        return m_position_replicas.Get(positions.data())[vertex];
+    }
+    const CompressedVertex &cv = m_compressed_vertex_replicas.Get(m_compressed_vertices.data())[vertex];
+    const MeshCluster &cluster = m_cluster_replicas.Get(m_clusters.data())[vertex / MESH_CLUSTER_VERTEX_COUNT];
+    const Math::float3 q{static_cast<f32>(cv.position[0]), static_cast<f32>(cv.position[1]),
+                         static_cast<f32>(cv.position[2])};
+    return cluster.bounds_min + q * cluster.quantize_scale;
+}
+
+MeshVertex Mesh::GetVertex(u32 vertex) const noexcept {
+    MeshVertex result{};
+    result.position = GetPosition(vertex);
+
+    if (m_storage_mode == MeshStorageMode::FULL_PRECISION) {
+        result.normal = normals.empty() ? Math::float3{0.0f, 0.0f, 1.0f} : normals[vertex];
+        result.tangent = tangents.empty() ? Math::float4{1.0f, 0.0f, 0.0f, 1.0f} : tangents[vertex];
+        result.uv = uvs.empty() ? Math::float2{0.0f, 0.0f} : uvs[vertex];
+        return result;
+    }
+
+    const CompressedVertex &cv = m_compressed_vertices[vertex];
+    result.normal = Math::UnpackOctahedral(cv.normal);
+    const Math::float3 t = Math::UnpackOctahedral(cv.tangent);
+    result.tangent = Math::float4{t.x, t.y, t.z, static_cast<f32>(cv.tangent_sign)};
+    result.uv = Math::float2{Math::HalfToFloat(cv.uv[0]), Math::HalfToFloat(cv.uv[1])};
+    return result;
+}
+
+MeshVertex Mesh::Interpolate(u32 triangle, f32 b1, f32 b2) const noexcept {
+    u32 i0, i1, i2;
+    GetTriangleIndices(triangle, i0, i1, i2);
+    const MeshVertex v0 = GetVertex(i0);
+    const MeshVertex v1 = GetVertex(i1);
+    const MeshVertex v2 = GetVertex(i2);
+    const f32 b0 = 1.0f - b1 - b2;
+
+    MeshVertex result{};
+    result.position = v0.position * b0 + v1.position * b1 + v2.position * b2;
+    result.normal = Math::Normalize(v0.normal * b0 + v1.normal * b1 + v2.normal * b2);
+    const Math::float4 t = v0.tangent * b0 + v1.tangent * b1 + v2.tangent * b2;
+    const Math::float3 tangent = Math::Normalize(Math::float3{t.x, t.y, t.z});
+    result.tangent = Math::float4{tangent.x, tangent.y, tangent.z, v0.tangent.w};
+    result.uv = v0.uv * b0 + v1.uv * b1 + v2.uv * b2;
+    return result;
+}
+
+f32 Mesh::GetTextureLodBias(u32 triangle) const noexcept {
+    u32 i0, i1, i2;
+    GetTriangleIndices(triangle, i0, i1, i2);
+    const MeshVertex v0 = GetVertex(i0);
+    const MeshVertex v1 = GetVertex(i1);
+    const MeshVertex v2 = GetVertex(i2);
+
+    const f32 world_area = Math::Length(Math::Cross(v1.position - v0.position, v2.position - v0.position));
+    const Math::float2 e1 = v1.uv - v0.uv;
+    const Math::float2 e2 = v2.uv - v0.uv;
+    const f32 uv_area = std::abs(e1.x * e2.y - e1.y * e2.x);
+    if (world_area <= 0.0f || uv_area <= 0.0f) {
+        return 0.0f;
+    }
+    return 0.5f * std::log2(uv_area / world_area);
+}
+
+} // namespace Fract
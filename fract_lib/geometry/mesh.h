@@ -0,0 +1,128 @@
+/*****************************************************************//**
+ * \file   mesh.h
+ * \brief  triangle mesh with full precision and compressed vertex storage
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "utils/defination.h"
+#include "utils/math/Math.h"
+#include "utils/memory/Numa.h"
+
+namespace Fract {
+
+enum class MeshStorageMode { FULL_PRECISION, COMPRESSED };
+
+// consecutive vertices share one quantization box, vertices are ordered by
+// first use after OptimizeLayout() so a cluster is spatially compact
+static constexpr u32 MESH_CLUSTER_VERTEX_COUNT = 256;
+
+// simulated post transform cache used when ordering triangles
+static constexpr u32 MESH_VERTEX_CACHE_SIZE = 32;
+
+struct MeshCluster {
+    Math::float3 bounds_min{};
+    Math::float3 quantize_scale{}; // extent / 65535
+};
+
+// 20 bytes, 48 bytes in full precision
+struct CompressedVertex {
+    u16 position[3]; // unorm16 relative to cluster bounds
+    i16 tangent_sign; // bitangent handedness
+    u32 normal;       // octahedral, 2 x snorm16
+    u32 tangent;      // octahedral, 2 x snorm16
+    u16 uv[2];        // half
+};
+
+static_assert(sizeof(CompressedVertex) == 20);
+
+struct MeshVertex {
+    Math::float3 position{};
+    Math::float3 normal{};
+    Math::float4 tangent{}; // w is the bitangent handedness
+    Math::float2 uv{};
+};
+
+class Mesh {
+  public:
+    Mesh(std::pmr::memory_resource *resource = Memory::GetGlobalAllocator(Memory::MemoryTag::GEOMETRY)) noexcept;
+    ~Mesh() noexcept;
+
+    Mesh(const Mesh &rhs) noexcept = delete;
+    Mesh &operator=(const Mesh &rhs) noexcept = delete;
+    Mesh(Mesh &&rhs) noexcept = default;
+    Mesh &operator=(Mesh &&rhs) = default;
+
+    // size the full precision streams once, importers write into them directly
+    void Resize(u32 vertex_count, u32 triangle_count, bool has_normals = true, bool has_tangents = true,
+                bool has_uvs = true);
+
+    // reorder triangles along a morton curve, then for vertex cache reuse, and
+    // renumber vertices by first use. false and the mesh unchanged when it is
+    // compressed or an index is out of range
+    bool OptimizeLayout();
+
+    // quantize the vertex streams and release the full precision copies, the
+    // mesh stays at full precision if OptimizeLayout() fails
+    void Compress();
+
+    MeshStorageMode GetStorageMode() const noexcept { return m_storage_mode; }
+    u32 GetVertexCount() const noexcept { return m_vertex_count; }
+    u32 GetTriangleCount() const noexcept { return static_cast<u32>(indices.size() / 3); }
+    u64 GetVertexMemorySize() const noexcept;
+
+    // copy the indices and positions to every numa node so bound threads
+    // intersect node local data. call once the mesh is final, resizing,
+    // reordering or compressing drops the copies. no-op on single node
+    // machines
+    void ReplicateAcrossNumaNodes() const;
+
+    void GetTriangleIndices(u32 triangle, u32 &i0, u32 &i1, u32 &i2) const noexcept {
+        const u32 *triangle_indices = m_index_replicas.Get(indices.data()) + triangle * 3;
+        i0 = triangle_indices[0];
+        i1 = triangle_indices[1];
+        i2 = triangle_indices[2];
+    }
+
+    Math::float3 GetPosition(u32 vertex) const noexcept;
+    MeshVertex GetVertex(u32 vertex) const noexcept;
+
+    // interpolate attributes at barycentric (b1, b2) of a triangle
+    MeshVertex Interpolate(u32 triangle, f32 b1, f32 b2) const noexcept;
+
+    // half log2 of the uv to world area ratio of a triangle, the texture
+    // independent part of the ray cone lod
+    f32 GetTextureLodBias(u32 triangle) const noexcept;
+
+  public:
+    // full precision streams, empty after Compress()
+    Container::Array<Math::float3> positions;
+    Container::Array<Math::float3> normals;
+    Container::Array<Math::float4> tangents;
+    Container::Array<Math::float2> uvs;
+
+    Container::Array<u32> indices;
+
+  private:
+    void OptimizeVertexCache();
+    void ReorderVertices();
+    void ClearNumaReplicas() noexcept;
+
+    MeshStorageMode m_storage_mode{MeshStorageMode::FULL_PRECISION};
+    u32 m_vertex_count{};
+    bool m_layout_optimized{false};
+
+    Container::Array<CompressedVertex> m_compressed_vertices;
+    Container::Array<MeshCluster> m_clusters;
+
+    // read only copies of what intersection reads, logically const
+    mutable Memory::NumaReplicatedArray<u32> m_index_replicas;
+    mutable Memory::NumaReplicatedArray<Math::float3> m_position_replicas;
+    mutable Memory::NumaReplicatedArray<CompressedVertex> m_compressed_vertex_replicas;
+    mutable Memory::NumaReplicatedArray<MeshCluster> m_cluster_replicas;
+};
+
+} // namespace Fract
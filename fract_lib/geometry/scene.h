@@ -0,0 +1,26 @@
+/*****************************************************************//**
+ * \file   scene.h
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "mesh.h"
+#include "ray/bvh.h"
+
+namespace Fract {
+
+struct Scene {
+    // without a resource meshes and bvh are accounted to their own memory tags
+    Scene(std::pmr::memory_resource *resource = nullptr) noexcept
+        : meshes(resource ? resource : Memory::GetGlobalAllocator(Memory::MemoryTag::GEOMETRY)),
+          bvh(resource ? resource : Memory::GetGlobalAllocator(Memory::MemoryTag::ACCELERATION)) {}
+
+    Container::Array<Mesh> meshes;
+    BVH bvh;
+};
+
+} // namespace Fract
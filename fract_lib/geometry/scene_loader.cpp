@@ -0,0 +1,152 @@
+/*****************************************************************//**
+ * \file   scene_loader.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "scene_loader.h"
+
+#include <chrono>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include "utils/job/Parallel.h"
+#include "utils/log/log.h"
+
+namespace Fract {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+f64 ElapsedMilliseconds(Clock::time_point start) {
+    return std::chrono::duration<f64, std::milli>(Clock::now() - start).count();
+}
+
+// the mesh streams are sized once and written in place
+void ConvertMesh(const aiMesh *source, Mesh &mesh, const SceneLoadOptions &options) {
+    u32 triangle_count = 0;
+    for (u32 f = 0; f < source->mNumFaces; f++) {
+        if (source->mFaces[f].mNumIndices == 3) {
+            triangle_count++;
+        }
+    }
+
+    const bool has_normals = source->HasNormals();
+    const bool has_tangents = has_normals && source->HasTangentsAndBitangents();
+    const bool has_uvs = source->HasTextureCoords(0);
+    mesh.Resize(source->mNumVertices, triangle_count, has_normals, has_tangents, has_uvs);
+
+    for (u32 v = 0; v < source->mNumVertices; v++) {
+        const aiVector3D &p = source->mVertices[v];
+        mesh.positions[v] = Math::float3{p.x, p.y, p.z};
+    }
+    if (has_normals) {
+        for (u32 v = 0; v < source->mNumVertices; v++) {
+            const aiVector3D &n = source->mNormals[v];
+            mesh.normals[v] = Math::float3{n.x, n.y, n.z};
+        }
+    }
+    if (has_tangents) {
+        for (u32 v = 0; v < source->mNumVertices; v++) {
+            const aiVector3D &t = source->mTangents[v];
+            const aiVector3D &b = source->mBitangents[v];
+            const Math::float3 tangent{t.x, t.y, t.z};
+            const f32 handedness =
+                Math::Dot(Math::Cross(mesh.normals[v], tangent), Math::float3{b.x, b.y, b.z}) < 0.0f ? -1.0f : 1.0f;
+            mesh.tangents[v] = Math::float4{t.x, t.y, t.z, handedness};
+        }
+    }
+    if (has_uvs) {
+        for (u32 v = 0; v < source->mNumVertices; v++) {
+            const aiVector3D &uv = source->mTextureCoords[0][v];
+            mesh.uvs[v] = Math::float2{uv.x, uv.y};
+        }
+    }
+
+    u32 *indices = mesh.indices.data();
+    for (u32 f = 0; f < source->mNumFaces; f++) {
+        const aiFace &face = source->mFaces[f];
+        if (face.mNumIndices != 3) {
+            continue;
+        }
+        indices[0] = face.mIndices[0];
+        indices[1] = face.mIndices[1];
+        indices[2] = face.mIndices[2];
+        indices += 3;
+    }
+
+    if (options.compress_vertices) {
+        mesh.Compress();
+    } else if (options.optimize_layout) {
+        mesh.OptimizeLayout();
+    }
+}
+
+} // namespace
+
+bool LoadScene(const std::filesystem::path &file_name, Scene &scene, const SceneLoadOptions &options,
+               SceneLoadStatistics *statistics) {
+    SceneLoadStatistics result{};
+
+    // parse
+    auto start = Clock::now();
+    Assimp::Importer importer;
+    // points and lines are split into their own meshes and skipped below
+    const aiScene *source = importer.ReadFile(
+        file_name.string(), aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_GenSmoothNormals |
+                                aiProcess_CalcTangentSpace | aiProcess_PreTransformVertices | aiProcess_SortByPType);
+    if (!source || (source->mFlags & AI_SCENE_FLAGS_INCOMPLETE)) {
+        LOG_ERROR("failed to import {}: {}", file_name.string(), importer.GetErrorString());
+        return false;
+    }
+    result.parse_time = ElapsedMilliseconds(start);
+
+    // convert
+    start = Clock::now();
+    auto *resource = scene.meshes.get_allocator().resource();
+    Container::Array<u32> source_meshes(resource);
+    source_meshes.reserve(source->mNumMeshes);
+    for (u32 m = 0; m < source->mNumMeshes; m++) {
+        if (source->mMeshes[m]->mPrimitiveTypes & aiPrimitiveType_TRIANGLE) {
+            source_meshes.push_back(m);
+        }
+    }
+
+    scene.meshes.clear();
+    scene.meshes.resize(source_meshes.size());
+
+    Job::ParallelFor(0, source_meshes.size(), 1, [&](u64 begin, u64 end) {
+        for (u64 m = begin; m < end; m++) {
+            ConvertMesh(source->mMeshes[source_meshes[m]], scene.meshes[m], options);
+        }
+    });
+    result.convert_time = ElapsedMilliseconds(start);
+
+    for (const Mesh &mesh : scene.meshes) {
+        result.vertex_count += mesh.GetVertexCount();
+        result.triangle_count += mesh.GetTriangleCount();
+    }
+
+    // bvh
+    if (options.build_bvh) {
+        start = Clock::now();
+        scene.bvh.Build(scene.meshes.data(), static_cast<u32>(scene.meshes.size()));
+        result.bvh_time = ElapsedMilliseconds(start);
+    }
+
+    LOG_INFO("loaded {}: {} meshes, {} triangles, parse {:.1f} ms, convert {:.1f} ms, bvh {:.1f} ms",
+             file_name.string(), scene.meshes.size(), result.triangle_count, result.parse_time, result.convert_time,
+             result.bvh_time);
+
+    if (statistics) {
+        *statistics = result;
+    }
+    return true;
+}
+
+} // namespace Fract
@@ -0,0 +1,36 @@
+/*****************************************************************//**
+ * \file   scene_loader.h
+ * \brief  import meshes through assimp
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <filesystem>
+
+#include "scene.h"
+
+namespace Fract {
+
+struct SceneLoadOptions {
+    bool optimize_layout = true;
+    bool compress_vertices = false;
+    bool build_bvh = true;
+};
+
+// wall time of each import phase in milliseconds
+struct SceneLoadStatistics {
+    f64 parse_time{};
+    f64 convert_time{};
+    f64 bvh_time{};
+    u64 vertex_count{};
+    u64 triangle_count{};
+};
+
+// meshes are converted in parallel on the job system, one task per assimp mesh, inline when it isn't initialized
+bool LoadScene(const std::filesystem::path &file_name, Scene &scene, const SceneLoadOptions &options = {},
+               SceneLoadStatistics *statistics = nullptr);
+
+} // namespace Fract
@@ -0,0 +1,406 @@
+/*****************************************************************//**
+ * \file   path_integrator.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "path_integrator.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "utils/job/Parallel.h"
+#include "utils/log/log.h"
+#include "utils/memory/Memory.h"
+#include "utils/trace/Trace.h"
+
+namespace Fract {
+
+namespace {
+
+constexpr u32 INTEGRATOR_TILE_SIZE = 16;
+constexpr f32 INTEGRATOR_RAY_OFFSET = 1e-4f; // along the geometric normal, keeps bounce rays off their surface
+
+u64 SplitMix64(u64 &state) noexcept {
+    u64 z = (state += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+// pcg32, one stream per pixel and sample
+class Sampler {
+  public:
+    Sampler(u32 pixel, u32 sample, u32 seed) noexcept {
+        u64 state = (static_cast<u64>(seed) << 32) ^ (static_cast<u64>(pixel) * 0x100000001b3ull) ^ sample;
+        m_increment = SplitMix64(state) | 1u;
+        m_state = SplitMix64(state);
+    }
+
+    u32 Next() noexcept {
+        const u64 state = m_state;
+        m_state = state * 6364136223846793005ull + m_increment;
+        const u32 xorshifted = static_cast<u32>(((state >> 18u) ^ state) >> 27u);
+        const u32 rotation = static_cast<u32>(state >> 59u);
+        return (xorshifted >> rotation) | (xorshifted << ((32 - rotation) & 31));
+    }
+
+    // [0, 1)
+    f32 Get1D() noexcept { return static_cast<f32>(Next() >> 8) * (1.0f / 16777216.0f); }
+    Math::float2 Get2D() noexcept {
+        const f32 x = Get1D();
+        return Math::float2{x, Get1D()};
+    }
+
+  private:
+    u64 m_state{};
+    u64 m_increment{};
+};
+
+struct PathAOV {
+    Math::float3 albedo{};
+    Math::float3 normal{};
+    f32 depth{std::numeric_limits<f32>::infinity()};
+};
+
+// one camera path of a tile, traced a bounce at a time together with the others
+struct PathState {
+    PathState(u32 pixel, u32 sample, u32 seed) noexcept : sampler(pixel, sample, seed) {}
+
+    Ray ray{};
+    Sampler sampler;
+    Math::float3 radiance{};
+    Math::float3 throughput{1.0f};
+    f32 brdf_pdf{};
+    bool active{true};
+    PathAOV aov{};
+    // light samples of the current bounce, added to radiance once their shadow rays are traced
+    bool shaded{};
+    Math::float3 shading_throughput{};
+    Math::float3 delta_light{};
+    Math::float3 environment_light{};
+};
+
+// unoccluded contribution of a light sample waiting for its shadow ray
+struct ShadowSample {
+    u32 path;
+    bool environment;
+    Math::float3 contribution;
+};
+
+f32 MaxComponent(const Math::float3 &v) noexcept { return std::max(v.x, std::max(v.y, v.z)); }
+
+template <typename Features> class PathIntegratorImpl {
+  public:
+    PathIntegratorImpl(const IntegratorScene &scene, std::pmr::memory_resource *scratch, u32 path_count) noexcept
+        : m_scene(scene), m_bvh(scene.scene->bvh), m_meshes(scene.scene->meshes.data()), m_shadow_rays(scratch),
+          m_shadow_samples(scratch), m_occluded(scratch) {
+        // every light and the environment once per path and bounce at most
+        const size_t shadow_ray_count =
+            static_cast<size_t>(path_count) * (scene.point_light_count + scene.distant_light_count + 1);
+        m_shadow_rays.reserve(shadow_ray_count);
+        m_shadow_samples.reserve(shadow_ray_count);
+        m_occluded.reserve(shadow_ray_count);
+    }
+
+    // follows every path to its end. each bounce intersects the active paths one by one and traces all of their
+    // shadow rays as one batch through the packet traversal
+    void Trace(PathState *paths, u32 path_count) noexcept {
+        for (u32 bounce = 0; bounce <= Features::MAX_BOUNCES; bounce++) {
+            m_shadow_rays.clear();
+            m_shadow_samples.clear();
+            bool active = false;
+            for (u32 i = 0; i < path_count; i++) {
+                if (paths[i].active) {
+                    Bounce(paths[i], i, bounce);
+                    active = true;
+                }
+            }
+            if (!active) {
+                break;
+            }
+            AddLightSamples(paths, path_count);
+        }
+    }
+
+  private:
+    static f32 GetMISWeight(f32 pdf, f32 other_pdf) noexcept {
+        if constexpr (Features::MIS_HEURISTIC == MISHeuristic::POWER) {
+            pdf *= pdf;
+            other_pdf *= other_pdf;
+        }
+        return pdf / (pdf + other_pdf);
+    }
+
+    // light sampling already counted the environment unless mis splits it with brdf sampling
+    static f32 GetEscapeWeight(u32 bounce, f32 brdf_pdf) noexcept {
+        if constexpr (Features::MULTIPLE_IMPORTANCE_SAMPLING) {
+            return bounce == 0 ? 1.0f : GetMISWeight(brdf_pdf, EnvironmentLight::GetPdf());
+        } else if constexpr (Features::NEXT_EVENT_ESTIMATION) {
+            return bounce == 0 ? 1.0f : 0.0f;
+        } else {
+            return 1.0f;
+        }
+    }
+
+    // intersects the path's ray, queues the shadow rays of its hit and samples the next direction
+    void Bounce(PathState &path, u32 path_index, u32 bounce) noexcept {
+        const Ray &ray = path.ray;
+        Intersection hit;
+        if (!m_bvh.Intersect(ray, hit)) {
+            if (!m_scene.environment.IsBlack()) {
+                path.radiance +=
+                    path.throughput * m_scene.environment.radiance * GetEscapeWeight(bounce, path.brdf_pdf);
+            }
+            path.active = false;
+            return;
+        }
+
+        const Mesh &mesh = m_meshes[hit.mesh];
+        u32 i0, i1, i2;
+        mesh.GetTriangleIndices(hit.triangle, i0, i1, i2);
+        const Math::float3 p0 = mesh.GetPosition(i0);
+        Math::float3 geometric_normal =
+            Math::Normalize(Math::Cross(mesh.GetPosition(i1) - p0, mesh.GetPosition(i2) - p0));
+        if (Math::Dot(geometric_normal, ray.direction) > 0.0f) {
+            geometric_normal = -geometric_normal;
+        }
+        // interpolated normals facing away from the ray fall back to the flat one
+        Math::float3 normal = mesh.Interpolate(hit.triangle, hit.b1, hit.b2).normal;
+        const f32 normal_length = Math::Length(normal);
+        normal = normal_length > 0.0f ? normal / normal_length : geometric_normal;
+        if (Math::Dot(normal, geometric_normal) <= 0.0f) {
+            normal = geometric_normal;
+        }
+
+        if constexpr (Features::AOVS != AOV_NONE) {
+            if (bounce == 0) {
+                path.aov.albedo = m_scene.material.albedo;
+                path.aov.normal = normal;
+                path.aov.depth = hit.t;
+            }
+        }
+        if (bounce == Features::MAX_BOUNCES) {
+            path.active = false;
+            return;
+        }
+
+        const Math::float3 origin = ray.At(hit.t) + geometric_normal * INTEGRATOR_RAY_OFFSET;
+        path.shaded = true;
+        path.shading_throughput = path.throughput;
+        path.delta_light = {};
+        path.environment_light = {};
+        // brdf sampling never hits a point or distant light, they are always sampled directly
+        SampleDeltaLights(path_index, origin, normal);
+        if constexpr (Features::NEXT_EVENT_ESTIMATION) {
+            SampleEnvironment(path_index, origin, normal, path.sampler);
+        }
+
+        const BRDFSample sample = m_scene.material.Sample(normal, path.sampler.Get2D());
+        if (sample.pdf <= 0.0f || Math::Dot(sample.direction, geometric_normal) <= 0.0f) {
+            path.active = false;
+            return;
+        }
+        path.throughput *= sample.weight;
+        path.brdf_pdf = sample.pdf;
+
+        if constexpr (Features::ROULETTE == RouletteMode::THROUGHPUT) {
+            if (bounce + 1 >= Features::ROULETTE_START_BOUNCE) {
+                const f32 survival = std::min(MaxComponent(path.throughput), 0.95f);
+                if (path.sampler.Get1D() >= survival) {
+                    path.active = false;
+                    return;
+                }
+                path.throughput /= survival;
+            }
+        }
+        path.ray = SpawnRay(ray, hit.t, origin, sample.direction, GetSurfaceSpread(1.0f));
+    }
+
+    void SampleDeltaLights(u32 path_index, const Math::float3 &origin, const Math::float3 &normal) noexcept {
+        for (u32 i = 0; i < m_scene.point_light_count; i++) {
+            QueueLightSample(path_index, false, origin, normal, m_scene.point_lights[i].Sample(origin), 1.0f);
+        }
+        for (u32 i = 0; i < m_scene.distant_light_count; i++) {
+            QueueLightSample(path_index, false, origin, normal, m_scene.distant_lights[i].Sample(origin), 1.0f);
+        }
+    }
+
+    void SampleEnvironment(u32 path_index, const Math::float3 &origin, const Math::float3 &normal,
+                           Sampler &sampler) noexcept {
+        if (m_scene.environment.IsBlack()) {
+            return;
+        }
+        const LightSample sample = m_scene.environment.Sample(origin, sampler.Get2D());
+        f32 weight = 1.0f;
+        if constexpr (Features::MULTIPLE_IMPORTANCE_SAMPLING) {
+            weight = GetMISWeight(sample.pdf, m_scene.material.GetPdf(normal, sample.direction));
+        }
+        QueueLightSample(path_index, true, origin, normal, sample, weight);
+    }
+
+    // queues the shadow ray of a light sample that contributes when unoccluded
+    void QueueLightSample(u32 path_index, bool environment, const Math::float3 &origin, const Math::float3 &normal,
+                          const LightSample &sample, f32 weight) noexcept {
+        const f32 cos_theta = Math::Dot(normal, sample.direction);
+        if (sample.pdf <= 0.0f || cos_theta <= 0.0f) {
+            return;
+        }
+        Ray shadow_ray{};
+        shadow_ray.origin = origin;
+        shadow_ray.direction = sample.direction;
+        shadow_ray.t_max = sample.distance * (1.0f - INTEGRATOR_RAY_OFFSET);
+        m_shadow_rays.push_back(shadow_ray);
+        const Math::float3 contribution =
+            m_scene.material.Evaluate(normal, sample.direction) * sample.radiance * (cos_theta / sample.pdf);
+        m_shadow_samples.push_back(ShadowSample{path_index, environment, contribution * weight});
+    }
+
+    // traces the queued shadow rays and adds the unoccluded samples, each path's in the order they were queued
+    void AddLightSamples(PathState *paths, u32 path_count) noexcept {
+        const u32 shadow_ray_count = static_cast<u32>(m_shadow_rays.size());
+        m_occluded.resize(shadow_ray_count);
+        m_bvh.Occluded(m_shadow_rays.data(), shadow_ray_count, m_occluded.data());
+        for (u32 i = 0; i < shadow_ray_count; i++) {
+            if (!m_occluded[i]) {
+                const ShadowSample &sample = m_shadow_samples[i];
+                PathState &path = paths[sample.path];
+                (sample.environment ? path.environment_light : path.delta_light) += sample.contribution;
+            }
+        }
+        for (u32 i = 0; i < path_count; i++) {
+            PathState &path = paths[i];
+            if (path.shaded) {
+                path.radiance += path.shading_throughput * path.delta_light;
+                if constexpr (Features::NEXT_EVENT_ESTIMATION) {
+                    path.radiance += path.shading_throughput * path.environment_light;
+                }
+                path.shaded = false;
+            }
+        }
+    }
+
+    const IntegratorScene &m_scene;
+    const BVH &m_bvh;
+    const Mesh *m_meshes;
+    Container::Array<Ray> m_shadow_rays;
+    Container::Array<ShadowSample> m_shadow_samples;
+    Container::Array<u8> m_occluded;
+};
+
+} // namespace
+
+template <typename Features>
+void PathIntegrator<Features>::RenderTile(const IntegratorScene &scene, const Camera &camera,
+                                          const IntegratorTile &tile, IntegratorTarget &target) {
+    const u32 tile_width = tile.x_end - tile.x_begin;
+    const u32 path_count = tile_width * (tile.y_end - tile.y_begin);
+    std::pmr::memory_resource *scratch = &Memory::GetLocalAllocator();
+    PathIntegratorImpl<Features> integrator(scene, scratch, path_count);
+    Container::Array<PathState> paths(scratch);
+    paths.reserve(path_count);
+    Container::Array<Math::float3> radiance(path_count, Math::float3{}, scratch);
+    Container::Array<PathAOV> aov_sums(Features::AOVS != AOV_NONE ? path_count : 0,
+                                       PathAOV{Math::float3{}, Math::float3{}, 0.0f}, scratch);
+    // one sample of every pixel in flight at a time, pixels add their samples in order
+    for (u32 s = 0; s < tile.sample_count; s++) {
+        paths.clear();
+        for (u32 y = tile.y_begin; y < tile.y_end; y++) {
+            for (u32 x = tile.x_begin; x < tile.x_end; x++) {
+                PathState &path = paths.emplace_back(y * target.width + x, s, tile.seed);
+                const Math::float2 jitter = path.sampler.Get2D();
+                path.ray = camera.GenerateRay(x + jitter.x, y + jitter.y);
+            }
+        }
+        integrator.Trace(paths.data(), path_count);
+        for (u32 i = 0; i < path_count; i++) {
+            radiance[i] += paths[i].radiance;
+            if constexpr (Features::AOVS != AOV_NONE) {
+                aov_sums[i].albedo += paths[i].aov.albedo;
+                aov_sums[i].normal += paths[i].aov.normal;
+                aov_sums[i].depth += paths[i].aov.depth;
+            }
+        }
+    }
+
+    const f32 inv_sample_count = 1.0f / static_cast<f32>(std::max(tile.sample_count, 1u));
+    for (u32 i = 0; i < path_count; i++) {
+        const u32 pixel = (tile.y_begin + i / tile_width) * target.width + tile.x_begin + i % tile_width;
+        target.radiance[pixel] = radiance[i] * inv_sample_count;
+        if constexpr ((Features::AOVS & AOV_ALBEDO) != 0) {
+            target.albedo[pixel] = aov_sums[i].albedo * inv_sample_count;
+        }
+        if constexpr ((Features::AOVS & AOV_NORMAL) != 0) {
+            target.normal[pixel] = aov_sums[i].normal * inv_sample_count;
+        }
+        if constexpr ((Features::AOVS & AOV_DEPTH) != 0) {
+            target.depth[pixel] = aov_sums[i].depth * inv_sample_count;
+        }
+    }
+}
+
+namespace {
+
+// same order as IntegratorVariant
+constexpr RenderTileFunction RENDER_TILE_FUNCTIONS[] = {
+    &PathIntegrator<PreviewPathFeatures>::RenderTile,
+    &PathIntegrator<FinalPathFeatures>::RenderTile,
+    &PathIntegrator<FinalAOVPathFeatures>::RenderTile,
+    &PathIntegrator<ReferencePathFeatures>::RenderTile,
+};
+static_assert(sizeof(RENDER_TILE_FUNCTIONS) / sizeof(RENDER_TILE_FUNCTIONS[0]) ==
+              static_cast<u32>(IntegratorVariant::COUNT));
+
+constexpr u32 RENDER_TILE_AOVS[] = {
+    PreviewPathFeatures::AOVS,
+    FinalPathFeatures::AOVS,
+    FinalAOVPathFeatures::AOVS,
+    ReferencePathFeatures::AOVS,
+};
+
+} // namespace
+
+RenderTileFunction GetRenderTileFunction(IntegratorVariant variant) noexcept {
+    const u32 index = static_cast<u32>(variant);
+    return index < static_cast<u32>(IntegratorVariant::COUNT) ? RENDER_TILE_FUNCTIONS[index] : nullptr;
+}
+
+void RenderImage(IntegratorVariant variant, const IntegratorScene &scene, const Camera &camera, u32 sample_count,
+                 u32 seed, IntegratorTarget &target) {
+    const RenderTileFunction render_tile = GetRenderTileFunction(variant);
+    if (!render_tile || !scene.scene || !target.radiance) {
+        LOG_ERROR("invalid integrator variant, scene or render target");
+        return;
+    }
+    const u32 aovs = RENDER_TILE_AOVS[static_cast<u32>(variant)];
+    if (((aovs & AOV_ALBEDO) && !target.albedo) || ((aovs & AOV_NORMAL) && !target.normal) ||
+        ((aovs & AOV_DEPTH) && !target.depth)) {
+        LOG_ERROR("integrator variant {} writes aov channels the render target doesn't have",
+                  static_cast<u32>(variant));
+        return;
+    }
+    const u32 tile_count_x = (target.width + INTEGRATOR_TILE_SIZE - 1) / INTEGRATOR_TILE_SIZE;
+    const u32 tile_count_y = (target.height + INTEGRATOR_TILE_SIZE - 1) / INTEGRATOR_TILE_SIZE;
+    Job::ParallelFor(0, static_cast<u64>(tile_count_x) * tile_count_y, 1, [&](u64 begin, u64 end) {
+        for (u64 index = begin; index < end; index++) {
+            IntegratorTile tile{};
+            tile.x_begin = static_cast<u32>(index % tile_count_x) * INTEGRATOR_TILE_SIZE;
+            tile.y_begin = static_cast<u32>(index / tile_count_x) * INTEGRATOR_TILE_SIZE;
+            tile.x_end = std::min(tile.x_begin + INTEGRATOR_TILE_SIZE, target.width);
+            tile.y_end = std::min(tile.y_begin + INTEGRATOR_TILE_SIZE, target.height);
+            tile.sample_count = sample_count;
+            tile.seed = seed;
+            // a marker rather than Reset(), the calling thread may hold arena memory of its own
+            Memory::LocalMemoryAllocator &arena = Memory::GetLocalAllocator();
+            const Memory::LocalMemoryAllocator::Marker marker = arena.GetMarker();
+            FRACT_TRACE_BEGIN(RENDER, "tile", tile.x_begin, tile.y_begin, sample_count);
+            render_tile(scene, camera, tile, target);
+            FRACT_TRACE_END(RENDER, "tile");
+            arena.Rewind(marker);
+        }
+    });
+}
+
+} // namespace Fract
@@ -0,0 +1,126 @@
+/*****************************************************************//**
+ * \file   path_integrator.h
+ * \brief  cpu path tracer specialized at compile time per feature set
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "camera/camera.h"
+#include "geometry/scene.h"
+#include "light/distant_light.h"
+#include "light/environment_light.h"
+#include "light/point_light.h"
+#include "materials/brdf.h"
+
+namespace Fract {
+
+enum class MISHeuristic : u8 { BALANCE, POWER };
+
+enum class RouletteMode : u8 {
+    NONE,
+    THROUGHPUT, // survive with the largest throughput component, at most 0.95
+};
+
+// channels written from the first hit besides radiance, for denoisers
+enum AOVFlags : u32 {
+    AOV_NONE = 0,
+    AOV_ALBEDO = 1 << 0,
+    AOV_NORMAL = 1 << 1,
+    AOV_DEPTH = 1 << 2,
+    AOV_ALL = AOV_ALBEDO | AOV_NORMAL | AOV_DEPTH,
+};
+
+// compile time configuration of a PathIntegrator. the bounce loop reads every member with if constexpr, so disabled
+// features cost nothing and the loop bound is a constant. derive from it and override what differs.
+struct PathFeatures {
+    static constexpr u32 MAX_BOUNCES = 8;
+    static constexpr bool NEXT_EVENT_ESTIMATION = true; // environment light sampling, delta lights always are
+    static constexpr bool MULTIPLE_IMPORTANCE_SAMPLING = true; // needs NEXT_EVENT_ESTIMATION
+    static constexpr MISHeuristic MIS_HEURISTIC = MISHeuristic::POWER;
+    static constexpr RouletteMode ROULETTE = RouletteMode::THROUGHPUT;
+    static constexpr u32 ROULETTE_START_BOUNCE = 3;
+    static constexpr u32 AOVS = AOV_NONE;
+};
+
+// interactive viewport
+struct PreviewPathFeatures : PathFeatures {
+    static constexpr u32 MAX_BOUNCES = 2;
+    static constexpr bool MULTIPLE_IMPORTANCE_SAMPLING = false;
+    static constexpr RouletteMode ROULETTE = RouletteMode::NONE;
+};
+
+struct FinalPathFeatures : PathFeatures {};
+
+struct FinalAOVPathFeatures : FinalPathFeatures {
+    static constexpr u32 AOVS = AOV_ALL;
+};
+
+// brdf sampling only for the environment, ground truth for the others. point and distant lights can't be hit by a
+// sampled direction, so they are still sampled directly.
+struct ReferencePathFeatures : PathFeatures {
+    static constexpr u32 MAX_BOUNCES = 64;
+    static constexpr bool NEXT_EVENT_ESTIMATION = false;
+    static constexpr bool MULTIPLE_IMPORTANCE_SAMPLING = false;
+};
+
+// the shipped configurations, one instantiation each
+enum class IntegratorVariant : u32 { PREVIEW, FINAL, FINAL_AOV, REFERENCE, COUNT };
+
+// lights are referenced, they must outlive the render
+struct IntegratorScene {
+    const Scene *scene{};
+    const PointLight *point_lights{};
+    u32 point_light_count{};
+    const DistantLight *distant_lights{};
+    u32 distant_light_count{};
+    EnvironmentLight environment{};
+    LambertBRDF material{Math::float3{0.5f}}; // every surface until materials are bound to meshes
+};
+
+// width * height pixels each, aov channels the variant doesn't write may be null
+struct IntegratorTarget {
+    u32 width{};
+    u32 height{};
+    Math::float3 *radiance{};
+    Math::float3 *albedo{};
+    Math::float3 *normal{};
+    f32 *depth{}; // camera ray distance, infinite for the background
+};
+
+// pixels [x_begin, x_end) x [y_begin, y_end), every pixel seeds its own random sequence so tiles can run in any order
+struct IntegratorTile {
+    u32 x_begin{};
+    u32 y_begin{};
+    u32 x_end{};
+    u32 y_end{};
+    u32 sample_count{1};
+    u32 seed{};
+};
+
+template <typename Features> class PathIntegrator {
+    static_assert(!Features::MULTIPLE_IMPORTANCE_SAMPLING || Features::NEXT_EVENT_ESTIMATION,
+                  "mis combines light and brdf sampling");
+
+  public:
+    // averages sample_count paths per pixel into the target. paths and shadow rays of the tile take scratch from
+    // the thread arena (Memory::GetLocalAllocator()), the caller rewinds it
+    static void RenderTile(const IntegratorScene &scene, const Camera &camera, const IntegratorTile &tile,
+                           IntegratorTarget &target);
+};
+
+using RenderTileFunction = void (*)(const IntegratorScene &, const Camera &, const IntegratorTile &,
+                                    IntegratorTarget &);
+
+// the instantiation of a variant, looked up once per render instead of testing flags per bounce
+RenderTileFunction GetRenderTileFunction(IntegratorVariant variant) noexcept;
+
+// renders the whole target in tiles on the job system. hosts trace a render by keeping a Trace::CaptureScope alive
+// around the call, each tile is a RENDER span. tiles take their scratch from the thread arena
+// (Memory::GetLocalAllocator()), which is rewound after every tile
+void RenderImage(IntegratorVariant variant, const IntegratorScene &scene, const Camera &camera, u32 sample_count,
+                 u32 seed, IntegratorTarget &target);
+
+} // namespace Fract
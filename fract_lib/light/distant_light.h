@@ -0,0 +1,29 @@
+/*****************************************************************//**
+ * \file   distant_light.h
+ * \brief  directional light at infinity, such as the sun
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "light.h"
+
+namespace Fract {
+
+struct DistantLight {
+    Math::float3 direction{0.0f, -1.0f, 0.0f}; // direction the light travels in, normalized
+    Math::float3 irradiance{};                 // W/m^2 on a surface facing the light
+
+    LightSample Sample(const Math::float3 &) const noexcept {
+        LightSample sample{};
+        sample.direction = -direction;
+        sample.radiance = irradiance;
+        sample.pdf = 1.0f;
+        sample.delta = true;
+        return sample;
+    }
+};
+
+} // namespace Fract
@@ -0,0 +1,37 @@
+/*****************************************************************//**
+ * \file   environment_light.h
+ * \brief  constant radiance from every direction
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "light.h"
+
+namespace Fract {
+
+// reached by escaping rays as well as sampled directly, the path integrator weights both with mis
+struct EnvironmentLight {
+    Math::float3 radiance{};
+
+    bool IsBlack() const noexcept { return radiance.x <= 0.0f && radiance.y <= 0.0f && radiance.z <= 0.0f; }
+
+    // uniform over the sphere, u in [0, 1)^2
+    LightSample Sample(const Math::float3 &, const Math::float2 &u) const noexcept {
+        const f32 z = 1.0f - 2.0f * u.x;
+        const f32 r = Math::Sqrt(std::max(0.0f, 1.0f - z * z));
+        f32 sin_phi, cos_phi;
+        Math::SinCos(Math::_2PI * u.y, sin_phi, cos_phi);
+        LightSample sample{};
+        sample.direction = Math::float3{r * cos_phi, r * sin_phi, z};
+        sample.radiance = radiance;
+        sample.pdf = GetPdf();
+        return sample;
+    }
+
+    static constexpr f32 GetPdf() noexcept { return 0.25f * Math::_1DIVPI; }
+};
+
+} // namespace Fract
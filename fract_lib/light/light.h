@@ -0,0 +1,28 @@
+/*****************************************************************//**
+ * \file   light.h
+ * \brief  light sample shared by the light types
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <limits>
+
+#include "utils/defination.h"
+#include "utils/math/Math.h"
+
+namespace Fract {
+
+// incident radiance towards a shading point. delta lights (point, distant) have pdf 1 and can't be hit by bsdf rays,
+// distance is infinite for lights at infinity.
+struct LightSample {
+    Math::float3 direction{}; // from the shading point towards the light, normalized
+    f32 distance{std::numeric_limits<f32>::infinity()};
+    Math::float3 radiance{};
+    f32 pdf{}; // solid angle, 0 for an invalid sample
+    bool delta{};
+};
+
+} // namespace Fract
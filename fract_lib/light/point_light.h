@@ -0,0 +1,35 @@
+/*****************************************************************//**
+ * \file   point_light.h
+ * \brief  isotropic point light
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "light.h"
+
+namespace Fract {
+
+struct PointLight {
+    Math::float3 position{};
+    Math::float3 intensity{}; // radiant intensity, W/sr
+
+    LightSample Sample(const Math::float3 &point) const noexcept {
+        LightSample sample{};
+        const Math::float3 to_light = position - point;
+        const f32 distance_squared = to_light.LengthSquared();
+        if (distance_squared <= 0.0f) {
+            return sample;
+        }
+        sample.distance = std::sqrt(distance_squared);
+        sample.direction = to_light / sample.distance;
+        sample.radiance = intensity / distance_squared;
+        sample.pdf = 1.0f;
+        sample.delta = true;
+        return sample;
+    }
+};
+
+} // namespace Fract
@@ -1,18 +1,62 @@
+/*****************************************************************//**
+ * \file   brdf.h
+ * \brief  lambertian brdf in a local shading frame
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
 #pragma once
 
-class brdf
-{
-private:
-    /* data */
-public:
-    brdf(/* args */);
-    ~brdf();
-};
+#include <algorithm>
+#include <cmath>
 
-brdf::brdf(/* args */)
-{
-}
+#include "utils/defination.h"
+#include "utils/math/Math.h"
 
-brdf::~brdf()
-{
+namespace Fract {
+
+// orthonormal tangent and bitangent of a unit normal, duff et al. 2017
+inline void BuildBasis(const Math::float3 &n, Math::float3 &t, Math::float3 &b) noexcept {
+    const f32 sign = std::copysign(1.0f, n.z);
+    const f32 a = -1.0f / (sign + n.z);
+    const f32 c = n.x * n.y * a;
+    t = Math::float3{1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x};
+    b = Math::float3{c, sign + n.y * n.y * a, -n.y};
 }
+
+struct BRDFSample {
+    Math::float3 direction{};
+    Math::float3 weight{}; // brdf * cos / pdf
+    f32 pdf{};
+};
+
+struct LambertBRDF {
+    Math::float3 albedo{};
+
+    // n is the shading normal facing the outgoing direction
+    Math::float3 Evaluate(const Math::float3 &n, const Math::float3 &wi) const noexcept {
+        return Math::Dot(n, wi) > 0.0f ? albedo * Math::_1DIVPI : Math::float3{};
+    }
+
+    f32 GetPdf(const Math::float3 &n, const Math::float3 &wi) const noexcept {
+        return std::max(Math::Dot(n, wi), 0.0f) * Math::_1DIVPI;
+    }
+
+    // cosine weighted hemisphere, u in [0, 1)^2
+    BRDFSample Sample(const Math::float3 &n, const Math::float2 &u) const noexcept {
+        const f32 r = Math::Sqrt(u.x);
+        const f32 z = Math::Sqrt(std::max(0.0f, 1.0f - u.x));
+        f32 sin_phi, cos_phi;
+        Math::SinCos(Math::_2PI * u.y, sin_phi, cos_phi);
+        Math::float3 t, b;
+        BuildBasis(n, t, b);
+        BRDFSample sample{};
+        sample.direction = t * (r * cos_phi) + b * (r * sin_phi) + n * z;
+        sample.weight = albedo;
+        sample.pdf = z * Math::_1DIVPI;
+        return sample;
+    }
+};
+
+} // namespace Fract
@@ -0,0 +1,559 @@
+/*****************************************************************//**
+ * \file   bvh.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <numeric>
+
+#include "utils/job/Parallel.h"
+
+namespace Fract {
+
+namespace {
+
+// nodes with at least this many primitives bound and bin their primitives in parallel blocks
+constexpr u32 BVH_PARALLEL_NODE_SIZE = 1u << 16;
+constexpr u64 BVH_PARALLEL_GRAIN_SIZE = 1u << 14;
+
+constexpr u32 BVH_PACKET_SIZE = Math::f32x8::WIDTH; // shadow rays traversed together
+constexpr u32 BVH_PACKET_BATCH_SIZE = 256;          // shadow rays sorted by direction at a time
+
+struct BuildTask {
+    u32 node;
+    u32 begin;
+    u32 end;
+    u32 depth;
+};
+
+// primitive and centroid bounds of a node
+struct NodeBounds {
+    Math::float3 bounds_min{std::numeric_limits<f32>::max()};
+    Math::float3 bounds_max{-std::numeric_limits<f32>::max()};
+    Math::float3 centroid_min{std::numeric_limits<f32>::max()};
+    Math::float3 centroid_max{-std::numeric_limits<f32>::max()};
+};
+
+struct Bins {
+    Bins() noexcept {
+        bounds_min.fill(Math::float3{std::numeric_limits<f32>::max()});
+        bounds_max.fill(Math::float3{-std::numeric_limits<f32>::max()});
+    }
+
+    Container::FixedArray<u32, BVH_BIN_COUNT> count{};
+    Container::FixedArray<Math::float3, BVH_BIN_COUNT> bounds_min;
+    Container::FixedArray<Math::float3, BVH_BIN_COUNT> bounds_max;
+};
+
+NodeBounds MergeBounds(const NodeBounds &lhs, const NodeBounds &rhs) {
+    return NodeBounds{Math::Min(lhs.bounds_min, rhs.bounds_min), Math::Max(lhs.bounds_max, rhs.bounds_max),
+                      Math::Min(lhs.centroid_min, rhs.centroid_min), Math::Max(lhs.centroid_max, rhs.centroid_max)};
+}
+
+Bins MergeBins(const Bins &lhs, const Bins &rhs) {
+    Bins bins;
+    for (u32 i = 0; i < BVH_BIN_COUNT; i++) {
+        bins.count[i] = lhs.count[i] + rhs.count[i];
+        bins.bounds_min[i] = Math::Min(lhs.bounds_min[i], rhs.bounds_min[i]);
+        bins.bounds_max[i] = Math::Max(lhs.bounds_max[i], rhs.bounds_max[i]);
+    }
+    return bins;
+}
+
+f32 HalfArea(const Math::float3 &bounds_min, const Math::float3 &bounds_max) {
+    const Math::float3 d = bounds_max - bounds_min;
+    return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+// any-hit traversal of up to BVH_PACKET_SIZE rays at once. a node is entered when any ray still unoccluded hits it,
+// the lanes that hit travel along on the stack so leaves only test those. without ordering there is no per ray state
+// besides the lane masks.
+struct RayPacket {
+    alignas(32) f32 origin_x[BVH_PACKET_SIZE];
+    alignas(32) f32 origin_y[BVH_PACKET_SIZE];
+    alignas(32) f32 origin_z[BVH_PACKET_SIZE];
+    alignas(32) f32 inv_direction_x[BVH_PACKET_SIZE];
+    alignas(32) f32 inv_direction_y[BVH_PACKET_SIZE];
+    alignas(32) f32 inv_direction_z[BVH_PACKET_SIZE];
+    alignas(32) f32 t_min[BVH_PACKET_SIZE];
+    alignas(32) f32 t_max[BVH_PACKET_SIZE];
+};
+
+// Min() and Max() return their second operand for nan, so a lane whose slab is nan keeps its interval. that only
+// ever enters more nodes than IntersectBounds() does, the triangle tests decide.
+void IntersectSlab(const f32 *origin, const f32 *inv_direction, f32 bounds_min, f32 bounds_max, Math::f32x8 &t_near,
+                   Math::f32x8 &t_far) noexcept {
+    const Math::f32x8 o = Math::f32x8::Load(origin);
+    const Math::f32x8 inv = Math::f32x8::Load(inv_direction);
+    const Math::f32x8 t0 = (Math::f32x8(bounds_min) - o) * inv;
+    const Math::f32x8 t1 = (Math::f32x8(bounds_max) - o) * inv;
+    t_near = Math::Max(Math::Min(t0, t1), t_near);
+    t_far = Math::Min(Math::Max(t0, t1), t_far);
+}
+
+// lane mask of the rays overlapping the node bounds
+u32 IntersectBounds(const BVHNode &node, const RayPacket &packet) noexcept {
+    Math::f32x8 t_near = Math::f32x8::Load(packet.t_min);
+    Math::f32x8 t_far = Math::f32x8::Load(packet.t_max);
+    IntersectSlab(packet.origin_x, packet.inv_direction_x, node.bounds_min.x, node.bounds_max.x, t_near, t_far);
+    IntersectSlab(packet.origin_y, packet.inv_direction_y, node.bounds_min.y, node.bounds_max.y, t_near, t_far);
+    IntersectSlab(packet.origin_z, packet.inv_direction_z, node.bounds_min.z, node.bounds_max.z, t_near, t_far);
+    return Math::MoveMask(t_near <= t_far);
+}
+
+void OccludedPacket(const BVHNode *nodes, const BVHPrimitive *primitives, const Mesh *meshes, const Ray *rays,
+                    const u32 *indices, u32 count, u8 *occluded) noexcept {
+    // unused lanes repeat the last ray and are never active
+    RayPacket packet;
+    for (u32 lane = 0; lane < BVH_PACKET_SIZE; lane++) {
+        const Ray &ray = rays[indices[std::min(lane, count - 1)]];
+        packet.origin_x[lane] = ray.origin.x;
+        packet.origin_y[lane] = ray.origin.y;
+        packet.origin_z[lane] = ray.origin.z;
+        packet.inv_direction_x[lane] = 1.0f / ray.direction.x;
+        packet.inv_direction_y[lane] = 1.0f / ray.direction.y;
+        packet.inv_direction_z[lane] = 1.0f / ray.direction.z;
+        packet.t_min[lane] = ray.t_min;
+        packet.t_max[lane] = ray.t_max;
+    }
+
+    struct StackEntry {
+        u32 node;
+        u32 lanes;
+    };
+    Container::FixedArray<StackEntry, BVH_MAX_DEPTH> stack;
+    u32 stack_size = 0;
+    u32 active = (1u << count) - 1; // lanes not occluded yet
+    u32 node_index = 0;
+    u32 lanes = IntersectBounds(nodes[0], packet) & active;
+
+    while (lanes) {
+        const BVHNode &node = nodes[node_index];
+        if (node.primitive_count > 0) {
+            for (u32 i = 0; i < node.primitive_count && (lanes & active); i++) {
+                const BVHPrimitive &primitive = primitives[node.left_or_first + i];
+                const Mesh &mesh = meshes[primitive.mesh];
+                u32 i0, i1, i2;
+                mesh.GetTriangleIndices(primitive.triangle, i0, i1, i2);
+                const Math::float3 p0 = mesh.GetPosition(i0);
+                const Math::float3 p1 = mesh.GetPosition(i1);
+                const Math::float3 p2 = mesh.GetPosition(i2);
+                const u32 testing = lanes & active;
+                for (u32 lane = 0; lane < count; lane++) {
+                    if (!((testing >> lane) & 1u)) {
+                        continue;
+                    }
+                    const Ray &ray = rays[indices[lane]];
+                    f32 t, b1, b2;
+                    if (IntersectTriangle(ray, ray.t_max, p0, p1, p2, t, b1, b2)) {
+                        active &= ~(1u << lane);
+                    }
+                }
+            }
+            if (!active) {
+                break;
+            }
+        } else {
+            const u32 left = node.left_or_first;
+            const u32 right = left + 1;
+            const u32 left_lanes = IntersectBounds(nodes[left], packet) & lanes & active;
+            const u32 right_lanes = IntersectBounds(nodes[right], packet) & lanes & active;
+            if (left_lanes && right_lanes) {
+                stack[stack_size++] = StackEntry{right, right_lanes};
+                node_index = left;
+                lanes = left_lanes;
+                continue;
+            }
+            if (left_lanes || right_lanes) {
+                node_index = left_lanes ? left : right;
+                lanes = left_lanes ? left_lanes : right_lanes;
+                continue;
+            }
+        }
+        // skip entries whose rays all got occluded since they were pushed
+        lanes = 0;
+        while (stack_size > 0 && !lanes) {
+            const StackEntry &entry = stack[--stack_size];
+            node_index = entry.node;
+            lanes = entry.lanes & active;
+        }
+    }
+
+    for (u32 lane = 0; lane < count; lane++) {
+        occluded[indices[lane]] = (active >> lane) & 1u ? 0 : 1;
+    }
+}
+
+} // namespace
+
+BVH::BVH(std::pmr::memory_resource *resource) noexcept : m_nodes(resource), m_primitives(resource) {}
+
+BVH::~BVH() noexcept {}
+
+void BVH::Build(const Mesh *meshes, u32 mesh_count) {
+    m_meshes = meshes;
+    m_mesh_count = mesh_count;
+    m_node_replicas.Clear();
+    m_primitive_replicas.Clear();
+    auto *resource = m_nodes.get_allocator().resource();
+
+    // first primitive of every mesh
+    Container::Array<u32> mesh_offsets(mesh_count, resource);
+    for (u32 m = 0; m < mesh_count; m++) {
+        mesh_offsets[m] = meshes[m].GetTriangleCount();
+    }
+    const u32 primitive_count =
+        Job::ParallelScan(mesh_offsets.data(), mesh_offsets.data(), mesh_count, 0, 0u, std::plus<u32>());
+    m_nodes.clear();
+    m_primitives.resize(primitive_count);
+    if (primitive_count == 0) {
+        return;
+    }
+
+    Container::Array<Math::float3> primitive_min(primitive_count, resource);
+    Container::Array<Math::float3> primitive_max(primitive_count, resource);
+    Container::Array<Math::float3> centroids(primitive_count, resource);
+    Job::ParallelFor(0, primitive_count, 0, [&](u64 begin, u64 end) {
+        const auto first_mesh = std::upper_bound(mesh_offsets.begin(), mesh_offsets.end(), begin) - 1;
+        u32 m = static_cast<u32>(first_mesh - mesh_offsets.begin());
+        for (u32 p = static_cast<u32>(begin); p < end; p++) {
+            while (m + 1 < mesh_count && mesh_offsets[m + 1] <= p) {
+                m++;
+            }
+            const Mesh &mesh = meshes[m];
+            const u32 t = p - mesh_offsets[m];
+            u32 i0, i1, i2;
+            mesh.GetTriangleIndices(t, i0, i1, i2);
+            const Math::float3 p0 = mesh.GetPosition(i0);
+            const Math::float3 p1 = mesh.GetPosition(i1);
+            const Math::float3 p2 = mesh.GetPosition(i2);
+            m_primitives[p] = BVHPrimitive{m, t};
+            primitive_min[p] = Math::Min(Math::Min(p0, p1), p2);
+            primitive_max[p] = Math::Max(Math::Max(p0, p1), p2);
+            centroids[p] = (primitive_min[p] + primitive_max[p]) * 0.5f;
+        }
+    });
+
+    Container::Array<u32> order(primitive_count, resource);
+    std::iota(order.begin(), order.end(), 0u);
+
+    // a binary tree with leaves of at least one primitive never needs more
+    m_nodes.resize(static_cast<size_t>(primitive_count) * 2 - 1);
+    u32 node_count = 1;
+
+    Container::Array<BuildTask> tasks(resource);
+    tasks.push_back(BuildTask{0, 0, primitive_count, 0});
+
+    while (!tasks.empty()) {
+        const BuildTask task = tasks.back();
+        tasks.pop_back();
+        BVHNode &node = m_nodes[task.node];
+
+        // nodes near the root are scanned in parallel, smaller ones in a single block
+        const u32 count = task.end - task.begin;
+        const u64 grain_size = count >= BVH_PARALLEL_NODE_SIZE ? BVH_PARALLEL_GRAIN_SIZE : count;
+
+        const NodeBounds bounds = Job::ParallelReduce(
+            task.begin, task.end, grain_size, NodeBounds{},
+            [&](u64 begin, u64 end, NodeBounds partial) {
+                for (u64 i = begin; i < end; i++) {
+                    const u32 p = order[i];
+                    partial.bounds_min = Math::Min(partial.bounds_min, primitive_min[p]);
+                    partial.bounds_max = Math::Max(partial.bounds_max, primitive_max[p]);
+                    partial.centroid_min = Math::Min(partial.centroid_min, centroids[p]);
+                    partial.centroid_max = Math::Max(partial.centroid_max, centroids[p]);
+                }
+                return partial;
+            },
+            MergeBounds);
+        const Math::float3 &centroid_min = bounds.centroid_min;
+        const Math::float3 &centroid_max = bounds.centroid_max;
+        node.bounds_min = bounds.bounds_min;
+        node.bounds_max = bounds.bounds_max;
+
+        if (count <= BVH_MAX_LEAF_SIZE) {
+            node.left_or_first = task.begin;
+            node.primitive_count = count;
+            continue;
+        }
+
+        // binned sah, the deepest half of the depth budget is reserved for
+        // median splits so traversal stacks never overflow
+        u32 split_axis = ~0u;
+        u32 split_bin = 0;
+        if (task.depth < BVH_MAX_DEPTH / 2) {
+            f32 best_cost = std::numeric_limits<f32>::max();
+            for (u32 axis = 0; axis < 3; axis++) {
+                const f32 lo = Math::GetComponent(centroid_min, axis);
+                const f32 extent = Math::GetComponent(centroid_max, axis) - lo;
+                if (extent <= 0.0f) {
+                    continue;
+                }
+                const f32 scale = BVH_BIN_COUNT / extent;
+
+                const Bins bins = Job::ParallelReduce(
+                    task.begin, task.end, grain_size, Bins{},
+                    [&](u64 begin, u64 end, Bins partial) {
+                        for (u64 i = begin; i < end; i++) {
+                            const u32 p = order[i];
+                            const u32 bin =
+                                std::min(BVH_BIN_COUNT - 1,
+                                         static_cast<u32>((Math::GetComponent(centroids[p], axis) - lo) * scale));
+                            partial.count[bin]++;
+                            partial.bounds_min[bin] = Math::Min(partial.bounds_min[bin], primitive_min[p]);
+                            partial.bounds_max[bin] = Math::Max(partial.bounds_max[bin], primitive_max[p]);
+                        }
+                        return partial;
+                    },
+                    MergeBins);
+                const auto &bin_count = bins.count;
+                const auto &bin_min = bins.bounds_min;
+                const auto &bin_max = bins.bounds_max;
+
+                Container::FixedArray<f32, BVH_BIN_COUNT - 1> right_area{};
+                Container::FixedArray<u32, BVH_BIN_COUNT - 1> right_count{};
+                Math::float3 acc_min = bin_min[BVH_BIN_COUNT - 1];
+                Math::float3 acc_max = bin_max[BVH_BIN_COUNT - 1];
+                u32 acc_count = bin_count[BVH_BIN_COUNT - 1];
+                for (u32 i = BVH_BIN_COUNT - 1; i > 0; i--) {
+                    right_area[i - 1] = acc_count > 0 ? HalfArea(acc_min, acc_max) : 0.0f;
+                    right_count[i - 1] = acc_count;
+                    acc_min = Math::Min(acc_min, bin_min[i - 1]);
+                    acc_max = Math::Max(acc_max, bin_max[i - 1]);
+                    acc_count += bin_count[i - 1];
+                }
+
+                acc_min = bin_min[0];
+                acc_max = bin_max[0];
+                acc_count = 0;
+                for (u32 i = 0; i < BVH_BIN_COUNT - 1; i++) {
+                    acc_min = Math::Min(acc_min, bin_min[i]);
+                    acc_max = Math::Max(acc_max, bin_max[i]);
+                    acc_count += bin_count[i];
+                    if (acc_count == 0 || right_count[i] == 0) {
+                        continue;
+                    }
+                    const f32 cost = acc_count * HalfArea(acc_min, acc_max) + right_count[i] * right_area[i];
+                    if (cost < best_cost) {
+                        best_cost = cost;
+                        split_axis = axis;
+                        split_bin = i;
+                    }
+                }
+            }
+        }
+
+        u32 mid = task.begin;
+        if (split_axis != ~0u) {
+            const f32 lo = Math::GetComponent(centroid_min, split_axis);
+            const f32 scale = BVH_BIN_COUNT / (Math::GetComponent(centroid_max, split_axis) - lo);
+            mid = static_cast<u32>(
+                std::partition(order.begin() + task.begin, order.begin() + task.end,
+                               [&](u32 p) {
+                                   const u32 bin = std::min(
+                                       BVH_BIN_COUNT - 1,
+                                       static_cast<u32>((Math::GetComponent(centroids[p], split_axis) - lo) * scale));
+                                   return bin <= split_bin;
+                               }) -
+                order.begin());
+        }
+        if (split_axis == ~0u || mid == task.begin || mid == task.end) {
+            // object median along the widest centroid axis
+            const Math::float3 extent = centroid_max - centroid_min;
+            const u32 axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+            mid = (task.begin + task.end) / 2;
+            std::nth_element(order.begin() + task.begin, order.begin() + mid, order.begin() + task.end,
+                             [&](u32 a, u32 b) {
+                                 return Math::GetComponent(centroids[a], axis) <
+                                        Math::GetComponent(centroids[b], axis);
+                             });
+        }
+
+        node.left_or_first = node_count;
+        node.primitive_count = 0;
+        tasks.push_back(BuildTask{node_count, task.begin, mid, task.depth + 1});
+        tasks.push_back(BuildTask{node_count + 1, mid, task.end, task.depth + 1});
+        node_count += 2;
+    }
+    m_nodes.resize(node_count);
+    m_nodes.shrink_to_fit();
+
+    // leaves reference contiguous ranges of the primitive array
+    Container::Array<BVHPrimitive> ordered(primitive_count, resource);
+    for (u32 i = 0; i < primitive_count; i++) {
+        ordered[i] = m_primitives[order[i]];
+    }
+    m_primitives.swap(ordered);
+}
+
+void BVH::ReplicateAcrossNumaNodes() {
+    m_node_replicas.Replicate(m_nodes.data(), m_nodes.size());
+    m_primitive_replicas.Replicate(m_primitives.data(), m_primitives.size());
+    for (u32 m = 0; m < m_mesh_count; m++) {
+        m_meshes[m].ReplicateAcrossNumaNodes();
+    }
+}
+
+bool BVH::Intersect(const Ray &ray, Intersection &intersection) const noexcept {
+    if (m_nodes.empty()) {
+        return false;
+    }
+    const BVHNode *nodes = m_node_replicas.Get(m_nodes.data());
+    const BVHPrimitive *primitives = m_primitive_replicas.Get(m_primitives.data());
+    const Math::float3 inv_direction{1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    f32 t_max = ray.t_max;
+    f32 t_enter;
+    if (!IntersectBounds(nodes[0].bounds_min, nodes[0].bounds_max, ray.origin, inv_direction, ray.t_min, t_max,
+                         t_enter)) {
+        return false;
+    }
+
+    bool hit = false;
+    Container::FixedArray<u32, BVH_MAX_DEPTH> stack;
+    u32 stack_size = 0;
+    u32 node_index = 0;
+
+    while (true) {
+        const BVHNode &node = nodes[node_index];
+        if (node.primitive_count > 0) {
+            for (u32 i = 0; i < node.primitive_count; i++) {
+                const BVHPrimitive &primitive = primitives[node.left_or_first + i];
+                const Mesh &mesh = m_meshes[primitive.mesh];
+                u32 i0, i1, i2;
+                mesh.GetTriangleIndices(primitive.triangle, i0, i1, i2);
+                f32 t, b1, b2;
+                if (IntersectTriangle(ray, t_max, mesh.GetPosition(i0), mesh.GetPosition(i1), mesh.GetPosition(i2),
+                                      t, b1, b2)) {
+                    t_max = t;
+                    intersection.t = t;
+                    intersection.mesh = primitive.mesh;
+                    intersection.triangle = primitive.triangle;
+                    intersection.b1 = b1;
+                    intersection.b2 = b2;
+                    hit = true;
+                }
+            }
+        } else {
+            const u32 left = node.left_or_first;
+            const u32 right = left + 1;
+            f32 t_left, t_right;
+            const bool hit_left = IntersectBounds(nodes[left].bounds_min, nodes[left].bounds_max, ray.origin,
+                                                  inv_direction, ray.t_min, t_max, t_left);
+            const bool hit_right = IntersectBounds(nodes[right].bounds_min, nodes[right].bounds_max, ray.origin,
+                                                   inv_direction, ray.t_min, t_max, t_right);
+            if (hit_left && hit_right) {
+                // front to back so t_max shrinks as early as possible
+                const bool left_first = t_left <= t_right;
+                stack[stack_size++] = left_first ? right : left;
+                node_index = left_first ? left : right;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? left : right;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    return hit;
+}
+
+bool BVH::Occluded(const Ray &ray) const noexcept {
+    if (m_nodes.empty()) {
+        return false;
+    }
+    const BVHNode *nodes = m_node_replicas.Get(m_nodes.data());
+    const BVHPrimitive *primitives = m_primitive_replicas.Get(m_primitives.data());
+    const Math::float3 inv_direction{1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z};
+    f32 t_enter;
+    if (!IntersectBounds(nodes[0].bounds_min, nodes[0].bounds_max, ray.origin, inv_direction, ray.t_min,
+                         ray.t_max, t_enter)) {
+        return false;
+    }
+
+    Container::FixedArray<u32, BVH_MAX_DEPTH> stack;
+    u32 stack_size = 0;
+    u32 node_index = 0;
+
+    while (true) {
+        const BVHNode &node = nodes[node_index];
+        if (node.primitive_count > 0) {
+            for (u32 i = 0; i < node.primitive_count; i++) {
+                const BVHPrimitive &primitive = primitives[node.left_or_first + i];
+                const Mesh &mesh = m_meshes[primitive.mesh];
+                u32 i0, i1, i2;
+                mesh.GetTriangleIndices(primitive.triangle, i0, i1, i2);
+                f32 t, b1, b2;
+                if (IntersectTriangle(ray, ray.t_max, mesh.GetPosition(i0), mesh.GetPosition(i1),
+                                      mesh.GetPosition(i2), t, b1, b2)) {
+                    return true;
+                }
+            }
+        } else {
+            // t_max never shrinks, so there is nothing to gain from visiting
+            // the nearer child first
+            const u32 left = node.left_or_first;
+            const u32 right = left + 1;
+            const bool hit_left = IntersectBounds(nodes[left].bounds_min, nodes[left].bounds_max, ray.origin,
+                                                  inv_direction, ray.t_min, ray.t_max, t_enter);
+            const bool hit_right = IntersectBounds(nodes[right].bounds_min, nodes[right].bounds_max, ray.origin,
+                                                   inv_direction, ray.t_min, ray.t_max, t_enter);
+            if (hit_left && hit_right) {
+                stack[stack_size++] = right;
+                node_index = left;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_index = hit_left ? left : right;
+                continue;
+            }
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_index = stack[--stack_size];
+    }
+    return false;
+}
+
+void BVH::Occluded(const Ray *rays, u32 ray_count, u8 *occluded) const noexcept {
+    if (m_nodes.empty()) {
+        std::fill_n(occluded, ray_count, u8{0});
+        return;
+    }
+    const BVHNode *nodes = m_node_replicas.Get(m_nodes.data());
+    const BVHPrimitive *primitives = m_primitive_replicas.Get(m_primitives.data());
+
+    // packets of rays pointing the same way share more of their traversal, group every batch by direction signs
+    Container::FixedArray<u32, BVH_PACKET_BATCH_SIZE> order;
+    Container::FixedArray<u8, BVH_PACKET_BATCH_SIZE> octants;
+    for (u32 begin = 0; begin < ray_count; begin += BVH_PACKET_BATCH_SIZE) {
+        const u32 count = std::min(BVH_PACKET_BATCH_SIZE, ray_count - begin);
+        Container::FixedArray<u32, 9> offsets{};
+        for (u32 i = 0; i < count; i++) {
+            const Math::float3 &direction = rays[begin + i].direction;
+            octants[i] = static_cast<u8>((direction.x < 0.0f) | (direction.y < 0.0f) << 1 | (direction.z < 0.0f) << 2);
+            offsets[octants[i] + 1]++;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for (u32 i = 0; i < count; i++) {
+            order[offsets[octants[i]]++] = begin + i;
+        }
+        for (u32 first = 0; first < count; first += BVH_PACKET_SIZE) {
+            OccludedPacket(nodes, primitives, m_meshes, rays, &order[first], std::min(BVH_PACKET_SIZE, count - first),
+                           occluded);
+        }
+    }
+}
+
+} // namespace Fract
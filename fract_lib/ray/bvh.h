@@ -0,0 +1,75 @@
+/*****************************************************************//**
+ * \file   bvh.h
+ * \brief  binned sah bvh over the triangles of a set of meshes
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "geometry/mesh.h"
+#include "intersection.h"
+#include "utils/memory/Numa.h"
+
+namespace Fract {
+
+static constexpr u32 BVH_BIN_COUNT = 16;
+static constexpr u32 BVH_MAX_LEAF_SIZE = 4;
+static constexpr u32 BVH_MAX_DEPTH = 64;
+
+// 32 bytes, two nodes per cache line
+struct alignas(32) BVHNode {
+    Math::float3 bounds_min{};
+    u32 left_or_first{}; // left child for interior nodes, right child is left + 1
+    Math::float3 bounds_max{};
+    u32 primitive_count{}; // 0 for interior nodes
+};
+
+static_assert(sizeof(BVHNode) == 32);
+
+struct BVHPrimitive {
+    u32 mesh;
+    u32 triangle;
+};
+
+class BVH {
+  public:
+    BVH(std::pmr::memory_resource *resource = Memory::GetGlobalAllocator(Memory::MemoryTag::ACCELERATION)) noexcept;
+    ~BVH() noexcept;
+
+    BVH(const BVH &rhs) noexcept = delete;
+    BVH &operator=(const BVH &rhs) noexcept = delete;
+    BVH(BVH &&rhs) noexcept = default;
+    BVH &operator=(BVH &&rhs) = default;
+
+    // meshes must outlive the bvh and keep their storage
+    void Build(const Mesh *meshes, u32 mesh_count);
+
+    // copy nodes, primitives and the indices and positions of the meshes to
+    // every numa node, threads bound to a node traverse their local copy.
+    // no-op on single node machines
+    void ReplicateAcrossNumaNodes();
+
+    // closest hit
+    bool Intersect(const Ray &ray, Intersection &intersection) const noexcept;
+
+    // any hit in (t_min, t_max), for shadow rays
+    bool Occluded(const Ray &ray) const noexcept;
+    // occluded[i] is set to 1 if rays[i] hits anything, 0 otherwise
+    void Occluded(const Ray *rays, u32 ray_count, u8 *occluded) const noexcept;
+
+    u32 GetNodeCount() const noexcept { return static_cast<u32>(m_nodes.size()); }
+    u32 GetPrimitiveCount() const noexcept { return static_cast<u32>(m_primitives.size()); }
+
+  private:
+    const Mesh *m_meshes{};
+    u32 m_mesh_count{};
+
+    Container::Array<BVHNode> m_nodes;
+    Container::Array<BVHPrimitive> m_primitives;
+    Memory::NumaReplicatedArray<BVHNode> m_node_replicas;
+    Memory::NumaReplicatedArray<BVHPrimitive> m_primitive_replicas;
+};
+
+} // namespace Fract
@@ -0,0 +1,79 @@
+/*****************************************************************//**
+ * \file   intersection.h
+ * \brief  ray-primitive intersection routines
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cmath>
+
+#include "ray.h"
+
+namespace Fract {
+
+static constexpr u32 INVALID_PRIMITIVE = ~0u;
+
+// closest hit record, attributes are interpolated later from the barycentrics
+struct Intersection {
+    f32 t{std::numeric_limits<f32>::infinity()};
+    u32 mesh{INVALID_PRIMITIVE};
+    u32 triangle{INVALID_PRIMITIVE};
+    f32 b1{}, b2{};
+
+    bool IsValid() const noexcept { return triangle != INVALID_PRIMITIVE; }
+};
+
+// moller-trumbore, hits in (ray.t_min, t_max) only
+inline bool IntersectTriangle(const Ray &ray, f32 t_max, const Math::float3 &p0, const Math::float3 &p1,
+                              const Math::float3 &p2, f32 &t, f32 &b1, f32 &b2) noexcept {
+    const Math::float3 e1 = p1 - p0;
+    const Math::float3 e2 = p2 - p0;
+    const Math::float3 pvec = Math::Cross(ray.direction, e2);
+    const f32 det = Math::Dot(e1, pvec);
+    if (det == 0.0f) {
+        return false;
+    }
+    const f32 inv_det = 1.0f / det;
+    const Math::float3 tvec = ray.origin - p0;
+    const f32 u = Math::Dot(tvec, pvec) * inv_det;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    const Math::float3 qvec = Math::Cross(tvec, e1);
+    const f32 v = Math::Dot(ray.direction, qvec) * inv_det;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    const f32 distance = Math::Dot(e2, qvec) * inv_det;
+    if (distance <= ray.t_min || distance >= t_max) {
+        return false;
+    }
+    t = distance;
+    b1 = u;
+    b2 = v;
+    return true;
+}
+
+// slab test, returns the entry distance in t_enter
+inline bool IntersectBounds(const Math::float3 &bounds_min, const Math::float3 &bounds_max,
+                            const Math::float3 &origin, const Math::float3 &inv_direction, f32 t_min, f32 t_max,
+                            f32 &t_enter) noexcept {
+    const f32 tx0 = (bounds_min.x - origin.x) * inv_direction.x;
+    const f32 tx1 = (bounds_max.x - origin.x) * inv_direction.x;
+    const f32 ty0 = (bounds_min.y - origin.y) * inv_direction.y;
+    const f32 ty1 = (bounds_max.y - origin.y) * inv_direction.y;
+    const f32 tz0 = (bounds_min.z - origin.z) * inv_direction.z;
+    const f32 tz1 = (bounds_max.z - origin.z) * inv_direction.z;
+
+    const f32 t_near = std::fmax(std::fmax(std::fmin(tx0, tx1), std::fmin(ty0, ty1)),
+                                 std::fmax(std::fmin(tz0, tz1), t_min));
+    const f32 t_far = std::fmin(std::fmin(std::fmax(tx0, tx1), std::fmax(ty0, ty1)),
+                                std::fmin(std::fmax(tz0, tz1), t_max));
+    t_enter = t_near;
+    return t_near <= t_far;
+}
+
+} // namespace Fract
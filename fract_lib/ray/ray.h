@@ -0,0 +1,50 @@
+/*****************************************************************//**
+ * \file   ray.h
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+#include "utils/defination.h"
+#include "utils/math/Math.h"
+
+namespace Fract {
+
+struct Ray {
+    Math::float3 origin{};
+    f32 t_min{0.0f};
+    Math::float3 direction{};
+    f32 t_max{std::numeric_limits<f32>::infinity()};
+    // ray cone footprint for texture lod, width at the origin and spread angle
+    f32 cone_width{0.0f};
+    f32 cone_spread{0.0f};
+
+    Math::float3 At(f32 t) const noexcept { return origin + direction * t; }
+    f32 GetConeWidth(f32 t) const noexcept { return cone_width + cone_spread * t; }
+};
+
+// the cone keeps its width at the hit point and widens by the spread of the
+// surface, which is what sends diffuse and rough bounces to coarse mips
+inline Ray SpawnRay(const Ray &incoming, f32 t, const Math::float3 &origin, const Math::float3 &direction,
+                    f32 surface_spread) noexcept {
+    Ray ray{};
+    ray.origin = origin;
+    ray.direction = direction;
+    ray.cone_width = std::abs(incoming.GetConeWidth(t));
+    ray.cone_spread = incoming.cone_spread + surface_spread;
+    return ray;
+}
+
+// rough approximation of the lobe width of a microfacet brdf, a diffuse
+// surface (roughness 1) spreads the cone over a quarter turn
+inline f32 GetSurfaceSpread(f32 roughness) noexcept {
+    return roughness * roughness * 1.57079632679f;
+}
+
+} // namespace Fract
@@ -42,8 +42,8 @@ struct TextureBarrierDesc {
 
 struct BarrierDesc {
     // u32 src_stage, dst_stage;
-    Container::Array<BufferBarrierDesc> buffer_memory_barriers{};
-    Container::Array<TextureBarrierDesc> texture_memory_barriers{};
+    Container::SmallArray<BufferBarrierDesc, 4> buffer_memory_barriers{};
+    Container::SmallArray<TextureBarrierDesc, 8> texture_memory_barriers{};
 };
 
 
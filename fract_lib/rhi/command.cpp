@@ -33,12 +33,25 @@ void CommandList::BindIndexBuffer(Buffer *buffer, u32 offset) {
     // gpu_command_list->IASetIndexBuffer();
 }
 
-CommandContext::CommandContext(const RendererContext &context) noexcept
-    : m_context(context) {
+CommandContext::CommandContext(
+    const RendererContext &context,
+    Memory::ObjectPool<CommandList> &command_list_pool) noexcept
+    : m_context(context), m_command_list_cache(command_list_pool) {
     m_command_lists_count.fill(0);
 }
 
-CommandContext::~CommandContext() noexcept {}
+CommandContext::~CommandContext() noexcept {
+    for (auto &type : m_command_lists) {
+        for (auto &cmd : type) {
+            m_command_list_cache.Release(cmd);
+        }
+    }
+    for (auto &allocator : m_command_allocators) {
+        if (allocator) {
+            allocator->Release();
+        }
+    }
+}
 
 CommandList *CommandContext::GetCommandList(CommandQueueType type) {
 
@@ -69,7 +82,7 @@ CommandList *CommandContext::GetCommandList(CommandQueueType type) {
             0, command_list_type, m_command_allocators[type], nullptr,
             IID_PPV_ARGS(&dx_command_list)));
 
-        auto cmd = Memory::Alloc<CommandList>(
+        auto cmd = m_command_list_cache.Acquire(
             m_context, type, m_command_allocators[type], dx_command_list);
 
         m_command_lists[type].emplace_back(cmd);
@@ -113,8 +126,8 @@ void CommandList::Dispatch(u32 group_count_x, u32 group_count_y,
 }
 
 void CommandList::InsertBarrier(const BarrierDesc &desc) {
-    auto stack_memory = Memory::GetStackMemoryResource(1024);
-    Container::Array<D3D12_RESOURCE_BARRIER> barriers(&stack_memory);
+    Memory::StackMemoryResource<RHI_SCRATCH_MEMORY_SIZE> scratch;
+    Container::Array<D3D12_RESOURCE_BARRIER> barriers(&scratch);
     barriers.reserve(desc.buffer_memory_barriers.size() +
                      desc.texture_memory_barriers.size());
 
@@ -11,6 +11,8 @@
 #include <variant>
 
 #include "utils/math/Math.h"
+#include "utils/memory/Memory.h"
+#include "utils/memory/ObjectPool.h"
 #include "stdafx.h"
 #include "rhi_utils.h"
 #include "resources.h"
@@ -75,7 +77,7 @@ class CommandList {
 
     void BindPipeline(Pipeline *pipeline);
 
-    void BindPushConstant(Pipeline *pipeline, const Container::String &name,
+    void BindPushConstant(Pipeline *pipeline, Container::NameId name,
                           void *data);
 
     void ClearBuffer(Buffer *buffer, f32 clear_value);
@@ -101,7 +103,8 @@ class CommandList {
 
 class CommandContext {
   public:
-    CommandContext(const RendererContext &context) noexcept;
+    CommandContext(const RendererContext &context,
+                   Memory::ObjectPool<CommandList> &command_list_pool) noexcept;
 
     ~CommandContext() noexcept;
 
@@ -117,6 +120,8 @@ class CommandContext {
 
   private:
     const RendererContext &m_context{};
+    // the context is owned by one recording thread, command lists go through its cache of the shared pool
+    Memory::ObjectPool<CommandList>::ThreadCache m_command_list_cache;
     // each thread has pools to allocate graphics/compute/transfer commandlist
     Container::FixedArray<ID3D12CommandAllocator *, 3> m_command_allocators{};
 
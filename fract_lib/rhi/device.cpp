@@ -11,18 +11,52 @@
 #include <string>
 
 #include <utils/log/log.h>
+#include <utils/trace/Trace.h>
 
 namespace Fract {
 
 thread_local CommandContext *thread_command_context;
 
-Device::Device() noexcept {}
+Device::Device() {}
 
-Device::~Device() noexcept {}
+Device::~Device() noexcept {
+    // the current frame is only signaled when the next one is acquired, signal
+    // it here so everything submitted so far is done before anything is freed.
+    // without a frame yet 1 still covers the submits made before it
+    const u64 last_frame = frame_count > 0 ? frame_count : 1;
+    for (u32 queue_type = 0; queue_type < 3; queue_type++) {
+        if (frame_fences[queue_type]) {
+            CHECK_DX_RESULT(render_context.queues[queue_type]->Signal(
+                frame_fences[queue_type], last_frame));
+        }
+    }
+    WaitFrame(last_frame);
+    for (auto &fence : frame_fences) {
+        if (fence) {
+            fence->Release();
+        }
+    }
+    if (frame_fence_event) {
+        CloseHandle(frame_fence_event);
+    }
+    for (auto &queue_fences : fences) {
+        for (auto &fence : queue_fences) {
+            fence_cache.Release(fence);
+        }
+    }
+    // the contexts of other threads are gone as well, their thread_local
+    // pointers must not be used after the device
+    for (auto &context : command_contexts) {
+        Memory::Free(context);
+    }
+    command_contexts.clear();
+    thread_command_context = nullptr;
+}
 
 void Device::Initialize() {
     CreateFactory();
     CreateDevice();
+    CreateFrameFences();
     InitializeD3DMA();
     CreateShaderCompiler();
 }
@@ -100,6 +134,31 @@ void Device::CreateDevice() noexcept {
 #endif // USE_ASYNC_COMPUTE_TRANSFER
 }
 
+void Device::CreateFrameFences() {
+    for (u32 queue_type = 0; queue_type < 3; queue_type++) {
+        if (!render_context.queues[queue_type]) {
+            continue;
+        }
+        CHECK_DX_RESULT(render_context.device->CreateFence(
+            0, D3D12_FENCE_FLAG_NONE,
+            IID_PPV_ARGS(&frame_fences[queue_type])));
+    }
+    frame_fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (frame_fence_event == nullptr) {
+        CHECK_DX_RESULT(HRESULT_FROM_WIN32(GetLastError()));
+    }
+}
+
+void Device::WaitFrame(u64 frame) {
+    for (auto &fence : frame_fences) {
+        if (fence && fence->GetCompletedValue() < frame) {
+            CHECK_DX_RESULT(
+                fence->SetEventOnCompletion(frame, frame_fence_event));
+            WaitForSingleObject(frame_fence_event, INFINITE);
+        }
+    }
+}
+
 void Device::InitializeD3DMA() noexcept {
     D3D12MA::ALLOCATOR_DESC allocatorDesc{};
     allocatorDesc.pDevice = render_context.device;
@@ -132,7 +191,10 @@ Device::CreateSwapChain(const SwapChainCreateInfo& swap_chain_create_info,
 
 CommandList *Device::GetCommandList(CommandQueueType type) {
     if (!thread_command_context) {
-        thread_command_context = Memory::Alloc<CommandContext>(render_context);
+        thread_command_context =
+            Memory::Alloc<CommandContext>(render_context, command_list_pool);
+        std::lock_guard<std::mutex> lock(command_context_mutex);
+        command_contexts.push_back(thread_command_context);
     }
     return thread_command_context->GetCommandList(type);
 }
@@ -154,8 +216,12 @@ Device::CreateComputePipeline(const ComputePipelineCreateInfo &create_info) {
 }
 
 void Device::SubmitCommandLists(const QueueSubmitInfo &queue_submit_info) {
-    auto stack_memory = Memory::GetStackMemoryResource(4096);
-    Container::Array<ID3D12CommandList *> command_lists{};
+    FRACT_TRACE_EVENT(SUBMIT, "submit", queue_submit_info.queue_type,
+                      queue_submit_info.command_lists.size(), frame_count);
+
+    Memory::StackMemoryResource<RHI_SCRATCH_MEMORY_SIZE> scratch;
+    Container::Array<ID3D12CommandList *> command_lists(&scratch);
+    command_lists.reserve(queue_submit_info.command_lists.size());
     for (auto &cmd : queue_submit_info.command_lists) {
         command_lists.push_back(cmd->get());
     }
@@ -184,17 +250,38 @@ void Device::Present(const QueuePresentInfo &present_info) {
 }
 
 void Device::AcquireNextFrame(SwapChain *swap_chain) {
+    FRACT_TRACE_EVENT(FRAME, "acquire frame", frame_count);
     swap_chain->AcquireNextFrame();
 
+    // frame n signals n on every queue, the first frame has index 1
+    if (frame_count > 0) {
+        for (u32 queue_type = 0; queue_type < 3; queue_type++) {
+            if (frame_fences[queue_type]) {
+                CHECK_DX_RESULT(render_context.queues[queue_type]->Signal(
+                    frame_fences[queue_type], frame_count));
+            }
+        }
+    }
+    frame_count++;
+
+    // at most MAX_FRAMES_IN_FLIGHT frames are recorded or executing
+    if (frame_count > Memory::MAX_FRAMES_IN_FLIGHT) {
+        WaitFrame(frame_count - Memory::MAX_FRAMES_IN_FLIGHT);
+    }
+    u64 completed_frame = frame_count - 1;
+    for (auto &fence : frame_fences) {
+        if (fence && fence->GetCompletedValue() < completed_frame) {
+            completed_frame = fence->GetCompletedValue();
+        }
+    }
+    frame_allocator.ReleaseFrames(completed_frame);
+    frame_allocator.BeginFrame(frame_count);
+
     for (u32 queue_type = 0; queue_type < 3; queue_type++) {
         if (fence_index[queue_type] == 0)
             continue;
+        // keep the fences of the previous frame for reuse
         fence_index[queue_type] = 0;
-        for (auto &fence : fences[queue_type]) {
-            Memory::Free(fence);
-            fence = nullptr;
-        }
-        fences[queue_type].clear();
     }
 
     if (thread_command_context) {
@@ -207,7 +294,7 @@ Fence *Device::GetFence(CommandQueueType type) {
     if (fence_index[type] < fences[type].size()) {
         fence = fences[type][fence_index[type]];
     } else {
-        fence = Memory::Alloc<Fence>(render_context);
+        fence = fence_cache.Acquire(render_context);
         fences[type].push_back(fence);
     }
     fence_index[type]++;
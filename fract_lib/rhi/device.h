@@ -11,12 +11,15 @@
 #include <array>
 #include <variant>
 #include <filesystem>
+#include <mutex>
 
 #include <D3D12MemAlloc.h>
 #include "stdafx.h"
 
 #include <utils/defination.h>
 #include <utils/math/Math.h>
+#include <utils/memory/FrameAllocator.h>
+#include <utils/memory/ObjectPool.h>
 #include <utils/window/Window.h>
 #include "rhi_utils.h"
 #include "resources.h"
@@ -57,9 +60,9 @@ extern thread_local CommandContext *thread_command_context;
 
 struct QueueSubmitInfo {
     CommandQueueType queue_type;
-    Container::Array<CommandList *> command_lists;
-    Container::Array<Semaphore *> wait_semaphores;
-    Container::Array<Semaphore *> signal_semaphores;
+    Container::SmallArray<CommandList *, 8> command_lists;
+    Container::SmallArray<Semaphore *, 4> wait_semaphores;
+    Container::SmallArray<Semaphore *, 4> signal_semaphores;
     bool wait_image_acquired = false;
     bool signal_render_complete = false;
 };
@@ -72,7 +75,7 @@ struct QueuePresentInfo {
 
 class Device {
   public:
-    Device() noexcept;
+    Device();
     ~Device() noexcept;
 
     void Initialize();
@@ -107,14 +110,41 @@ class Device {
     void WaitGpuExecution(CommandQueueType type);
     void Present(const QueuePresentInfo &present_info);
     void AcquireNextFrame(SwapChain *swap_chain);
+
+    // transient cpu memory of the current frame, valid until the gpu finished
+    // the frame
+    Memory::FrameAllocator &GetFrameAllocator() noexcept {
+        return frame_allocator;
+    }
+
   private:
     Fence *GetFence(CommandQueueType type);
+    void CreateFrameFences();
+    void WaitFrame(u64 frame);
   private:
     RendererContext render_context{};
     DescriptorSetAllocator *descriptor_set_allocator{};
 
+    // fences and command lists are recycled, steady state frames don't
+    // allocate
+    Memory::ObjectPool<Fence> fence_pool{
+        Memory::GetGlobalAllocator(Memory::MemoryTag::RHI)};
+    Memory::ObjectPool<CommandList> command_list_pool{
+        Memory::GetGlobalAllocator(Memory::MemoryTag::RHI)};
+    // fences are only taken on the submitting thread
+    Memory::ObjectPool<Fence>::ThreadCache fence_cache{fence_pool};
+    // one context per recording thread, destroyed with the device
+    std::mutex command_context_mutex;
+    Container::Array<CommandContext *> command_contexts{};
     Container::FixedArray<Container::Array<Fence*>, 3> fences{};
     Container::FixedArray<u32, 3> fence_index{};
+
+    // every queue signals the index of the frame it finished, the ring memory
+    // of a frame is reused once all queues passed it
+    Memory::FrameAllocator frame_allocator{};
+    Container::FixedArray<ID3D12Fence *, 3> frame_fences{};
+    HANDLE frame_fence_event{};
+    u64 frame_count{};
 };
 
 } // namespace Fract
\ No newline at end of file
@@ -30,21 +30,21 @@ class DescriptorSet {
 
   public:
     void SetResource(Buffer *resource,
-                             const Container::String &resource_name);
+                             Container::NameId resource_name);
     void SetResource(Texture *resource,
-                             const Container::String &resource_name);
+                             Container::NameId resource_name);
     void SetResource(Sampler *resource,
-                             const Container::String &resource_name);
+                             Container::NameId resource_name);
 
     void
     SetBindlessResource(Container::Array<Buffer *> &resource,
-                        const Container::String &resource_name);
+                        Container::NameId resource_name);
     void
     SetBindlessResource(Container::Array<Texture *> &resource,
-                        const Container::String &resource_name);
+                        Container::NameId resource_name);
     void
     SetBindlessResource(Container::Array<Sampler *> &resource,
-                        const Container::String &resource_name);
+                        Container::NameId resource_name);
     void Update();
 
   public:
@@ -45,6 +45,10 @@ static constexpr u32 MAX_RENDER_TARGET_COUNT = 8;
 static constexpr u32 MAX_ATTRIBUTE_COUNT = 32;
 static constexpr u32 MAX_BINDING_COUNT = 32;
 
+// inline scratch of per call arrays (barriers, submitted command lists),
+// larger ones spill to the thread arena
+static constexpr size_t RHI_SCRATCH_MEMORY_SIZE = 4096;
+
 enum class RenderBackend {
     RENDER_BACKEND_NONE,
     RENDER_BACKEND_VULKAN,
@@ -393,7 +397,8 @@ struct MultiSampleState {
 
 struct RenderTargetFormats {
     u32 color_attachment_count = 0;
-    Container::Array<TextureFormat> color_attachment_formats;
+    // d3d12 binds at most 8 render targets
+    Container::SmallArray<TextureFormat, 8> color_attachment_formats;
     bool has_depth = true, has_stencil = false;
     TextureFormat depth_stencil_format;
 };
@@ -463,11 +468,14 @@ struct PushConstantDesc {
     u32 shader_stages;
 };
 
+// keyed by the hashed binding name, names from reflection are registered
+// with Container::NameId::Register()
 struct RootSignatureDesc {
-    Container::FixedArray<Container::HashMap<Container::String, DescriptorDesc>,
-                          DESCRIPTOR_SET_UPDATE_FREQUENCIES>
+    Container::FixedArray<
+        Container::FlatHashMap<Container::NameId, DescriptorDesc>,
+        DESCRIPTOR_SET_UPDATE_FREQUENCIES>
         descriptors{};
-    Container::HashMap<Container::String, PushConstantDesc> push_constants;
+    Container::FlatHashMap<Container::NameId, PushConstantDesc> push_constants;
 };
 
 u32 GetStrideFromVertexAttributeDescription(VertexAttribFormat format,
@@ -0,0 +1,522 @@
+/*****************************************************************//**
+ * \file   texture_cache.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "texture_cache.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#include "utils/log/log.h"
+#include "utils/math/Packing.h"
+#include "utils/trace/Trace.h"
+
+namespace Fract {
+
+namespace {
+
+constexpr u64 INVALID_TILE_KEY = ~0ull;
+
+// texture:24 | mip:8 | tile y:16 | tile x:16
+u64 MakeTileKey(TextureHandle texture, u32 mip, u32 tile_x, u32 tile_y) {
+    return (static_cast<u64>(texture) << 40) | (static_cast<u64>(mip) << 32) | (static_cast<u64>(tile_y) << 16) |
+           tile_x;
+}
+
+u64 HashTileKey(u64 key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+u64 NextPowerOfTwo(u64 v) {
+    u64 result = 1;
+    while (result < v) {
+        result <<= 1;
+    }
+    return result;
+}
+
+bool TryAcquire(TextureTile *tile, u64 key) {
+    const u32 previous = tile->reference_count.fetch_add(1, std::memory_order_acquire);
+    if (previous & TEXTURE_TILE_LOCKED) {
+        // loading or evicted
+        tile->reference_count.fetch_sub(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (tile->key.load(std::memory_order_relaxed) != key) {
+        tile->reference_count.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+void Release(TextureTile *tile) {
+    tile->reference_count.fetch_sub(1, std::memory_order_release);
+}
+
+// avoid writing the shared cache line when nothing changed
+void Touch(TextureTile *tile, u64 now) {
+    if (tile->last_access.load(std::memory_order_relaxed) != now) {
+        tile->last_access.store(now, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+struct TextureCache::Shard {
+    Shard(u64 capacity, u32 max_tiles, u64 budget, std::pmr::memory_resource *resource)
+        : slots(capacity, resource), slot_mask(capacity - 1), resident(resource), free_tiles(resource),
+          all_tiles(resource), max_tiles(max_tiles), budget(budget) {
+        resident.reserve(max_tiles);
+        free_tiles.reserve(max_tiles);
+        all_tiles.reserve(max_tiles);
+    }
+
+    // lock free, may miss a tile that is being moved by Erase()
+    TextureTile *Find(u64 key, u64 hash) const {
+        for (u64 i = hash & slot_mask, probes = 0; probes <= slot_mask; i = (i + 1) & slot_mask, probes++) {
+            TextureTile *tile = slots[i].load(std::memory_order_acquire);
+            if (!tile) {
+                return nullptr;
+            }
+            if (tile->key.load(std::memory_order_relaxed) == key) {
+                return tile;
+            }
+        }
+        return nullptr;
+    }
+
+    // under the shard lock
+    void Insert(TextureTile *tile) {
+        u64 i = tile->hash & slot_mask;
+        while (slots[i].load(std::memory_order_relaxed)) {
+            i = (i + 1) & slot_mask;
+        }
+        slots[i].store(tile, std::memory_order_release);
+    }
+
+    // under the shard lock, backward shift deletion keeps probe chains intact
+    // without tombstones
+    void Erase(TextureTile *tile) {
+        u64 i = tile->hash & slot_mask;
+        while (slots[i].load(std::memory_order_relaxed) != tile) {
+            i = (i + 1) & slot_mask;
+        }
+        u64 j = i;
+        while (true) {
+            j = (j + 1) & slot_mask;
+            TextureTile *next = slots[j].load(std::memory_order_relaxed);
+            if (!next) {
+                break;
+            }
+            const u64 home = next->hash & slot_mask;
+            const bool reachable = i <= j ? (home > i && home <= j) : (home > i || home <= j);
+            if (!reachable) {
+                slots[i].store(next, std::memory_order_release);
+                i = j;
+            }
+        }
+        slots[i].store(nullptr, std::memory_order_release);
+    }
+
+    std::mutex mutex;
+    Container::Array<std::atomic<TextureTile *>> slots;
+    u64 slot_mask;
+    Container::Array<TextureTile *> resident;
+    Container::Array<TextureTile *> free_tiles;
+    Container::Array<TextureTile *> all_tiles;
+    u32 max_tiles;
+    u32 clock_hand{};
+    u64 budget;
+    u64 resident_bytes{};
+};
+
+struct TextureCache::MicroCache {
+    struct Entry {
+        u64 key{INVALID_TILE_KEY};
+        TextureTile *tile{};
+    };
+
+    ~MicroCache() {
+        if (TextureCache *cache = owner.load(std::memory_order_acquire)) {
+            cache->ReleaseMicroCache(*this);
+        }
+    }
+
+    // cleared with release by whoever hands the micro cache back, its entries are reset before that
+    std::atomic<TextureCache *> owner{};
+    Container::FixedArray<Entry, TEXTURE_MICRO_CACHE_SIZE> entries{};
+    u32 pin_epoch{};
+    std::atomic<u64> lookups{0}; // only written by the owning thread, no contended read-modify-write
+};
+
+TextureCache::TextureCache(const TextureCacheCreateInfo &create_info, std::pmr::memory_resource *resource) noexcept
+    : m_resource(resource), m_shards(resource), m_textures(TEXTURE_CACHE_MAX_TEXTURES, nullptr, resource),
+      m_micro_caches(resource) {
+    // every thread pins up to a micro cache of tiles plus the one it is loading, all of them may land in one shard.
+    // a shard must fit those and one more to always find something to evict.
+    const u64 largest_tile = static_cast<u64>(TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE * 8;
+    const u64 smallest_tile = static_cast<u64>(TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE * 4;
+    const u64 thread_count = create_info.thread_count ? create_info.thread_count
+                                                      : std::max(std::thread::hardware_concurrency(), 1u);
+    const u64 pinned_bytes = (thread_count * (TEXTURE_MICRO_CACHE_SIZE + 1) + 1) * largest_tile;
+
+    u64 shard_count = NextPowerOfTwo(std::max(create_info.shard_count, 1u));
+    while (shard_count > 1 && create_info.memory_budget / shard_count < pinned_bytes) {
+        shard_count /= 2;
+    }
+    u64 shard_budget = create_info.memory_budget / shard_count;
+    if (shard_budget < pinned_bytes) {
+        LOG_WARN("texture cache budget of {} bytes is below the {} bytes {} threads can pin, using that",
+                 create_info.memory_budget, pinned_bytes, thread_count);
+        shard_budget = pinned_bytes;
+    }
+    m_shard_mask = shard_count - 1;
+
+    // rgba8 tiles are the smallest, keep the table at most half full
+    const u32 max_tiles = static_cast<u32>(shard_budget / smallest_tile);
+    const u64 capacity = NextPowerOfTwo(static_cast<u64>(max_tiles) * 2);
+
+    m_shards.resize(shard_count);
+    for (auto &shard : m_shards) {
+        shard = Memory::Alloc<Shard>(*resource, capacity, max_tiles, shard_budget, resource);
+    }
+}
+
+TextureCache::~TextureCache() noexcept {
+    {
+        // tiles are going away, threads must not release them later. they see the cleared entries once they
+        // load the cleared owner.
+        std::lock_guard<std::mutex> lock(m_micro_cache_mutex);
+        for (MicroCache *micro_cache : m_micro_caches) {
+            micro_cache->entries.fill(MicroCache::Entry{});
+            micro_cache->owner.store(nullptr, std::memory_order_release);
+        }
+    }
+    for (Shard *shard : m_shards) {
+        for (TextureTile *tile : shard->all_tiles) {
+            if (tile->data) {
+                m_resource->deallocate(tile->data, tile->size, 64);
+            }
+            Memory::Free(*m_resource, tile);
+        }
+        Memory::Free(*m_resource, shard);
+    }
+    for (TiledTextureFile *texture : m_textures) {
+        Memory::Free(*m_resource, texture);
+    }
+}
+
+TextureHandle TextureCache::AddTexture(const std::filesystem::path &file_name) {
+    auto *texture = Memory::Alloc<TiledTextureFile>(*m_resource);
+    if (!texture->Open(file_name)) {
+        Memory::Free(*m_resource, texture);
+        return INVALID_TEXTURE_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock(m_texture_mutex);
+    const u32 handle = m_texture_count.load(std::memory_order_relaxed);
+    if (handle >= TEXTURE_CACHE_MAX_TEXTURES) {
+        LOG_ERROR("too many textures, {} is not loaded", file_name.string());
+        Memory::Free(*m_resource, texture);
+        return INVALID_TEXTURE_HANDLE;
+    }
+    m_textures[handle] = texture;
+    m_texture_count.store(handle + 1, std::memory_order_release);
+    return handle;
+}
+
+u32 TextureCache::GetWidth(TextureHandle texture, u32 mip) const noexcept {
+    return m_textures[texture]->GetWidth(mip);
+}
+
+u32 TextureCache::GetHeight(TextureHandle texture, u32 mip) const noexcept {
+    return m_textures[texture]->GetHeight(mip);
+}
+
+u32 TextureCache::GetMipCount(TextureHandle texture) const noexcept {
+    return m_textures[texture]->GetMipCount();
+}
+
+f32 TextureCache::GetLod(TextureHandle texture, f32 lod_bias, f32 cone_width, f32 cos_theta) const noexcept {
+    const f32 texel_count = static_cast<f32>(GetWidth(texture)) * static_cast<f32>(GetHeight(texture));
+    const f32 footprint = cone_width / std::max(std::abs(cos_theta), 1e-4f);
+    if (footprint <= 0.0f) {
+        return 0.0f;
+    }
+    return std::max(lod_bias + 0.5f * std::log2(texel_count) + std::log2(footprint), 0.0f);
+}
+
+Math::float4 TextureCache::Texel(TextureHandle texture, u32 mip, i32 x, i32 y) {
+    const TiledTextureFile *file = m_textures[texture];
+    mip = std::min(mip, file->GetMipCount() - 1);
+    const i32 width = static_cast<i32>(file->GetWidth(mip));
+    const i32 height = static_cast<i32>(file->GetHeight(mip));
+    x = ((x % width) + width) % width;
+    y = ((y % height) + height) % height;
+
+    const u8 *data = GetTileData(texture, mip, x / TEXTURE_TILE_SIZE, y / TEXTURE_TILE_SIZE);
+    const u32 texel_size = GetTexelSize(file->GetFormat());
+    const u8 *texel = data + ((y % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE + (x % TEXTURE_TILE_SIZE)) * texel_size;
+
+    if (file->GetFormat() == TexelFormat::RGBA16_SFLOAT) {
+        u16 half[4];
+        f32 rgba[4];
+        std::memcpy(half, texel, sizeof(half));
+        Math::HalfToFloat(half, rgba, 4);
+        return Math::float4{rgba[0], rgba[1], rgba[2], rgba[3]};
+    }
+    constexpr f32 scale = 1.0f / 255.0f;
+    return Math::float4{texel[0] * scale, texel[1] * scale, texel[2] * scale, texel[3] * scale};
+}
+
+Math::float4 TextureCache::SampleBilinear(TextureHandle texture, const Math::float2 &uv, u32 mip) {
+    mip = std::min(mip, GetMipCount(texture) - 1);
+    const f32 x = uv.x * GetWidth(texture, mip) - 0.5f;
+    const f32 y = uv.y * GetHeight(texture, mip) - 0.5f;
+    const f32 x0 = std::floor(x);
+    const f32 y0 = std::floor(y);
+    const f32 tx = x - x0;
+    const f32 ty = y - y0;
+    const i32 ix = static_cast<i32>(x0);
+    const i32 iy = static_cast<i32>(y0);
+
+    const Math::float4 t00 = Texel(texture, mip, ix, iy);
+    const Math::float4 t10 = Texel(texture, mip, ix + 1, iy);
+    const Math::float4 t01 = Texel(texture, mip, ix, iy + 1);
+    const Math::float4 t11 = Texel(texture, mip, ix + 1, iy + 1);
+    return (t00 * (1.0f - tx) + t10 * tx) * (1.0f - ty) + (t01 * (1.0f - tx) + t11 * tx) * ty;
+}
+
+Math::float4 TextureCache::SampleTrilinear(TextureHandle texture, const Math::float2 &uv, f32 lod) {
+    const u32 last_mip = GetMipCount(texture) - 1;
+    lod = std::clamp(lod, 0.0f, static_cast<f32>(last_mip));
+    const u32 mip = static_cast<u32>(lod);
+    const f32 t = lod - static_cast<f32>(mip);
+    if (t == 0.0f || mip == last_mip) {
+        return SampleBilinear(texture, uv, mip);
+    }
+    return SampleBilinear(texture, uv, mip) * (1.0f - t) + SampleBilinear(texture, uv, mip + 1) * t;
+}
+
+TextureCache::MicroCache &TextureCache::GetMicroCache() {
+    static thread_local MicroCache micro_cache;
+    return micro_cache;
+}
+
+const u8 *TextureCache::GetTileData(TextureHandle texture, u32 mip, u32 tile_x, u32 tile_y) {
+    MicroCache &micro_cache = GetMicroCache();
+    TextureCache *owner = micro_cache.owner.load(std::memory_order_acquire);
+    if (owner != this) {
+        if (owner) {
+            owner->ReleaseMicroCache(micro_cache);
+        }
+        std::lock_guard<std::mutex> lock(m_micro_cache_mutex);
+        m_micro_caches.push_back(&micro_cache);
+        micro_cache.owner.store(this, std::memory_order_relaxed);
+        micro_cache.pin_epoch = m_pin_epoch.load(std::memory_order_relaxed);
+    }
+    // a miss somewhere found every tile of its shard pinned
+    const u32 pin_epoch = m_pin_epoch.load(std::memory_order_relaxed);
+    if (micro_cache.pin_epoch != pin_epoch) {
+        DropPins(micro_cache);
+        micro_cache.pin_epoch = pin_epoch;
+    }
+
+    const u64 key = MakeTileKey(texture, mip, tile_x, tile_y);
+    auto &entry = micro_cache.entries[(tile_x ^ (tile_y * 7) ^ (mip * 13) ^ (texture * 31)) %
+                                      TEXTURE_MICRO_CACHE_SIZE];
+    if (entry.key == key) {
+        return entry.tile->data;
+    }
+
+    micro_cache.lookups.store(micro_cache.lookups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    TextureTile *tile = AcquireTile(key);
+    if (entry.tile) {
+        Release(entry.tile);
+    }
+    entry.key = key;
+    entry.tile = tile;
+    return tile->data;
+}
+
+TextureTile *TextureCache::AcquireTile(u64 key) {
+    const u64 hash = HashTileKey(key);
+    Shard &shard = *m_shards[(hash >> 48) & m_shard_mask];
+
+    TextureTile *tile = shard.Find(key, hash);
+    if (tile && TryAcquire(tile, key)) {
+        Touch(tile, m_clock.load(std::memory_order_relaxed));
+        return tile;
+    }
+    return AcquireTileSlow(shard, key, hash);
+}
+
+TextureTile *TextureCache::AcquireTileSlow(Shard &shard, u64 key, u64 hash) {
+    const TextureHandle texture = static_cast<TextureHandle>(key >> 40);
+    const u32 mip = static_cast<u32>(key >> 32) & 0xff;
+    const u32 tile_y = static_cast<u32>(key >> 16) & 0xffff;
+    const u32 tile_x = static_cast<u32>(key) & 0xffff;
+    TiledTextureFile *file = m_textures[texture];
+    const u32 size = static_cast<u32>(file->GetTileSize());
+
+    u32 pin_waits = 0;
+    while (true) {
+        std::unique_lock<std::mutex> lock(shard.mutex);
+        if (TextureTile *tile = shard.Find(key, hash)) {
+            // another thread is loading it
+            lock.unlock();
+            if (TryAcquire(tile, key)) {
+                Touch(tile, m_clock.load(std::memory_order_relaxed));
+                return tile;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+
+        while (shard.resident_bytes + size > shard.budget && EvictOne(shard)) {
+        }
+        if (shard.resident_bytes + size > shard.budget) {
+            // everything is pinned or loading, have every thread drop its pins and wait for one. the table needs a
+            // free slot to go over the budget.
+            if (pin_waits++ < TEXTURE_CACHE_PIN_WAIT_COUNT || shard.resident.size() + 1 >= shard.slots.size()) {
+                lock.unlock();
+                DropPins(GetMicroCache());
+                m_pin_epoch.fetch_add(1, std::memory_order_relaxed);
+                std::this_thread::yield();
+                continue;
+            }
+            m_budget_overruns.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        TextureTile *tile{};
+        if (!shard.free_tiles.empty()) {
+            tile = shard.free_tiles.back();
+            shard.free_tiles.pop_back();
+        } else {
+            tile = Memory::Alloc<TextureTile>(*m_resource);
+            tile->key.store(INVALID_TILE_KEY, std::memory_order_relaxed);
+            tile->reference_count.store(TEXTURE_TILE_LOCKED, std::memory_order_relaxed);
+            shard.all_tiles.push_back(tile);
+        }
+        tile->data = static_cast<u8 *>(m_resource->allocate(size, 64));
+        tile->size = size;
+        tile->hash = hash;
+        tile->last_access.store(m_clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        tile->key.store(key, std::memory_order_relaxed);
+        tile->resident_index = static_cast<u32>(shard.resident.size());
+        shard.resident.push_back(tile);
+        shard.resident_bytes += size;
+        shard.Insert(tile);
+        lock.unlock();
+
+        // the tile stays locked while it is read, concurrent requests wait above
+        FRACT_TRACE_BEGIN(TEXTURE, "load tile", texture, mip, tile_x | tile_y << 16);
+        if (!file->ReadTile(mip, tile_x, tile_y, tile->data)) {
+            LOG_ERROR("failed to read tile {} {} of mip {} of texture {}", tile_x, tile_y, mip, texture);
+            std::memset(tile->data, 0, size);
+        }
+        FRACT_TRACE_END(TEXTURE, "load tile");
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+
+        // unlock and keep one reference for the caller
+        tile->reference_count.fetch_sub(TEXTURE_TILE_LOCKED - 1, std::memory_order_release);
+        return tile;
+    }
+}
+
+bool TextureCache::EvictOne(Shard &shard) {
+    const u32 count = static_cast<u32>(shard.resident.size());
+
+    // oldest unreferenced tile among a few samples, all of them if needed
+    TextureTile *victim{};
+    u64 oldest = std::numeric_limits<u64>::max();
+    for (u32 i = 0; i < count && (i < TEXTURE_CACHE_EVICTION_SAMPLES || !victim); i++) {
+        TextureTile *tile = shard.resident[shard.clock_hand++ % count];
+        const u64 last_access = tile->last_access.load(std::memory_order_relaxed);
+        if (tile->reference_count.load(std::memory_order_relaxed) == 0 && last_access < oldest) {
+            victim = tile;
+            oldest = last_access;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    u32 expected = 0;
+    if (!victim->reference_count.compare_exchange_strong(expected, TEXTURE_TILE_LOCKED,
+                                                         std::memory_order_acquire)) {
+        // picked up in the meantime, the caller retries
+        return true;
+    }
+
+    shard.Erase(victim);
+    TextureTile *last = shard.resident.back();
+    shard.resident[victim->resident_index] = last;
+    last->resident_index = victim->resident_index;
+    shard.resident.pop_back();
+
+    victim->key.store(INVALID_TILE_KEY, std::memory_order_relaxed);
+    m_resource->deallocate(victim->data, victim->size, 64);
+    victim->data = nullptr;
+    shard.resident_bytes -= victim->size;
+    shard.free_tiles.push_back(victim);
+
+    m_evictions.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TextureCache::FlushThreadCache() {
+    MicroCache &micro_cache = GetMicroCache();
+    if (micro_cache.owner.load(std::memory_order_acquire) == this) {
+        ReleaseMicroCache(micro_cache);
+    }
+}
+
+void TextureCache::DropPins(MicroCache &micro_cache) {
+    for (auto &entry : micro_cache.entries) {
+        if (entry.tile) {
+            Release(entry.tile);
+        }
+        entry = MicroCache::Entry{};
+    }
+}
+
+void TextureCache::ReleaseMicroCache(MicroCache &micro_cache) {
+    DropPins(micro_cache);
+    std::lock_guard<std::mutex> lock(m_micro_cache_mutex);
+    m_retired_lookups.fetch_add(micro_cache.lookups.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    m_micro_caches.erase(std::remove(m_micro_caches.begin(), m_micro_caches.end(), &micro_cache),
+                         m_micro_caches.end());
+    micro_cache.owner.store(nullptr, std::memory_order_relaxed);
+}
+
+TextureCacheStatistics TextureCache::GetStatistics() const noexcept {
+    TextureCacheStatistics statistics{};
+    {
+        std::lock_guard<std::mutex> lock(m_micro_cache_mutex);
+        statistics.lookups = m_retired_lookups.load(std::memory_order_relaxed);
+        for (const MicroCache *micro_cache : m_micro_caches) {
+            statistics.lookups += micro_cache->lookups.load(std::memory_order_relaxed);
+        }
+    }
+    statistics.misses = m_misses.load(std::memory_order_relaxed);
+    statistics.evictions = m_evictions.load(std::memory_order_relaxed);
+    statistics.budget_overruns = m_budget_overruns.load(std::memory_order_relaxed);
+    for (Shard *shard : m_shards) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        statistics.resident_bytes += shard->resident_bytes;
+    }
+    return statistics;
+}
+
+} // namespace Fract
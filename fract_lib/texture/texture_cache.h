@@ -0,0 +1,132 @@
+/*****************************************************************//**
+ * \file   texture_cache.h
+ * \brief  tile cache for cpu texture sampling
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "utils/math/Math.h"
+#include "tiled_texture.h"
+
+namespace Fract {
+
+using TextureHandle = u32;
+
+static constexpr TextureHandle INVALID_TEXTURE_HANDLE = ~0u;
+static constexpr u32 TEXTURE_CACHE_MAX_TEXTURES = 1u << 16;
+static constexpr u32 TEXTURE_MICRO_CACHE_SIZE = 32;  // entries per thread
+static constexpr u32 TEXTURE_CACHE_EVICTION_SAMPLES = 8;
+static constexpr u32 TEXTURE_CACHE_PIN_WAIT_COUNT = 256; // yields waiting for pins to drop before going over budget
+static constexpr u32 TEXTURE_TILE_LOCKED = 1u << 31;
+
+struct TextureCacheCreateInfo {
+    u64 memory_budget = 1ull << 30; // bytes of tile data, split evenly over the shards
+    u32 shard_count = 16;           // power of two, lowered when a shard can't hold the tiles pinned by every thread
+    u32 thread_count = 0;           // threads sampling at once, 0 for every hardware thread
+};
+
+struct TextureCacheStatistics {
+    u64 lookups;   // shared cache lookups, micro cache hits are not counted
+    u64 misses;    // tiles read from disk
+    u64 evictions;
+    u64 budget_overruns; // misses loaded over the budget because every tile of the shard stayed pinned
+    u64 resident_bytes;
+};
+
+// a tile header is never freed while the cache is alive so lock free readers
+// can always touch its reference count, TEXTURE_TILE_LOCKED is set while the
+// tile is being loaded or sits evicted on a free list
+struct TextureTile {
+    std::atomic<u64> key;
+    std::atomic<u32> reference_count;
+    std::atomic<u64> last_access;
+    u64 hash;           // written under the shard lock
+    u32 resident_index; // position in the shard resident list
+    u32 size;
+    u8 *data;
+};
+
+// tiles are looked up in a sharded open addressing table without taking any
+// lock, misses load the tile from disk and evict approximately least recently
+// used tiles of the same shard to stay in the budget. every thread keeps a few
+// referenced tiles in a micro cache in front of the shared one.
+//
+// tiles referenced by micro caches can't be evicted, so every shard is sized
+// to hold the tiles all threads can pin plus one. a miss that still finds
+// nothing to evict asks every thread to drop its pins, which they do on their
+// next lookup. threads that stopped sampling never do, so after a short wait
+// the tile is loaded over the budget and later misses evict back under it.
+//
+// micro caches are handed back by their thread or by the destructor, threads
+// must be done sampling before the cache is destroyed.
+class TextureCache {
+  public:
+    TextureCache(const TextureCacheCreateInfo &create_info,
+                 std::pmr::memory_resource *resource = Memory::GetGlobalAllocator(Memory::MemoryTag::TEXTURE)) noexcept;
+    ~TextureCache() noexcept;
+
+    TextureCache(const TextureCache &rhs) noexcept = delete;
+    TextureCache &operator=(const TextureCache &rhs) noexcept = delete;
+    TextureCache(TextureCache &&rhs) noexcept = delete;
+    TextureCache &operator=(TextureCache &&rhs) noexcept = delete;
+
+    // file written by ConvertToTiledTexture(), tiles are loaded on first access
+    TextureHandle AddTexture(const std::filesystem::path &file_name);
+
+    u32 GetWidth(TextureHandle texture, u32 mip = 0) const noexcept;
+    u32 GetHeight(TextureHandle texture, u32 mip = 0) const noexcept;
+    u32 GetMipCount(TextureHandle texture) const noexcept;
+
+    // ray cone lod: lod_bias from Mesh::GetTextureLodBias(), cone width at the
+    // hit and the cosine between the ray and the surface normal
+    f32 GetLod(TextureHandle texture, f32 lod_bias, f32 cone_width, f32 cos_theta) const noexcept;
+
+    // texel coordinates wrap around
+    Math::float4 Texel(TextureHandle texture, u32 mip, i32 x, i32 y);
+    Math::float4 SampleBilinear(TextureHandle texture, const Math::float2 &uv, u32 mip);
+    Math::float4 SampleTrilinear(TextureHandle texture, const Math::float2 &uv, f32 lod);
+
+    // drop the tile references held by the calling thread
+    void FlushThreadCache();
+
+    TextureCacheStatistics GetStatistics() const noexcept;
+
+  private:
+    struct Shard;
+    struct MicroCache;
+
+    static MicroCache &GetMicroCache();
+
+    const u8 *GetTileData(TextureHandle texture, u32 mip, u32 tile_x, u32 tile_y);
+    TextureTile *AcquireTile(u64 key);
+    TextureTile *AcquireTileSlow(Shard &shard, u64 key, u64 hash);
+    bool EvictOne(Shard &shard);
+    void ReleaseMicroCache(MicroCache &micro_cache);
+    static void DropPins(MicroCache &micro_cache);
+
+    std::pmr::memory_resource *m_resource{};
+    Container::Array<Shard *> m_shards;
+    u64 m_shard_mask{};
+
+    Container::Array<TiledTextureFile *> m_textures;
+    std::atomic<u32> m_texture_count{0};
+    std::mutex m_texture_mutex;
+
+    mutable std::mutex m_micro_cache_mutex;
+    Container::Array<MicroCache *> m_micro_caches;
+
+    std::atomic<u64> m_clock{0};
+    std::atomic<u32> m_pin_epoch{0};        // bumped to make every micro cache drop its pins
+    std::atomic<u64> m_retired_lookups{0}; // lookups of micro caches that left, the others count their own
+    std::atomic<u64> m_misses{0};
+    std::atomic<u64> m_evictions{0};
+    std::atomic<u64> m_budget_overruns{0};
+};
+
+} // namespace Fract
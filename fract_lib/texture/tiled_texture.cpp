@@ -0,0 +1,249 @@
+/*****************************************************************//**
+ * \file   tiled_texture.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "tiled_texture.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "utils/log/log.h"
+#include "utils/math/Packing.h"
+
+namespace Fract {
+
+TiledTextureFile::TiledTextureFile() noexcept {}
+
+TiledTextureFile::~TiledTextureFile() noexcept { Close(); }
+
+void TiledTextureFile::Close() noexcept {
+    if (m_handle == -1) {
+        return;
+    }
+#ifdef _WIN32
+    CloseHandle(reinterpret_cast<HANDLE>(m_handle));
+#else
+    close(static_cast<int>(m_handle));
+#endif
+    m_handle = -1;
+}
+
+bool TiledTextureFile::Open(const std::filesystem::path &file_name) {
+    Close();
+#ifdef _WIN32
+    const HANDLE handle = CreateFileW(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, nullptr);
+    m_handle = handle == INVALID_HANDLE_VALUE ? -1 : reinterpret_cast<intptr_t>(handle);
+#else
+    m_handle = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if (m_handle == -1) {
+        LOG_ERROR("failed to open tiled texture: {}", file_name.string());
+        return false;
+    }
+    if (!ReadAt(0, &m_header, sizeof(m_header)) || m_header.magic != TILED_TEXTURE_MAGIC ||
+        m_header.version != TILED_TEXTURE_VERSION) {
+        LOG_ERROR("invalid tiled texture: {}", file_name.string());
+        Close();
+        return false;
+    }
+
+    m_first_tile.resize(static_cast<size_t>(m_header.mip_count) + 1);
+    u64 tile_count = 0;
+    for (u32 mip = 0; mip < m_header.mip_count; mip++) {
+        m_first_tile[mip] = tile_count;
+        tile_count += static_cast<u64>(GetTileCountX(mip)) * GetTileCountY(mip);
+    }
+    m_first_tile[m_header.mip_count] = tile_count;
+    return true;
+}
+
+bool TiledTextureFile::ReadTile(u32 mip, u32 tile_x, u32 tile_y, void *dst) {
+    const u64 tile = m_first_tile[mip] + static_cast<u64>(tile_y) * GetTileCountX(mip) + tile_x;
+    const u64 tile_size = GetTileSize();
+    return ReadAt(sizeof(TiledTextureHeader) + tile * tile_size, dst, tile_size);
+}
+
+#ifdef _WIN32
+
+namespace {
+
+// overlapped reads of one handle need an event each, one per thread is enough for blocking reads
+struct ReadEvent {
+    ReadEvent() noexcept : event(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+    ~ReadEvent() noexcept {
+        if (event) {
+            CloseHandle(event);
+        }
+    }
+    HANDLE event;
+};
+
+} // namespace
+
+bool TiledTextureFile::ReadAt(u64 offset, void *dst, u64 size) {
+    thread_local ReadEvent read_event;
+    if (!read_event.event) {
+        return false;
+    }
+    const HANDLE handle = reinterpret_cast<HANDLE>(m_handle);
+    u8 *bytes = static_cast<u8 *>(dst);
+    while (size > 0) {
+        OVERLAPPED overlapped{};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        overlapped.hEvent = read_event.event;
+        const DWORD request = static_cast<DWORD>(std::min<u64>(size, 1u << 30));
+        DWORD read = 0;
+        if (!ReadFile(handle, bytes, request, nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING) {
+            return false;
+        }
+        if (!GetOverlappedResult(handle, &overlapped, &read, TRUE) || read == 0) {
+            return false;
+        }
+        bytes += read;
+        offset += read;
+        size -= read;
+    }
+    return true;
+}
+
+#else
+
+bool TiledTextureFile::ReadAt(u64 offset, void *dst, u64 size) {
+    u8 *bytes = static_cast<u8 *>(dst);
+    while (size > 0) {
+        const ssize_t read = pread(static_cast<int>(m_handle), bytes, size, static_cast<off_t>(offset));
+        if (read <= 0) {
+            if (read < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bytes += read;
+        offset += static_cast<u64>(read);
+        size -= static_cast<u64>(read);
+    }
+    return true;
+}
+
+#endif // _WIN32
+
+bool ConvertToTiledTexture(const std::filesystem::path &source, const std::filesystem::path &destination) {
+    const std::string source_name = source.string();
+    const bool is_hdr = stbi_is_hdr(source_name.c_str()) != 0;
+
+    int w = 0, h = 0, channels = 0;
+    Container::Array<f32> level;
+    if (is_hdr) {
+        f32 *pixels = stbi_loadf(source_name.c_str(), &w, &h, &channels, 4);
+        if (!pixels) {
+            LOG_ERROR("failed to load image {}: {}", source_name, stbi_failure_reason());
+            return false;
+        }
+        level.assign(pixels, pixels + static_cast<size_t>(w) * h * 4);
+        stbi_image_free(pixels);
+    } else {
+        u8 *pixels = stbi_load(source_name.c_str(), &w, &h, &channels, 4);
+        if (!pixels) {
+            LOG_ERROR("failed to load image {}: {}", source_name, stbi_failure_reason());
+            return false;
+        }
+        level.resize(static_cast<size_t>(w) * h * 4);
+        for (size_t i = 0; i < level.size(); i++) {
+            level[i] = pixels[i] * (1.0f / 255.0f);
+        }
+        stbi_image_free(pixels);
+    }
+
+    TiledTextureHeader header{};
+    header.magic = TILED_TEXTURE_MAGIC;
+    header.version = TILED_TEXTURE_VERSION;
+    header.format = is_hdr ? TexelFormat::RGBA16_SFLOAT : TexelFormat::RGBA8_UNORM;
+    header.width = static_cast<u32>(w);
+    header.height = static_cast<u32>(h);
+    header.mip_count = static_cast<u32>(std::floor(std::log2(std::max(w, h)))) + 1;
+
+    std::ofstream file(destination, std::ios::binary);
+    if (!file.is_open()) {
+        LOG_ERROR("failed to create tiled texture: {}", destination.string());
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    const u32 texel_size = GetTexelSize(header.format);
+    Container::Array<u8> tile(static_cast<size_t>(TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE * texel_size);
+    Container::Array<f32> next_level;
+
+    u32 width = header.width, height = header.height;
+    for (u32 mip = 0; mip < header.mip_count; mip++) {
+        const u32 tile_count_x = (width + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+        const u32 tile_count_y = (height + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+        for (u32 ty = 0; ty < tile_count_y; ty++) {
+            for (u32 tx = 0; tx < tile_count_x; tx++) {
+                // a row of the tile converts in one call, texels past the level edge repeat the last one
+                const u32 x_begin = tx * TEXTURE_TILE_SIZE;
+                const u32 row_width = std::min(TEXTURE_TILE_SIZE, width - x_begin);
+                for (u32 y = 0; y < TEXTURE_TILE_SIZE; y++) {
+                    const u32 sy = std::min(ty * TEXTURE_TILE_SIZE + y, height - 1);
+                    const f32 *texels = &level[(static_cast<size_t>(sy) * width + x_begin) * 4];
+                    u8 *dst = &tile[static_cast<size_t>(y) * TEXTURE_TILE_SIZE * texel_size];
+                    if (header.format == TexelFormat::RGBA16_SFLOAT) {
+                        Math::FloatToHalf(texels, reinterpret_cast<u16 *>(dst), static_cast<size_t>(row_width) * 4);
+                    } else {
+                        Math::QuantizeUnorm8(texels, dst, static_cast<size_t>(row_width) * 4);
+                    }
+                    for (u32 x = row_width; x < TEXTURE_TILE_SIZE; x++) {
+                        std::memcpy(dst + x * texel_size, dst + (row_width - 1) * texel_size, texel_size);
+                    }
+                }
+                file.write(reinterpret_cast<const char *>(tile.data()), static_cast<std::streamsize>(tile.size()));
+            }
+        }
+
+        // 2x2 box filter
+        const u32 next_width = std::max(width / 2, 1u);
+        const u32 next_height = std::max(height / 2, 1u);
+        next_level.resize(static_cast<size_t>(next_width) * next_height * 4);
+        for (u32 y = 0; y < next_height; y++) {
+            const u32 y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+            for (u32 x = 0; x < next_width; x++) {
+                const u32 x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                for (u32 c = 0; c < 4; c++) {
+                    next_level[(static_cast<size_t>(y) * next_width + x) * 4 + c] =
+                        0.25f * (level[(static_cast<size_t>(y0) * width + x0) * 4 + c] +
+                                 level[(static_cast<size_t>(y0) * width + x1) * 4 + c] +
+                                 level[(static_cast<size_t>(y1) * width + x0) * 4 + c] +
+                                 level[(static_cast<size_t>(y1) * width + x1) * 4 + c]);
+                }
+            }
+        }
+        level.swap(next_level);
+        width = next_width;
+        height = next_height;
+    }
+
+    if (!file) {
+        LOG_ERROR("failed to write tiled texture: {}", destination.string());
+        return false;
+    }
+    return true;
+}
+
+} // namespace Fract
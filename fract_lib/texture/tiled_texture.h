@@ -0,0 +1,80 @@
+/*****************************************************************//**
+ * \file   tiled_texture.h
+ * \brief  on-disk mip chain split into fixed size tiles
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+
+#include "utils/defination.h"
+
+namespace Fract {
+
+static constexpr u32 TEXTURE_TILE_SIZE = 64;
+static constexpr u32 TILED_TEXTURE_MAGIC = 0x54585446; // "FTXT"
+static constexpr u32 TILED_TEXTURE_VERSION = 1;
+
+enum class TexelFormat : u32 { RGBA8_UNORM, RGBA16_SFLOAT };
+
+inline u32 GetTexelSize(TexelFormat format) {
+    return format == TexelFormat::RGBA16_SFLOAT ? 8 : 4;
+}
+
+// followed by the tiles of every mip level, row by row, edge tiles are padded
+// to full size by clamping
+struct TiledTextureHeader {
+    u32 magic;
+    u32 version;
+    TexelFormat format;
+    u32 width;
+    u32 height;
+    u32 mip_count;
+};
+
+class TiledTextureFile {
+  public:
+    TiledTextureFile() noexcept;
+    ~TiledTextureFile() noexcept;
+
+    TiledTextureFile(const TiledTextureFile &rhs) noexcept = delete;
+    TiledTextureFile &operator=(const TiledTextureFile &rhs) noexcept = delete;
+    TiledTextureFile(TiledTextureFile &&rhs) noexcept = delete;
+    TiledTextureFile &operator=(TiledTextureFile &&rhs) noexcept = delete;
+
+    bool Open(const std::filesystem::path &file_name);
+
+    // thread safe and lock free, concurrent reads of one file don't wait for each other. dst must hold GetTileSize()
+    // bytes.
+    bool ReadTile(u32 mip, u32 tile_x, u32 tile_y, void *dst);
+
+    TexelFormat GetFormat() const noexcept { return m_header.format; }
+    u32 GetMipCount() const noexcept { return m_header.mip_count; }
+    u32 GetWidth(u32 mip = 0) const noexcept { return std::max(m_header.width >> mip, 1u); }
+    u32 GetHeight(u32 mip = 0) const noexcept { return std::max(m_header.height >> mip, 1u); }
+    u32 GetTileCountX(u32 mip) const noexcept { return (GetWidth(mip) + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE; }
+    u32 GetTileCountY(u32 mip) const noexcept { return (GetHeight(mip) + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE; }
+    u64 GetTileSize() const noexcept {
+        return static_cast<u64>(TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE * GetTexelSize(m_header.format);
+    }
+
+  private:
+    // positional read, doesn't move a shared file pointer
+    bool ReadAt(u64 offset, void *dst, u64 size);
+    void Close() noexcept;
+
+    intptr_t m_handle{-1}; // HANDLE opened for overlapped io on windows, file descriptor elsewhere
+    TiledTextureHeader m_header{};
+    Container::Array<u64> m_first_tile; // index of the first tile of each mip
+};
+
+// any image stb_image can decode -> tiled mip chain, hdr images are stored as
+// half float, everything else as rgba8
+bool ConvertToTiledTexture(const std::filesystem::path &source, const std::filesystem::path &destination);
+
+} // namespace Fract
@@ -0,0 +1,230 @@
+/*****************************************************************//**
+ * \file   ConcurrentQueue.h
+ * \brief  bounded lock free mpmc and spsc ring buffers
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Fract::Container {
+
+// indices written by different threads live on their own line so producers and consumers don't false share
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+namespace Detail {
+
+inline size_t RoundUpToPowerOfTwo(size_t value) noexcept {
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace Detail
+
+// dmitry vyukov's bounded queue, every slot carries a sequence number that tells producers and consumers whose turn
+// it is. push and pop are one compare exchange on their index plus one store on the slot, a full or empty queue fails
+// instead of blocking. the capacity is rounded up to a power of two. T must not throw when constructed, move assigned
+// or destroyed.
+template <typename T> class MpmcQueue {
+    static_assert(std::is_nothrow_move_assignable_v<T> && std::is_nothrow_destructible_v<T>);
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+
+    explicit MpmcQueue(size_type capacity, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_resource(resource), m_mask(Detail::RoundUpToPowerOfTwo(capacity) - 1) {
+        m_cells = static_cast<Cell *>(m_resource->allocate(sizeof(Cell) * (m_mask + 1), alignof(Cell)));
+        for (size_type i = 0; i <= m_mask; i++) {
+            new (&m_cells[i]) Cell();
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcQueue() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            const size_type enqueue_position = m_enqueue_position.load(std::memory_order_relaxed);
+            for (size_type position = m_dequeue_position.load(std::memory_order_relaxed);
+                 position != enqueue_position; position++) {
+                std::launder(reinterpret_cast<T *>(m_cells[position & m_mask].storage))->~T();
+            }
+        }
+        std::destroy_n(m_cells, m_mask + 1);
+        m_resource->deallocate(m_cells, sizeof(Cell) * (m_mask + 1), alignof(Cell));
+    }
+
+    MpmcQueue(const MpmcQueue &rhs) noexcept = delete;
+    MpmcQueue &operator=(const MpmcQueue &rhs) noexcept = delete;
+    MpmcQueue(MpmcQueue &&rhs) noexcept = delete;
+    MpmcQueue &operator=(MpmcQueue &&rhs) noexcept = delete;
+
+    bool try_push(const T &value) { return try_emplace(value); }
+    bool try_push(T &&value) { return try_emplace(std::move(value)); }
+
+    // false if the queue is full
+    template <typename... Args> bool try_emplace(Args &&...args) {
+        size_type position = m_enqueue_position.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[position & m_mask];
+            const size_type sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+            if (difference == 0) {
+                if (m_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false; // the slot still holds the value pushed one lap earlier
+            } else {
+                position = m_enqueue_position.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) T(std::forward<Args>(args)...);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // false if the queue is empty
+    bool try_pop(T &value) noexcept {
+        size_type position = m_dequeue_position.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[position & m_mask];
+            const size_type sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+            if (difference == 0) {
+                if (m_dequeue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false;
+            } else {
+                position = m_dequeue_position.load(std::memory_order_relaxed);
+            }
+        }
+        T *stored = std::launder(reinterpret_cast<T *>(cell->storage));
+        value = std::move(*stored);
+        stored->~T();
+        cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // approximate while other threads push or pop
+    size_type size() const noexcept {
+        const size_type dequeue_position = m_dequeue_position.load(std::memory_order_relaxed);
+        const size_type enqueue_position = m_enqueue_position.load(std::memory_order_relaxed);
+        return enqueue_position > dequeue_position ? enqueue_position - dequeue_position : 0;
+    }
+    bool empty() const noexcept { return size() == 0; }
+    size_type capacity() const noexcept { return m_mask + 1; }
+
+  private:
+    struct Cell {
+        std::atomic<size_type> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::pmr::memory_resource *m_resource{};
+    Cell *m_cells{};
+    size_type m_mask{};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> m_enqueue_position{};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> m_dequeue_position{};
+};
+
+// single producer single consumer ring. each side keeps a cached copy of the other side's index and only reloads it
+// when the ring looks full or empty, so steady streaming touches the shared lines once per lap. the capacity is
+// rounded up to a power of two, the same rules for T as MpmcQueue.
+template <typename T> class SpscQueue {
+    static_assert(std::is_nothrow_move_assignable_v<T> && std::is_nothrow_destructible_v<T>);
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+
+    explicit SpscQueue(size_type capacity, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_resource(resource), m_mask(Detail::RoundUpToPowerOfTwo(capacity) - 1) {
+        m_slots = static_cast<Slot *>(m_resource->allocate(sizeof(Slot) * (m_mask + 1), alignof(Slot)));
+    }
+
+    ~SpscQueue() noexcept {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            const size_type tail = m_tail.load(std::memory_order_relaxed);
+            for (size_type head = m_head.load(std::memory_order_relaxed); head != tail; head++) {
+                std::launder(reinterpret_cast<T *>(m_slots[head & m_mask].storage))->~T();
+            }
+        }
+        m_resource->deallocate(m_slots, sizeof(Slot) * (m_mask + 1), alignof(Slot));
+    }
+
+    SpscQueue(const SpscQueue &rhs) noexcept = delete;
+    SpscQueue &operator=(const SpscQueue &rhs) noexcept = delete;
+    SpscQueue(SpscQueue &&rhs) noexcept = delete;
+    SpscQueue &operator=(SpscQueue &&rhs) noexcept = delete;
+
+    // producer thread only
+    bool try_push(const T &value) { return try_emplace(value); }
+    bool try_push(T &&value) { return try_emplace(std::move(value)); }
+
+    // producer thread only, false if the queue is full
+    template <typename... Args> bool try_emplace(Args &&...args) {
+        const size_type tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cached_head > m_mask) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if (tail - m_cached_head > m_mask) {
+                return false;
+            }
+        }
+        new (m_slots[tail & m_mask].storage) T(std::forward<Args>(args)...);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer thread only, false if the queue is empty
+    bool try_pop(T &value) noexcept {
+        const size_type head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cached_tail) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cached_tail) {
+                return false;
+            }
+        }
+        T *stored = std::launder(reinterpret_cast<T *>(m_slots[head & m_mask].storage));
+        value = std::move(*stored);
+        stored->~T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // exact on either side's own thread for its own operations, approximate elsewhere
+    size_type size() const noexcept {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+    bool empty() const noexcept { return size() == 0; }
+    size_type capacity() const noexcept { return m_mask + 1; }
+
+  private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::pmr::memory_resource *m_resource{};
+    Slot *m_slots{};
+    size_type m_mask{};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> m_tail{}; // written by the producer
+    size_type m_cached_head{};
+    alignas(CACHE_LINE_SIZE) std::atomic<size_type> m_head{}; // written by the consumer
+    size_type m_cached_tail{};
+};
+
+} // namespace Fract::Container
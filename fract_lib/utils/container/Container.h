@@ -17,15 +17,23 @@
 #include <vector>
 
 #include "../memory/Memory.h"
+#include "ConcurrentQueue.h"
+#include "FlatHashMap.h"
+#include "NameId.h"
+#include "SmallArray.h"
 
 namespace Fract::Container {
 
 using String = std::pmr::string;
 template <typename T, size_t size> using FixedArray = std::array<T, size>;
 template <typename T> using Array = std::pmr::vector<T>;
+// SmallArray<T, N> (SmallArray.h) for short lists built per call
 template <typename T> using Set = std::pmr::set<T>;
 template <typename T> using HashSet = std::pmr::unordered_set<T>;
 template <typename Key, typename Val> using Map = std::pmr::map<Key, Val>;
 template <typename Key, typename Val> using HashMap = std::pmr::unordered_map<Key, Val>;
+// FlatHashMap and FlatHashSet (FlatHashMap.h) for lookup heavy tables, HashMap when references must stay stable
+// MpmcQueue and SpscQueue (ConcurrentQueue.h) to hand work between threads without a lock
+// NameId (NameId.h) instead of String for keys that are only compared, such as binding names
 
 } // namespace Fract::Container
\ No newline at end of file
@@ -0,0 +1,541 @@
+/*****************************************************************//**
+ * \file   FlatHashMap.h
+ * \brief  open addressing hash map and set probed a group of 16 slots at a time
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLAT_HASH_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Fract::Container {
+
+// std::hash, strings hash through string_view so they can be looked up without building a key
+template <typename Key> struct FlatHash {
+    size_t operator()(const Key &key) const noexcept { return std::hash<Key>{}(key); }
+};
+
+template <typename Char, typename Traits, typename Allocator>
+struct FlatHash<std::basic_string<Char, Traits, Allocator>> {
+    using is_transparent = void;
+    size_t operator()(std::basic_string_view<Char, Traits> key) const noexcept {
+        return std::hash<std::basic_string_view<Char, Traits>>{}(key);
+    }
+};
+
+namespace Detail {
+
+// control byte of every slot, full slots store the low 7 bits of the hash
+using ControlByte = int8_t;
+static constexpr ControlByte CONTROL_EMPTY = -128;
+static constexpr ControlByte CONTROL_DELETED = -2;
+static constexpr size_t GROUP_WIDTH = 16;
+
+inline uint32_t CountTrailingZeros(uint32_t mask) noexcept {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<uint32_t>(index);
+#else
+    return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+}
+
+// std::hash of integers is the identity, spread it so both the probe start and the 7 control bits are usable
+inline size_t MixHash(size_t hash) noexcept {
+    const uint64_t product = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ull;
+    return static_cast<size_t>(product ^ (product >> 32));
+}
+
+// 16 control bytes, every match returns one bit per slot
+class Group {
+  public:
+    explicit Group(const ControlByte *control) noexcept {
+#ifdef FLAT_HASH_USE_SSE2
+        m_control = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control));
+#else
+        std::memcpy(m_control, control, GROUP_WIDTH);
+#endif
+    }
+
+    uint32_t Match(ControlByte h2) const noexcept {
+#ifdef FLAT_HASH_USE_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), m_control)));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_WIDTH; i++) {
+            mask |= static_cast<uint32_t>(m_control[i] == h2) << i;
+        }
+        return mask;
+#endif
+    }
+
+    uint32_t MatchEmpty() const noexcept { return Match(CONTROL_EMPTY); }
+
+    // empty and deleted are the only negative values below -1
+    uint32_t MatchEmptyOrDeleted() const noexcept {
+#ifdef FLAT_HASH_USE_SSE2
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), m_control)));
+#else
+        uint32_t mask = 0;
+        for (uint32_t i = 0; i < GROUP_WIDTH; i++) {
+            mask |= static_cast<uint32_t>(m_control[i] < -1) << i;
+        }
+        return mask;
+#endif
+    }
+
+  private:
+#ifdef FLAT_HASH_USE_SSE2
+    __m128i m_control;
+#else
+    ControlByte m_control[GROUP_WIDTH];
+#endif
+};
+
+template <typename Key, typename Val> struct FlatMapPolicy {
+    using key_type = Key;
+    using value_type = std::pair<const Key, Val>;
+    static const Key &GetKey(const value_type &value) noexcept { return value.first; }
+    // rehash moves the key out of a slot that is destroyed right after
+    static std::pair<Key &&, Val &&> Move(value_type &value) noexcept {
+        return {std::move(const_cast<Key &>(value.first)), std::move(value.second)};
+    }
+};
+
+template <typename Key> struct FlatSetPolicy {
+    using key_type = Key;
+    using value_type = Key;
+    static const Key &GetKey(const value_type &value) noexcept { return value; }
+    static Key &&Move(value_type &value) noexcept { return std::move(value); }
+};
+
+// slots and control bytes live in one block from a pmr resource. the control array has GROUP_WIDTH - 1 bytes more
+// mirroring the first ones so a group can be loaded at any slot. the load factor is kept at 7/8, erase leaves a
+// tombstone that is dropped on the next rehash.
+template <typename Policy, typename Hash, typename KeyEqual> class FlatHashTable {
+  public:
+    using key_type = typename Policy::key_type;
+    using value_type = typename Policy::value_type;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+    template <bool Const> class Iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename Policy::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+        Iterator() noexcept = default;
+        template <bool IsConst = Const, typename = std::enable_if_t<IsConst>>
+        Iterator(const Iterator<false> &rhs) noexcept : m_control(rhs.m_control), m_slot(rhs.m_slot), m_end(rhs.m_end) {}
+
+        reference operator*() const noexcept { return *m_slot; }
+        pointer operator->() const noexcept { return m_slot; }
+        Iterator &operator++() noexcept {
+            ++m_control;
+            ++m_slot;
+            SkipEmpty();
+            return *this;
+        }
+        Iterator operator++(int) noexcept {
+            Iterator result = *this;
+            ++*this;
+            return result;
+        }
+        bool operator==(const Iterator &rhs) const noexcept { return m_slot == rhs.m_slot; }
+        bool operator!=(const Iterator &rhs) const noexcept { return m_slot != rhs.m_slot; }
+
+      private:
+        friend class FlatHashTable;
+        template <bool> friend class Iterator;
+
+        Iterator(const Detail::ControlByte *control, pointer slot, const Detail::ControlByte *end) noexcept
+            : m_control(control), m_slot(slot), m_end(end) {}
+
+        void SkipEmpty() noexcept {
+            while (m_control != m_end && *m_control < 0) {
+                ++m_control;
+                ++m_slot;
+            }
+        }
+
+        const Detail::ControlByte *m_control{};
+        pointer m_slot{};
+        const Detail::ControlByte *m_end{};
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    FlatHashTable(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) noexcept
+        : m_allocator(resource) {}
+    FlatHashTable(const allocator_type &allocator) noexcept : m_allocator(allocator) {}
+    ~FlatHashTable() noexcept { Destroy(); }
+
+    FlatHashTable(const FlatHashTable &rhs)
+        : m_allocator(rhs.m_allocator.select_on_container_copy_construction()), m_hash(rhs.m_hash), m_equal(rhs.m_equal) {
+        CopyFrom(rhs);
+    }
+    FlatHashTable &operator=(const FlatHashTable &rhs) {
+        if (this != &rhs) {
+            clear();
+            CopyFrom(rhs);
+        }
+        return *this;
+    }
+    FlatHashTable(FlatHashTable &&rhs) noexcept
+        : m_allocator(rhs.m_allocator), m_hash(std::move(rhs.m_hash)), m_equal(std::move(rhs.m_equal)) {
+        Steal(rhs);
+    }
+    FlatHashTable &operator=(FlatHashTable &&rhs) {
+        if (this == &rhs) {
+            return *this;
+        }
+        if (m_allocator == rhs.m_allocator) {
+            Destroy();
+            Steal(rhs);
+        } else {
+            // memory of another resource can't be adopted
+            clear();
+            reserve(rhs.m_size);
+            for (value_type &value : rhs) {
+                InsertUnique(Detail::MixHash(m_hash(Policy::GetKey(value))), Policy::Move(value));
+            }
+            rhs.clear();
+        }
+        return *this;
+    }
+
+    iterator begin() noexcept {
+        iterator it{m_control, m_slots, m_control + m_capacity};
+        it.SkipEmpty();
+        return it;
+    }
+    iterator end() noexcept { return {m_control + m_capacity, m_slots + m_capacity, m_control + m_capacity}; }
+    const_iterator begin() const noexcept { return const_cast<FlatHashTable *>(this)->begin(); }
+    const_iterator end() const noexcept { return const_cast<FlatHashTable *>(this)->end(); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    bool empty() const noexcept { return m_size == 0; }
+    size_type size() const noexcept { return m_size; }
+    size_type capacity() const noexcept { return m_capacity; }
+    allocator_type get_allocator() const noexcept { return m_allocator; }
+
+    void clear() noexcept {
+        if (m_capacity == 0) {
+            return;
+        }
+        for (size_t i = 0; i < m_capacity; i++) {
+            if (m_control[i] >= 0) {
+                std::allocator_traits<allocator_type>::destroy(m_allocator, m_slots + i);
+            }
+        }
+        std::memset(m_control, static_cast<uint8_t>(Detail::CONTROL_EMPTY), m_capacity + Detail::GROUP_WIDTH - 1);
+        m_size = 0;
+        m_growth_left = GetMaxLoad(m_capacity);
+    }
+
+    void reserve(size_type count) {
+        if (count > m_size + m_growth_left) {
+            Rehash(GetCapacityFor(count));
+        }
+    }
+
+    // a key type other than key_type needs a transparent hasher, e.g. string_view for string keys
+    template <typename K> iterator find(const K &key) noexcept {
+        const size_t index = Find(key, Detail::MixHash(m_hash(key)));
+        return index == NOT_FOUND ? end() : MakeIterator(index);
+    }
+    template <typename K> const_iterator find(const K &key) const noexcept {
+        return const_cast<FlatHashTable *>(this)->find(key);
+    }
+    template <typename K> bool contains(const K &key) const noexcept {
+        return Find(key, Detail::MixHash(m_hash(key))) != NOT_FOUND;
+    }
+    template <typename K> size_type count(const K &key) const noexcept { return contains(key) ? 1 : 0; }
+
+    std::pair<iterator, bool> insert(const value_type &value) { return emplace(value); }
+    std::pair<iterator, bool> insert(value_type &&value) { return emplace(std::move(value)); }
+
+    template <typename... Args> std::pair<iterator, bool> emplace(Args &&...args) {
+        // the key is only known once the value is built, build it in the slot it would take and keep it if unique
+        alignas(value_type) unsigned char storage[sizeof(value_type)];
+        value_type *value = reinterpret_cast<value_type *>(storage);
+        std::allocator_traits<allocator_type>::construct(m_allocator, value, std::forward<Args>(args)...);
+        const key_type &key = Policy::GetKey(*value);
+        const size_t hash = Detail::MixHash(m_hash(key));
+        size_t index = Find(key, hash);
+        const bool inserted = index == NOT_FOUND;
+        if (inserted) {
+            index = PrepareInsert(hash);
+            std::allocator_traits<allocator_type>::construct(m_allocator, m_slots + index, Policy::Move(*value));
+        }
+        std::allocator_traits<allocator_type>::destroy(m_allocator, value);
+        return {MakeIterator(index), inserted};
+    }
+
+    template <typename K> size_type erase(const K &key) noexcept {
+        const size_t index = Find(key, Detail::MixHash(m_hash(key)));
+        if (index == NOT_FOUND) {
+            return 0;
+        }
+        EraseAt(index);
+        return 1;
+    }
+    iterator erase(const_iterator position) noexcept {
+        const size_t index = static_cast<size_t>(position.m_slot - m_slots);
+        EraseAt(index);
+        iterator next = MakeIterator(index);
+        next.SkipEmpty();
+        return next;
+    }
+    iterator erase(iterator position) noexcept { return erase(const_iterator(position)); }
+
+  protected:
+    static constexpr size_t NOT_FOUND = ~size_t(0);
+
+    iterator MakeIterator(size_t index) noexcept {
+        return {m_control + index, m_slots + index, m_control + m_capacity};
+    }
+
+    // slot holding the key or NOT_FOUND
+    template <typename K> size_t Find(const K &key, size_t hash) const noexcept {
+        if (m_capacity == 0) {
+            return NOT_FOUND;
+        }
+        const size_t mask = m_capacity - 1;
+        const auto h2 = static_cast<Detail::ControlByte>(hash & 0x7F);
+        size_t position = (hash >> 7) & mask;
+        for (size_t step = Detail::GROUP_WIDTH;; step += Detail::GROUP_WIDTH) {
+            const Detail::Group group(m_control + position);
+            for (uint32_t match = group.Match(h2); match; match &= match - 1) {
+                const size_t index = (position + Detail::CountTrailingZeros(match)) & mask;
+                if (m_equal(Policy::GetKey(m_slots[index]), key)) {
+                    return index;
+                }
+            }
+            if (group.MatchEmpty()) {
+                return NOT_FOUND;
+            }
+            position = (position + step) & mask;
+        }
+    }
+
+    // slot for a key known to be absent, grows the table when no slot is left
+    size_t PrepareInsert(size_t hash) {
+        if (m_capacity == 0) {
+            Rehash(Detail::GROUP_WIDTH);
+        }
+        size_t index = FindFirstNonFull(hash);
+        if (m_growth_left == 0 && m_control[index] != Detail::CONTROL_DELETED) {
+            // rehash in place when half of the used slots are tombstones
+            Rehash(m_size * 2 + 2 <= GetMaxLoad(m_capacity) ? m_capacity : GetCapacityFor(m_size + 1));
+            index = FindFirstNonFull(hash);
+        }
+        if (m_control[index] == Detail::CONTROL_EMPTY) {
+            m_growth_left--;
+        }
+        SetControl(index, static_cast<Detail::ControlByte>(hash & 0x7F));
+        m_size++;
+        return index;
+    }
+
+    template <typename... Args> void InsertUnique(size_t hash, Args &&...args) {
+        const size_t index = PrepareInsert(hash);
+        std::allocator_traits<allocator_type>::construct(m_allocator, m_slots + index, std::forward<Args>(args)...);
+    }
+
+    allocator_type m_allocator;
+    Hash m_hash{};
+    KeyEqual m_equal{};
+
+  private:
+    static size_t GetMaxLoad(size_t capacity) noexcept { return capacity - capacity / 8; }
+
+    static size_t GetCapacityFor(size_t count) noexcept {
+        size_t capacity = Detail::GROUP_WIDTH;
+        while (GetMaxLoad(capacity) < count) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    size_t FindFirstNonFull(size_t hash) const noexcept {
+        const size_t mask = m_capacity - 1;
+        size_t position = (hash >> 7) & mask;
+        for (size_t step = Detail::GROUP_WIDTH;; step += Detail::GROUP_WIDTH) {
+            const uint32_t match = Detail::Group(m_control + position).MatchEmptyOrDeleted();
+            if (match) {
+                return (position + Detail::CountTrailingZeros(match)) & mask;
+            }
+            position = (position + step) & mask;
+        }
+    }
+
+    void SetControl(size_t index, Detail::ControlByte value) noexcept {
+        m_control[index] = value;
+        if (index < Detail::GROUP_WIDTH - 1) {
+            m_control[m_capacity + index] = value;
+        }
+    }
+
+    void EraseAt(size_t index) noexcept {
+        std::allocator_traits<allocator_type>::destroy(m_allocator, m_slots + index);
+        SetControl(index, Detail::CONTROL_DELETED);
+        m_size--;
+    }
+
+    static size_t GetSlotOffset(size_t capacity) noexcept {
+        const size_t control_bytes = capacity + Detail::GROUP_WIDTH - 1;
+        return (control_bytes + alignof(value_type) - 1) / alignof(value_type) * alignof(value_type);
+    }
+
+    static size_t GetBlockSize(size_t capacity) noexcept {
+        return GetSlotOffset(capacity) + capacity * sizeof(value_type);
+    }
+
+    static constexpr size_t GetBlockAlignment() noexcept {
+        return alignof(value_type) > alignof(std::max_align_t) ? alignof(value_type) : alignof(std::max_align_t);
+    }
+
+    void Rehash(size_t capacity) {
+        Detail::ControlByte *old_control = m_control;
+        value_type *old_slots = m_slots;
+        const size_t old_capacity = m_capacity;
+
+        auto *block = static_cast<unsigned char *>(
+            m_allocator.resource()->allocate(GetBlockSize(capacity), GetBlockAlignment()));
+        m_control = reinterpret_cast<Detail::ControlByte *>(block);
+        m_slots = reinterpret_cast<value_type *>(block + GetSlotOffset(capacity));
+        m_capacity = capacity;
+        std::memset(m_control, static_cast<uint8_t>(Detail::CONTROL_EMPTY), capacity + Detail::GROUP_WIDTH - 1);
+        m_growth_left = GetMaxLoad(capacity);
+        m_size = 0;
+
+        for (size_t i = 0; i < old_capacity; i++) {
+            if (old_control[i] >= 0) {
+                InsertUnique(Detail::MixHash(m_hash(Policy::GetKey(old_slots[i]))), Policy::Move(old_slots[i]));
+                std::allocator_traits<allocator_type>::destroy(m_allocator, old_slots + i);
+            }
+        }
+        if (old_capacity) {
+            m_allocator.resource()->deallocate(old_control, GetBlockSize(old_capacity), GetBlockAlignment());
+        }
+    }
+
+    void CopyFrom(const FlatHashTable &rhs) {
+        reserve(rhs.m_size);
+        for (const value_type &value : rhs) {
+            InsertUnique(Detail::MixHash(m_hash(Policy::GetKey(value))), value);
+        }
+    }
+
+    void Steal(FlatHashTable &rhs) noexcept {
+        m_control = std::exchange(rhs.m_control, nullptr);
+        m_slots = std::exchange(rhs.m_slots, nullptr);
+        m_capacity = std::exchange(rhs.m_capacity, 0);
+        m_size = std::exchange(rhs.m_size, 0);
+        m_growth_left = std::exchange(rhs.m_growth_left, 0);
+    }
+
+    void Destroy() noexcept {
+        if (m_capacity == 0) {
+            return;
+        }
+        clear();
+        m_allocator.resource()->deallocate(m_control, GetBlockSize(m_capacity), GetBlockAlignment());
+        m_control = nullptr;
+        m_slots = nullptr;
+        m_capacity = 0;
+        m_growth_left = 0;
+    }
+
+    Detail::ControlByte *m_control{};
+    value_type *m_slots{};
+    size_t m_capacity{}; // power of two, 0 or at least GROUP_WIDTH
+    size_t m_size{};
+    size_t m_growth_left{}; // inserts into empty slots before the next rehash
+};
+
+} // namespace Detail
+
+// flat replacement for pmr::unordered_map, pointers and iterators are invalidated by inserts
+template <typename Key, typename Val, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<>>
+class FlatHashMap : public Detail::FlatHashTable<Detail::FlatMapPolicy<Key, Val>, Hash, KeyEqual> {
+    using Base = Detail::FlatHashTable<Detail::FlatMapPolicy<Key, Val>, Hash, KeyEqual>;
+
+  public:
+    using mapped_type = Val;
+    using typename Base::iterator;
+    using typename Base::const_iterator;
+    using Base::Base;
+
+    template <typename... Args> std::pair<iterator, bool> try_emplace(const Key &key, Args &&...args) {
+        return TryEmplace(key, std::forward<Args>(args)...);
+    }
+    template <typename... Args> std::pair<iterator, bool> try_emplace(Key &&key, Args &&...args) {
+        return TryEmplace(std::move(key), std::forward<Args>(args)...);
+    }
+
+    Val &operator[](const Key &key) { return try_emplace(key).first->second; }
+    Val &operator[](Key &&key) { return try_emplace(std::move(key)).first->second; }
+
+    template <typename K> Val &at(const K &key) {
+        auto it = this->find(key);
+        if (it == this->end()) {
+            throw std::out_of_range("FlatHashMap::at");
+        }
+        return it->second;
+    }
+    template <typename K> const Val &at(const K &key) const { return const_cast<FlatHashMap *>(this)->at(key); }
+
+  private:
+    // unlike emplace nothing is built when the key exists
+    template <typename K, typename... Args> std::pair<iterator, bool> TryEmplace(K &&key, Args &&...args) {
+        const size_t hash = Detail::MixHash(this->m_hash(key));
+        size_t index = this->Find(key, hash);
+        if (index != Base::NOT_FOUND) {
+            return {this->MakeIterator(index), false};
+        }
+        index = this->PrepareInsert(hash);
+        std::allocator_traits<typename Base::allocator_type>::construct(
+            this->m_allocator, &*this->MakeIterator(index), std::piecewise_construct,
+            std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+        return {this->MakeIterator(index), true};
+    }
+};
+
+template <typename Key, typename Hash = FlatHash<Key>, typename KeyEqual = std::equal_to<>>
+class FlatHashSet : public Detail::FlatHashTable<Detail::FlatSetPolicy<Key>, Hash, KeyEqual> {
+    using Base = Detail::FlatHashTable<Detail::FlatSetPolicy<Key>, Hash, KeyEqual>;
+
+  public:
+    using Base::Base;
+};
+
+} // namespace Fract::Container
@@ -0,0 +1,72 @@
+/*****************************************************************//**
+ * \file   NameId.cpp
+ * \brief  debug reverse table of registered names
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "NameId.h"
+
+#include "../log/log.h"
+
+#ifndef NDEBUG
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#endif // !NDEBUG
+
+namespace Fract::Container {
+
+#ifndef NDEBUG
+namespace {
+
+// strings are never removed, the views handed out by GetName() stay valid
+struct NameRegistry {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::string> names;
+};
+
+NameRegistry &GetRegistry() noexcept {
+    static NameRegistry registry;
+    return registry;
+}
+
+} // namespace
+#endif // !NDEBUG
+
+NameId NameId::Register(std::string_view name) noexcept {
+    NameId id(name);
+#ifndef NDEBUG
+    NameRegistry &registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    const auto [it, inserted] = registry.names.try_emplace(id.m_hash, name);
+    if (!inserted && it->second != name) {
+        ReportCollision(it->second, name);
+    }
+    // the registry's copy outlives the caller's string
+    id.m_name = it->second;
+#endif // !NDEBUG
+    return id;
+}
+
+void NameId::ReportCollision(std::string_view name, std::string_view other) noexcept {
+    LOG_ERROR("name id collision between {} and {}", name, other);
+}
+
+std::string_view NameId::GetName() const noexcept {
+#ifndef NDEBUG
+    if (!m_name.empty()) {
+        return m_name;
+    }
+    NameRegistry &registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    const auto it = registry.names.find(m_hash);
+    if (it != registry.names.end()) {
+        return it->second;
+    }
+#endif // !NDEBUG
+    return {};
+}
+
+} // namespace Fract::Container
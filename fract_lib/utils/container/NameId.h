@@ -0,0 +1,93 @@
+/*****************************************************************//**
+ * \file   NameId.h
+ * \brief  compile time hashed string ids
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+
+namespace Fract::Container {
+
+// 64 bit fnv-1a hash of a name, compared and hashed as one integer. literals are hashed at compile time with
+// "g_view"_id, names only known at runtime (shader reflection) go through Register(). debug builds carry the string
+// of literal and registered ids, so GetName() works for both and comparing two different names sharing a hash is
+// reported.
+class NameId {
+  public:
+    constexpr NameId() noexcept = default;
+    constexpr explicit NameId(std::string_view name) noexcept : m_hash(Hash(name)) {}
+
+    // name must have static storage, used by "name"_id
+    static constexpr NameId FromLiteral(std::string_view name) noexcept {
+        NameId id(name);
+#ifndef NDEBUG
+        id.m_name = name;
+#endif // !NDEBUG
+        return id;
+    }
+
+    // hashes and, in debug builds, records the string for GetName()
+    static NameId Register(std::string_view name) noexcept;
+
+    // the literal or registered string in debug builds, empty in release or for an unregistered id
+    std::string_view GetName() const noexcept;
+
+    constexpr uint64_t GetHash() const noexcept { return m_hash; }
+    constexpr bool IsValid() const noexcept { return m_hash != 0; }
+
+    static constexpr uint64_t Hash(std::string_view name) noexcept {
+        uint64_t hash = FNV_OFFSET_BASIS;
+        for (char c : name) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    constexpr bool operator==(const NameId &rhs) const noexcept {
+#ifndef NDEBUG
+        if (m_hash == rhs.m_hash && !m_name.empty() && !rhs.m_name.empty() && m_name != rhs.m_name) {
+            ReportCollision(m_name, rhs.m_name);
+        }
+#endif // !NDEBUG
+        return m_hash == rhs.m_hash;
+    }
+    constexpr bool operator!=(const NameId &rhs) const noexcept { return m_hash != rhs.m_hash; }
+    constexpr bool operator<(const NameId &rhs) const noexcept { return m_hash < rhs.m_hash; }
+
+  private:
+    static constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+    static void ReportCollision(std::string_view name, std::string_view other) noexcept;
+
+    uint64_t m_hash{};
+#ifndef NDEBUG
+    std::string_view m_name{};
+#endif // !NDEBUG
+};
+
+} // namespace Fract::Container
+
+namespace Fract {
+
+// in Fract so engine code can write "name"_id without a using declaration
+constexpr Container::NameId operator""_id(const char *name, size_t length) noexcept {
+    return Container::NameId::FromLiteral(std::string_view(name, length));
+}
+
+} // namespace Fract
+
+namespace std {
+
+template <> struct hash<Fract::Container::NameId> {
+    size_t operator()(const Fract::Container::NameId &id) const noexcept { return static_cast<size_t>(id.GetHash()); }
+};
+
+} // namespace std
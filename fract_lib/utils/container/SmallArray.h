@@ -0,0 +1,208 @@
+/*****************************************************************//**
+ * \file   SmallArray.h
+ * \brief  vector with inline storage for the first N elements
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Fract::Container {
+
+// up to N elements live inside the object, more move everything to one block from the memory resource. meant for
+// small per call descriptions (barriers, submits, attachments) that are built every frame. moving an inline array
+// moves the elements, iterators are invalidated by growth just like a vector.
+template <typename T, size_t N> class SmallArray {
+    static_assert(N > 0, "use Array without inline storage");
+
+  public:
+    using value_type = T;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T &;
+    using const_reference = const T &;
+    using pointer = T *;
+    using const_pointer = const T *;
+    using iterator = T *;
+    using const_iterator = const T *;
+    using allocator_type = std::pmr::polymorphic_allocator<T>;
+
+    // the default constructor stays implicit so aggregates holding a SmallArray can be brace initialized
+    SmallArray() noexcept : m_resource(std::pmr::get_default_resource()) {}
+    explicit SmallArray(std::pmr::memory_resource *resource) noexcept : m_resource(resource) {}
+    SmallArray(std::initializer_list<T> values, std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_resource(resource) {
+        assign(values.begin(), values.end());
+    }
+    explicit SmallArray(size_type count, const T &value = T(),
+               std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_resource(resource) {
+        resize(count, value);
+    }
+    ~SmallArray() noexcept {
+        clear();
+        Deallocate();
+    }
+
+    SmallArray(const SmallArray &rhs) : m_resource(std::pmr::get_default_resource()) {
+        assign(rhs.begin(), rhs.end());
+    }
+    SmallArray &operator=(const SmallArray &rhs) {
+        if (this != &rhs) {
+            assign(rhs.begin(), rhs.end());
+        }
+        return *this;
+    }
+    SmallArray(SmallArray &&rhs) noexcept : m_resource(rhs.m_resource) { MoveFrom(rhs); }
+    // allocates when the block belongs to another resource
+    SmallArray &operator=(SmallArray &&rhs) {
+        if (this != &rhs) {
+            clear();
+            if (m_resource == rhs.m_resource || rhs.IsInline()) {
+                Deallocate();
+                MoveFrom(rhs);
+            } else {
+                // the block belongs to another resource
+                reserve(rhs.m_size);
+                std::uninitialized_move(rhs.begin(), rhs.end(), m_data);
+                m_size = rhs.m_size;
+                rhs.clear();
+            }
+        }
+        return *this;
+    }
+
+    template <typename InputIt> void assign(InputIt first, InputIt last) {
+        clear();
+        reserve(static_cast<size_type>(std::distance(first, last)));
+        m_size = static_cast<size_type>(std::uninitialized_copy(first, last, m_data) - m_data);
+    }
+
+    iterator begin() noexcept { return m_data; }
+    iterator end() noexcept { return m_data + m_size; }
+    const_iterator begin() const noexcept { return m_data; }
+    const_iterator end() const noexcept { return m_data + m_size; }
+    const_iterator cbegin() const noexcept { return m_data; }
+    const_iterator cend() const noexcept { return m_data + m_size; }
+
+    T *data() noexcept { return m_data; }
+    const T *data() const noexcept { return m_data; }
+    T &operator[](size_type index) noexcept { return m_data[index]; }
+    const T &operator[](size_type index) const noexcept { return m_data[index]; }
+    T &front() noexcept { return m_data[0]; }
+    const T &front() const noexcept { return m_data[0]; }
+    T &back() noexcept { return m_data[m_size - 1]; }
+    const T &back() const noexcept { return m_data[m_size - 1]; }
+
+    bool empty() const noexcept { return m_size == 0; }
+    size_type size() const noexcept { return m_size; }
+    size_type capacity() const noexcept { return m_capacity; }
+    allocator_type get_allocator() const noexcept { return m_resource; }
+
+    void reserve(size_type count) {
+        if (count > m_capacity) {
+            Grow(count);
+        }
+    }
+
+    void resize(size_type count) {
+        reserve(count);
+        if (count > m_size) {
+            std::uninitialized_value_construct(m_data + m_size, m_data + count);
+        } else {
+            std::destroy(m_data + count, m_data + m_size);
+        }
+        m_size = count;
+    }
+    void resize(size_type count, const T &value) {
+        reserve(count);
+        if (count > m_size) {
+            std::uninitialized_fill(m_data + m_size, m_data + count, value);
+        } else {
+            std::destroy(m_data + count, m_data + m_size);
+        }
+        m_size = count;
+    }
+
+    void clear() noexcept {
+        std::destroy(m_data, m_data + m_size);
+        m_size = 0;
+    }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    template <typename... Args> T &emplace_back(Args &&...args) {
+        if (m_size == m_capacity) {
+            // construct before growing, args may point into the array
+            T value(std::forward<Args>(args)...);
+            Grow(m_capacity * 2);
+            return *new (m_data + m_size++) T(std::move(value));
+        }
+        return *new (m_data + m_size++) T(std::forward<Args>(args)...);
+    }
+
+    void pop_back() noexcept { m_data[--m_size].~T(); }
+
+    iterator erase(const_iterator position) { return erase(position, position + 1); }
+    iterator erase(const_iterator first, const_iterator last) {
+        T *begin = m_data + (first - m_data);
+        T *end = m_data + (last - m_data);
+        T *new_end = std::move(end, m_data + m_size, begin);
+        std::destroy(new_end, m_data + m_size);
+        m_size = static_cast<size_type>(new_end - m_data);
+        return begin;
+    }
+
+  private:
+    bool IsInline() const noexcept { return m_data == reinterpret_cast<const T *>(m_inline); }
+
+    void Grow(size_type count) {
+        T *data = static_cast<T *>(m_resource->allocate(sizeof(T) * count, alignof(T)));
+        std::uninitialized_move(m_data, m_data + m_size, data);
+        std::destroy(m_data, m_data + m_size);
+        Deallocate();
+        m_data = data;
+        m_capacity = count;
+    }
+
+    void Deallocate() noexcept {
+        if (!IsInline()) {
+            m_resource->deallocate(m_data, sizeof(T) * m_capacity, alignof(T));
+            m_data = reinterpret_cast<T *>(m_inline);
+            m_capacity = N;
+        }
+    }
+
+    // rhs is empty and inline afterwards
+    void MoveFrom(SmallArray &rhs) noexcept {
+        if (rhs.IsInline()) {
+            std::uninitialized_move(rhs.begin(), rhs.end(), m_data);
+            m_size = rhs.m_size;
+            rhs.clear();
+        } else {
+            m_resource = rhs.m_resource;
+            m_data = std::exchange(rhs.m_data, reinterpret_cast<T *>(rhs.m_inline));
+            m_capacity = std::exchange(rhs.m_capacity, N);
+            m_size = std::exchange(rhs.m_size, 0);
+        }
+    }
+
+    std::pmr::memory_resource *m_resource{};
+    T *m_data{reinterpret_cast<T *>(m_inline)};
+    size_type m_size{};
+    size_type m_capacity{N};
+    alignas(T) unsigned char m_inline[sizeof(T) * N];
+};
+
+} // namespace Fract::Container
@@ -0,0 +1,297 @@
+/*****************************************************************//**
+ * \file   Job.cpp
+ * \brief  workers, task queues and the task pool
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "Job.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../container/ConcurrentQueue.h"
+#include "../log/log.h"
+#include "../memory/Memory.h"
+#include "../memory/Numa.h"
+#include "../memory/ObjectPool.h"
+#include "WorkStealingDeque.h"
+
+namespace Fract::Job {
+
+namespace {
+
+constexpr int64_t TASK_DEQUE_SIZE = 4096;        // per thread, more spill into the shared queue
+constexpr size_t TASK_SHARED_QUEUE_SIZE = 4096; // submits from other threads and spills
+constexpr uint32_t IDLE_SPIN_COUNT = 64;        // steal attempts before a worker sleeps
+
+using TaskPool = Memory::ObjectPool<Task>;
+
+thread_local uint32_t thread_index = INVALID_THREAD_INDEX;
+
+// set on the initializing thread and on workers while the scheduler runs, other threads lock the pool
+thread_local TaskPool::ThreadCache *task_cache{};
+
+} // namespace
+
+class Scheduler {
+  public:
+    Scheduler(uint32_t thread_count, std::pmr::memory_resource *upstream)
+        : m_task_pool(upstream), m_task_cache(m_task_pool), m_shared_queue(TASK_SHARED_QUEUE_SIZE) {
+        task_cache = &m_task_cache;
+        m_queues.reserve(thread_count);
+        for (uint32_t i = 0; i < thread_count; i++) {
+            m_queues.emplace_back(std::make_unique<WorkStealingDeque<Task *, TASK_DEQUE_SIZE>>());
+        }
+        const uint32_t node_count = Memory::GetNumaNodeCount();
+        for (uint32_t i = 1; i < thread_count; i++) {
+            // consecutive workers share a node so stealing from neighbours mostly stays local
+            const uint32_t node = node_count > 1 ? i * node_count / thread_count : UINT32_MAX;
+            m_workers.emplace_back([this, i, node] { WorkerMain(i, node); });
+        }
+    }
+
+    ~Scheduler() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_running.store(false, std::memory_order_relaxed);
+        }
+        m_wake.notify_all();
+        for (auto &worker : m_workers) {
+            worker.join();
+        }
+        // whatever is left runs here, continuations of these tasks too
+        Task *task;
+        while ((task = FindTask(0))) {
+            Execute(task);
+        }
+        task_cache = nullptr;
+    }
+
+    uint32_t GetThreadCount() const noexcept { return static_cast<uint32_t>(m_queues.size()); }
+
+    void Push(Task *task) {
+        const uint32_t index = thread_index;
+        if (!(index < m_queues.size() && m_queues[index]->Push(task)) && !m_shared_queue.try_push(task)) {
+            // every queue is full, better late than lost
+            Execute(task);
+            return;
+        }
+        m_queued.fetch_add(1, std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard lock(m_mutex);
+            m_wake.notify_one();
+        }
+    }
+
+    // own queue first, then the shared one, then the other threads starting at a random one
+    Task *FindTask(uint32_t index) {
+        Task *task;
+        if (index < m_queues.size() && m_queues[index]->Pop(task)) {
+            return Take(task);
+        }
+        if (m_shared_queue.try_pop(task)) {
+            return Take(task);
+        }
+        const uint32_t count = static_cast<uint32_t>(m_queues.size());
+        thread_local uint32_t random = 0x9e3779b9u ^ index;
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        for (uint32_t i = 0, victim = random % count; i < count; i++, victim = victim + 1 == count ? 0 : victim + 1) {
+            if (victim != index && m_queues[victim]->Steal(task)) {
+                return Take(task);
+            }
+        }
+        return nullptr;
+    }
+
+    Task *AllocateTask() {
+        Task *task = task_cache ? task_cache->Acquire() : m_task_pool.Acquire();
+        task->m_pooled = true;
+        return task;
+    }
+
+    void FreeTask(Task *task) {
+        if (task_cache) {
+            task_cache->Release(task);
+        } else {
+            m_task_pool.Release(task);
+        }
+    }
+
+    static void Execute(Task *task);
+
+    static void Release(Task *task) {
+        if (task->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            Schedule(task);
+        }
+    }
+
+    static bool AddDependency(Task *task, Task *dependency) {
+        if (dependency->m_continuation_count == TASK_MAX_CONTINUATIONS) {
+            LOG_ERROR("a task can have at most {} dependents", TASK_MAX_CONTINUATIONS);
+            return false;
+        }
+        dependency->m_continuations[dependency->m_continuation_count++] = task;
+        task->m_pending.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+  private:
+    Task *Take(Task *task) noexcept {
+        m_queued.fetch_sub(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    void WorkerMain(uint32_t index, uint32_t node) {
+        thread_index = index;
+        // flushed when the worker returns, the pool outlives it
+        TaskPool::ThreadCache cache(m_task_pool);
+        task_cache = &cache;
+        if (node != UINT32_MAX) {
+            Memory::BindThreadToNumaNode(node);
+        }
+        // tasks run by Wait() nest inside the one picked up here, so only this level may reset the arena
+        Memory::LocalMemoryAllocator &arena = Memory::GetLocalAllocator();
+        uint32_t idle_count = 0;
+        while (m_running.load(std::memory_order_relaxed)) {
+            if (Task *task = FindTask(index)) {
+                Execute(task);
+                arena.Reset();
+                idle_count = 0;
+            } else if (++idle_count < IDLE_SPIN_COUNT) {
+                std::this_thread::yield();
+            } else {
+                Sleep();
+                idle_count = 0;
+            }
+        }
+        task_cache = nullptr;
+    }
+
+    // woken by Push(), m_sleeping and m_queued are both seq_cst so one side always sees the other
+    void Sleep() {
+        std::unique_lock lock(m_mutex);
+        m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+        m_wake.wait(lock, [this] {
+            return m_queued.load(std::memory_order_seq_cst) > 0 || !m_running.load(std::memory_order_relaxed);
+        });
+        m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // queues a task whose dependencies are done, runs it when not initialized
+    static void Schedule(Task *task);
+
+    // tasks live as long as the scheduler, so its pool is created after memory and released before it
+    TaskPool m_task_pool;
+    TaskPool::ThreadCache m_task_cache; // initializing thread
+    std::vector<std::unique_ptr<WorkStealingDeque<Task *, TASK_DEQUE_SIZE>>> m_queues; // 0 is the initializing thread
+    Container::MpmcQueue<Task *> m_shared_queue;
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_running{true};
+    std::atomic<int64_t> m_queued{}; // tasks in any queue, tells sleeping workers there is work
+    std::atomic<uint32_t> m_sleeping{};
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+};
+
+namespace {
+
+Scheduler *scheduler{};
+
+} // namespace
+
+void Scheduler::Schedule(Task *task) {
+    if (scheduler) {
+        scheduler->Push(task);
+    } else {
+        Execute(task);
+    }
+}
+
+void Scheduler::Execute(Task *task) {
+    task->m_invoke(*task);
+
+    Counter *counter = task->m_counter;
+    const uint32_t continuation_count = task->m_continuation_count;
+    Task *continuations[TASK_MAX_CONTINUATIONS];
+    std::copy_n(task->m_continuations, continuation_count, continuations);
+    if (!task->m_pooled) {
+        delete task;
+    } else {
+        scheduler->FreeTask(task);
+    }
+
+    for (uint32_t i = 0; i < continuation_count; i++) {
+        Release(continuations[i]);
+    }
+    if (counter) {
+        counter->m_value.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+bool Initialize(uint32_t thread_count) {
+    if (scheduler) {
+        LOG_ERROR("the job system is already initialized");
+        return false;
+    }
+    std::pmr::memory_resource *upstream = Memory::GetGlobalAllocator(Memory::MemoryTag::GENERAL);
+    if (!upstream) {
+        LOG_ERROR("initialize memory before the job system");
+        return false;
+    }
+    if (thread_count == 0) {
+        thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    thread_index = 0;
+    scheduler = new Scheduler(thread_count, upstream);
+    return true;
+}
+
+void Shutdown() {
+    if (!scheduler) {
+        return;
+    }
+    delete scheduler;
+    scheduler = nullptr;
+    thread_index = INVALID_THREAD_INDEX;
+}
+
+uint32_t GetThreadCount() noexcept { return scheduler ? scheduler->GetThreadCount() : 1; }
+
+uint32_t GetThreadIndex() noexcept { return thread_index; }
+
+namespace Detail {
+
+Task *AllocateTask() {
+    if (!scheduler) {
+        // runs inline on Submit(), no pool to take it from
+        return new Task();
+    }
+    return scheduler->AllocateTask();
+}
+
+} // namespace Detail
+
+bool AddDependency(Task *task, Task *dependency) { return Scheduler::AddDependency(task, dependency); }
+
+void Submit(Task *task) { Scheduler::Release(task); }
+
+void Wait(const Counter &counter) {
+    while (!counter.IsDone()) {
+        Task *task = scheduler ? scheduler->FindTask(thread_index) : nullptr;
+        if (task) {
+            Scheduler::Execute(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+} // namespace Fract::Job
@@ -0,0 +1,129 @@
+/*****************************************************************//**
+ * \file   Job.h
+ * \brief  work stealing task scheduler with dependencies and counters
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Fract::Job {
+
+static constexpr size_t TASK_DATA_SIZE = 64;          // bytes of captures stored inside a task
+static constexpr uint32_t TASK_MAX_CONTINUATIONS = 4; // tasks that can depend on one task
+static constexpr uint32_t INVALID_THREAD_INDEX = UINT32_MAX;
+
+class Counter;
+class Scheduler;
+class Task;
+
+// counter may be null, otherwise it counts the task from now on
+template <typename Function> Task *CreateTask(Function &&function, Counter *counter = nullptr);
+
+// counts tasks created with it that have not finished yet, Wait() on it to join them. must outlive those tasks.
+class Counter {
+  public:
+    Counter() noexcept = default;
+
+    Counter(const Counter &rhs) noexcept = delete;
+    Counter &operator=(const Counter &rhs) noexcept = delete;
+
+    bool IsDone() const noexcept { return m_value.load(std::memory_order_acquire) == 0; }
+
+  private:
+    friend class Scheduler;
+    template <typename Function> friend Task *CreateTask(Function &&function, Counter *counter);
+
+    std::atomic<uint32_t> m_value{};
+};
+
+// a callable with its captures inline, taken from a per thread pool by CreateTask() and returned after it ran. tasks
+// start once submitted and every dependency has finished, a task must not be touched after Submit().
+class alignas(64) Task {
+  public:
+    Task() noexcept = default;
+
+    Task(const Task &rhs) noexcept = delete;
+    Task &operator=(const Task &rhs) noexcept = delete;
+
+  private:
+    friend class Scheduler;
+    template <typename Function> friend Task *CreateTask(Function &&function, Counter *counter);
+
+    template <typename Function> void Bind(Function &&function) {
+        using Callable = std::decay_t<Function>;
+        static_assert(sizeof(Callable) <= TASK_DATA_SIZE, "capture large state by reference or pointer");
+        static_assert(alignof(Callable) <= alignof(std::max_align_t), "over-aligned task captures");
+        new (m_data) Callable(std::forward<Function>(function));
+        m_invoke = [](Task &task) {
+            Callable *callable = std::launder(reinterpret_cast<Callable *>(task.m_data));
+            (*callable)();
+            callable->~Callable();
+        };
+    }
+
+    void (*m_invoke)(Task &){}; // runs and destroys the callable
+    Counter *m_counter{};
+    std::atomic<uint32_t> m_pending{1}; // unfinished dependencies, plus one until submitted
+    uint32_t m_continuation_count{};
+    bool m_pooled{}; // from the scheduler's pool, heap allocated when not initialized
+    Task *m_continuations[TASK_MAX_CONTINUATIONS]{};
+    alignas(std::max_align_t) unsigned char m_data[TASK_DATA_SIZE];
+};
+
+// starts one worker per hardware thread minus the calling thread, which joins in whenever it waits. workers are spread
+// over the numa nodes. thread_count includes the calling thread, 0 uses every hardware thread. tasks come from the
+// GENERAL allocator, so call it after Memory::initialize(), false before. a worker resets its thread arena
+// (Memory::GetLocalAllocator()) after every task it picks up, nothing a task allocates there may outlive it.
+bool Initialize(uint32_t thread_count = 0);
+
+// runs the tasks still queued, joins the workers and frees the task pool. call it on the initializing thread before
+// Memory::destroy(), tasks created but not submitted by then are lost.
+void Shutdown();
+
+// workers plus the thread that called Initialize(), 1 when not initialized
+uint32_t GetThreadCount() noexcept;
+
+// 0 on the thread that called Initialize(), 1 to GetThreadCount() - 1 on workers, INVALID_THREAD_INDEX elsewhere.
+// meant for per thread slots in parallel algorithms.
+uint32_t GetThreadIndex() noexcept;
+
+namespace Detail {
+
+Task *AllocateTask();
+
+} // namespace Detail
+
+template <typename Function> Task *CreateTask(Function &&function, Counter *counter) {
+    Task *task = Detail::AllocateTask();
+    task->Bind(std::forward<Function>(function));
+    if (counter) {
+        counter->m_value.fetch_add(1, std::memory_order_relaxed);
+        task->m_counter = counter;
+    }
+    return task;
+}
+
+// task starts after dependency finished. neither may be submitted yet, false if dependency already has
+// TASK_MAX_CONTINUATIONS dependents.
+bool AddDependency(Task *task, Task *dependency);
+
+// queues the task on the calling worker, any thread may submit. runs it right away when not initialized.
+void Submit(Task *task);
+
+// runs queued tasks until every task counted by counter has finished
+void Wait(const Counter &counter);
+
+template <typename Function> void Run(Function &&function, Counter &counter) {
+    Submit(CreateTask(std::forward<Function>(function), &counter));
+}
+
+} // namespace Fract::Job
@@ -0,0 +1,136 @@
+/*****************************************************************//**
+ * \file   Parallel.h
+ * \brief  parallel for, reduce and scan on the job system
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "../container/Container.h"
+#include "Job.h"
+
+namespace Fract::Job {
+
+// blocks per thread when the grain size is left to the algorithm, enough to even out uneven work
+static constexpr uint64_t PARALLEL_BLOCKS_PER_THREAD = 8;
+
+namespace Detail {
+
+inline uint64_t GetGrainSize(uint64_t count, uint64_t grain_size) noexcept {
+    if (grain_size > 0) {
+        return grain_size;
+    }
+    return std::max<uint64_t>(count / (GetThreadCount() * PARALLEL_BLOCKS_PER_THREAD), 1);
+}
+
+template <typename Function> struct ForContext {
+    Function &function;
+    uint64_t grain_size;
+    Counter counter;
+};
+
+// halves the range until it fits the grain, the upper halves go to the queue where idle threads steal the largest
+// pieces first
+template <typename Function> void SplitFor(ForContext<Function> &context, uint64_t begin, uint64_t end) {
+    while (end - begin > context.grain_size) {
+        const uint64_t middle = begin + (end - begin) / 2;
+        Run([&context, middle, end] { SplitFor(context, middle, end); }, context.counter);
+        end = middle;
+    }
+    context.function(begin, end);
+}
+
+} // namespace Detail
+
+// calls function(block_begin, block_end) on blocks of at most grain_size indices covering [begin, end) and returns
+// once all of them ran. grain_size 0 picks one from the thread count. the calling thread works on blocks too.
+template <typename Function> void ParallelFor(uint64_t begin, uint64_t end, uint64_t grain_size, Function &&function) {
+    if (begin >= end) {
+        return;
+    }
+    Detail::ForContext<std::remove_reference_t<Function>> context{
+        function, Detail::GetGrainSize(end - begin, grain_size), {}};
+    Detail::SplitFor(context, begin, end);
+    Wait(context.counter);
+}
+
+// reduce(block_begin, block_end, identity) folds one block, combine(lhs, rhs) merges two results. blocks only depend
+// on the range and the grain size and are combined left to right, so float sums are the same on every run. pass an
+// explicit grain_size to get the same result for any thread count as well.
+template <typename T, typename Reduce, typename Combine>
+T ParallelReduce(uint64_t begin, uint64_t end, uint64_t grain_size, const T &identity, Reduce &&reduce,
+                 Combine &&combine) {
+    if (begin >= end) {
+        return identity;
+    }
+    grain_size = Detail::GetGrainSize(end - begin, grain_size);
+    const uint64_t block_count = (end - begin + grain_size - 1) / grain_size;
+    if (block_count == 1) {
+        return reduce(begin, end, identity);
+    }
+    Container::Array<T> partial(block_count, identity);
+    ParallelFor(0, block_count, 1, [&](uint64_t first_block, uint64_t last_block) {
+        for (uint64_t block = first_block; block < last_block; block++) {
+            const uint64_t block_begin = begin + block * grain_size;
+            partial[block] = reduce(block_begin, std::min(block_begin + grain_size, end), identity);
+        }
+    });
+    T result = std::move(partial[0]);
+    for (uint64_t block = 1; block < block_count; block++) {
+        result = combine(result, partial[block]);
+    }
+    return result;
+}
+
+// exclusive prefix scan, output[i] combines input[0] to input[i - 1] starting from identity. returns the combination
+// of every input. output may be input. the same blocking rules as ParallelReduce keep float results reproducible.
+template <typename T, typename Combine>
+T ParallelScan(const T *input, T *output, uint64_t count, uint64_t grain_size, const T &identity, Combine &&combine) {
+    if (count == 0) {
+        return identity;
+    }
+    // block sums, their scan and a second pass writing every block from its offset
+    grain_size = Detail::GetGrainSize(count, grain_size);
+    const uint64_t block_count = (count + grain_size - 1) / grain_size;
+    Container::Array<T> offsets(block_count, identity);
+    auto scan_block = [&](uint64_t block, T value, bool write) {
+        const uint64_t block_end = std::min((block + 1) * grain_size, count);
+        for (uint64_t i = block * grain_size; i < block_end; i++) {
+            const T element = input[i];
+            if (write) {
+                output[i] = value;
+            }
+            value = combine(value, element);
+        }
+        return value;
+    };
+    if (block_count > 1) {
+        ParallelFor(0, block_count - 1, 1, [&](uint64_t first_block, uint64_t last_block) {
+            for (uint64_t block = first_block; block < last_block; block++) {
+                offsets[block + 1] = scan_block(block, identity, false);
+            }
+        });
+        for (uint64_t block = 1; block < block_count; block++) {
+            offsets[block] = combine(offsets[block - 1], offsets[block]);
+        }
+    }
+    T total = identity;
+    ParallelFor(0, block_count, 1, [&](uint64_t first_block, uint64_t last_block) {
+        for (uint64_t block = first_block; block < last_block; block++) {
+            const T block_total = scan_block(block, offsets[block], true);
+            if (block == block_count - 1) {
+                total = block_total;
+            }
+        }
+    });
+    return total;
+}
+
+} // namespace Fract::Job
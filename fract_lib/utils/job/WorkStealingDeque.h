@@ -0,0 +1,87 @@
+/*****************************************************************//**
+ * \file   WorkStealingDeque.h
+ * \brief  fixed size chase-lev deque
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "../container/ConcurrentQueue.h"
+
+namespace Fract::Job {
+
+// chase-lev deque with the c11 orderings of le et al. 2013. the owner pushes and pops at the bottom like a stack,
+// other threads steal the oldest entry from the top. the ring does not grow, Push() fails once Size entries are
+// queued. Size must be a power of two.
+template <typename T, int64_t Size> class WorkStealingDeque {
+    static_assert(Size > 0 && (Size & (Size - 1)) == 0, "deque size must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>);
+
+  public:
+    // owner thread only
+    bool Push(T value) noexcept {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= Size) {
+            return false;
+        }
+        m_buffer[bottom & MASK].store(value, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // owner thread only, newest entry first
+    bool Pop(T &value) noexcept {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        value = m_buffer[bottom & MASK].load(std::memory_order_relaxed);
+        if (top == bottom) {
+            // the last entry, race the thieves for it
+            const bool won =
+                m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // any thread, oldest entry first. also fails when another thread won the same entry.
+    bool Steal(T &value) noexcept {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return false;
+        }
+        value = m_buffer[top & MASK].load(std::memory_order_relaxed);
+        return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // approximate unless called by the owner while nobody steals
+    int64_t GetSize() const noexcept {
+        const int64_t size = m_bottom.load(std::memory_order_relaxed) - m_top.load(std::memory_order_relaxed);
+        return size > 0 ? size : 0;
+    }
+
+  private:
+    static constexpr int64_t MASK = Size - 1;
+
+    alignas(Container::CACHE_LINE_SIZE) std::atomic<int64_t> m_top{};    // advanced by thieves
+    alignas(Container::CACHE_LINE_SIZE) std::atomic<int64_t> m_bottom{}; // written by the owner
+    alignas(Container::CACHE_LINE_SIZE) std::atomic<T> m_buffer[Size]{};
+};
+
+} // namespace Fract::Job
@@ -6,32 +6,42 @@
  * \date   November 2022
  *********************************************************************/
 
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h> // or "../stdout_sinks.h" if no colors needed
 
-#include "Log.h"
+#include "log.h"
 
 namespace Fract {
 
 Log::Log() noexcept {
-    m_logger = spdlog::stdout_color_mt("Fract logger");
+    spdlog::init_thread_pool(QUEUE_SIZE, 1);
+    m_logger = spdlog::create_async_nb<spdlog::sinks::stdout_color_sink_mt>("Fract logger");
+    // %! is the function passed by the LOG_* macros
+    m_logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] [%!] %v");
+    m_logger->flush_on(spdlog::level::err);
     spdlog::set_default_logger(m_logger);
 #ifndef NDEBUG
     spdlog::set_level(spdlog::level::debug);
 #else
     spdlog::set_level(spdlog::level::info);
 #endif // !NDEBUG
+    s_logger.store(m_logger.get(), std::memory_order_release);
 }
 
 Log::~Log() noexcept {
+    s_logger.store(nullptr, std::memory_order_release);
+    // joins the background thread after it wrote everything queued
     m_logger->flush();
-    spdlog::drop_all();
+    spdlog::shutdown();
 }
 
+#ifdef _WIN32
 void Log::CheckDXResult(HRESULT hr, const char *func_name, int line) const noexcept {
     if (FAILED(hr)) {
         m_logger->error("[function: {}], [line: {}], directx result checking failed:{}", func_name, line,
                         HrToString(hr));
     }
 }
+#endif // _WIN32
 
 } // namespace Fract
\ No newline at end of file
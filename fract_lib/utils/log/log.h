@@ -8,7 +8,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX // keeps std::min and std::max usable
+#endif
 #include <Windows.h>
+#endif
 #include <spdlog/spdlog.h>
 
 #include "../singleton/public_singleton.h"
@@ -16,53 +24,60 @@
 
 namespace Fract {
 
+#ifdef _WIN32
 inline Container::String HrToString(HRESULT hr) {
     char s_str[64] = {};
     sprintf_s(s_str, "HRESULT of 0x%08X", static_cast<unsigned int>(hr));
     return Container::String(s_str);
 }
+#endif // _WIN32
 
+// messages are formatted on the calling thread and handed to an async spdlog logger, one background thread writes
+// them out. a full queue drops the oldest message instead of blocking the caller.
 class Log : public PublicSingleton<Log> {
   public:
-    enum loglevel { debug, info, warn, error, fatal };
+    // queued messages before the oldest ones are dropped
+    static constexpr size_t QUEUE_SIZE = 8192;
 
   public:
     Log() noexcept;
     ~Log() noexcept;
 
-    template <typename... args> inline void Debug(args &&..._args) const noexcept {
-        m_logger->debug(std::forward<args>(_args)...);
-    }
-
-    template <typename... args> inline void Info(args &&..._args) const noexcept {
-        m_logger->info(std::forward<args>(_args)...);
-    }
-
-    template <typename... args> inline void Warn(args &&..._args) const noexcept {
-        m_logger->warn(std::forward<args>(_args)...);
+    // a plain load once the singleton exists, the first call creates it
+    static spdlog::logger *GetLogger() noexcept {
+        spdlog::logger *logger = s_logger.load(std::memory_order_acquire);
+        return logger ? logger : GetInstance().m_logger.get();
     }
 
-    template <typename... args> inline void Error(args &&..._args) const noexcept {
-        m_logger->error(std::forward<args>(_args)...);
-    }
-    template <typename... args> inline void Fatal(args &&..._args) const noexcept {
-        // m_logger->fatal(std::forward<args>(_args)...);
-    }
+#ifdef _WIN32
     void CheckDXResult(HRESULT hr, const char *func_name, int line) const noexcept;
+#endif // _WIN32
 
   private:
+    inline static std::atomic<spdlog::logger *> s_logger{};
     std::shared_ptr<spdlog::logger> m_logger;
 };
 
-#define LOG_DEBUG(...) Log::GetInstance().Debug("[" + Container::String(__FUNCTION__) + "] " + __VA_ARGS__);
+// the level is checked before the arguments are evaluated, the format string is checked at compile time and the
+// function name is added by the sink pattern
+#define LOG_AT_LEVEL(level, format, ...)                                                                               \
+    do {                                                                                                               \
+        spdlog::logger *fract_logger = ::Fract::Log::GetLogger();                                                      \
+        if (fract_logger->should_log(level)) {                                                                         \
+            fract_logger->log(spdlog::source_loc{__FILE__, __LINE__, __FUNCTION__}, level, FMT_STRING(format),        \
+                              ##__VA_ARGS__);                                                                          \
+        }                                                                                                              \
+    } while (false)
+
+#define LOG_DEBUG(...) LOG_AT_LEVEL(spdlog::level::debug, __VA_ARGS__)
 
-#define LOG_INFO(...) Log::GetInstance().Info("[" + Container::String(__FUNCTION__) + "] " + __VA_ARGS__);
+#define LOG_INFO(...) LOG_AT_LEVEL(spdlog::level::info, __VA_ARGS__)
 
-#define LOG_WARN(...) Log::GetInstance().Warn("[" + Container::String(__FUNCTION__) + "] " + __VA_ARGS__);
+#define LOG_WARN(...) LOG_AT_LEVEL(spdlog::level::warn, __VA_ARGS__)
 
-#define LOG_ERROR(...) Log::GetInstance().Error("[" + Container::String(__FUNCTION__) + "] " + __VA_ARGS__);
+#define LOG_ERROR(...) LOG_AT_LEVEL(spdlog::level::err, __VA_ARGS__)
 
-#define LOG_FATAL(...) Log::GetInstance().Fatal("[" + Container::String(__FUNCTION__) + "] " + __VA_ARGS__);
+#define LOG_FATAL(...) LOG_AT_LEVEL(spdlog::level::critical, __VA_ARGS__)
 
 #define CHECK_VK_RESULT(res) Log::GetInstance().CheckVulkanResult(res, __FUNCTION__, __LINE__);
 
@@ -0,0 +1,263 @@
+/*****************************************************************//**
+ * \file   FastMath.h
+ * \brief  polynomial approximations of transcendental functions
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "../defination.h"
+#include "Simd.h"
+
+namespace Fract::Math {
+
+// branch free replacements for std:: math on the shading path. every function has an f32x4, f32x8 and f32 version
+// sharing one implementation, the f32 one is plain code the compiler can vectorize in loops. coefficients are the
+// single precision cephes ones. errors are measured against double precision libm over the stated range, the same
+// for every backend up to fma rounding.
+
+// sqrtss without the errno check std::sqrt may branch to, correctly rounded
+inline f32 Sqrt(f32 x) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(x)));
+#else
+    return std::sqrt(x);
+#endif
+}
+
+// hardware estimate refined by one newton step like the simd version, relative error below 3e-7 (4 ulp). 0 gives
+// inf and inf gives 0 like the simd version, the step would turn them into nan
+inline f32 Rsqrt(f32 x) noexcept {
+#if defined(MATH_USE_SSE)
+    const f32 estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    const f32 refined = estimate * (1.5f - 0.5f * x * estimate * estimate);
+    return refined != refined ? estimate : refined;
+#else
+    return 1.0f / std::sqrt(x);
+#endif
+}
+
+namespace Detail {
+
+static constexpr f32 FAST_PI = 3.14159265358979f;
+static constexpr f32 FAST_PIDIV2 = 1.57079632679490f;
+static constexpr f32 FAST_PIDIV4 = 0.78539816339745f;
+
+// largest |x| SinCos reduces, keeps the quadrant index inside Floor()'s domain. floats above it are all even
+// integers, there is no phase left to resolve.
+static constexpr f32 FAST_SIN_COS_MAX_ARGUMENT = 16777216.0f;
+
+// scalar versions of the simd primitives so the kernels below also instantiate for f32. simd arguments find theirs
+// through argument dependent lookup.
+inline f32 MulAdd(f32 a, f32 b, f32 c) noexcept { return a * b + c; }
+inline f32 Min(f32 a, f32 b) noexcept { return a < b ? a : b; }
+inline f32 Max(f32 a, f32 b) noexcept { return a > b ? a : b; }
+inline f32 Abs(f32 a) noexcept { return FromBits(ToBits(a) & 0x7fffffffu); }
+inline f32 Select(bool mask, f32 a, f32 b) noexcept { return mask ? a : b; }
+
+// |a| < 2^31, which all callers guarantee
+inline f32 Floor(f32 a) noexcept {
+    const f32 truncated = static_cast<f32>(static_cast<i32>(a));
+    return truncated > a ? truncated - 1.0f : truncated;
+}
+
+inline f32 Pow2(f32 n) noexcept { return FromBits(static_cast<u32>(static_cast<i32>(n) + 127) << 23); }
+inline f32 Exponent(f32 a) noexcept { return static_cast<f32>(static_cast<i32>((ToBits(a) >> 23) & 0xff) - 127); }
+
+// mantissa of a normal value scaled to [1, 2)
+inline f32 Mantissa(f32 a) noexcept { return FromBits((ToBits(a) & 0x007fffffu) | 0x3f800000u); }
+template <typename F> inline F Mantissa(const F &a) noexcept {
+    return (a & F(FromBits(0x007fffffu))) | F(1.0f);
+}
+
+template <typename F> inline F ExpImpl(const F &input) noexcept {
+    // e^x = 2^n * e^r with |r| <= ln2 / 2, ln2 is split in two so n * ln2 stays exact. the clamp also maps nan into
+    // range so the float to int conversions stay defined, nan is put back at the end
+    F x = Min(Max(input, F(-87.3365448f)), F(88.3762626f));
+    const F n = Floor(MulAdd(x, F(1.44269504f), F(0.5f)));
+    x = MulAdd(n, F(-0.693359375f), x);
+    x = MulAdd(n, F(2.12194440e-4f), x);
+
+    F p = MulAdd(F(1.9875691500e-4f), x, F(1.3981999507e-3f));
+    p = MulAdd(p, x, F(8.3334519073e-3f));
+    p = MulAdd(p, x, F(4.1665795894e-2f));
+    p = MulAdd(p, x, F(1.6666665459e-1f));
+    p = MulAdd(p, x, F(5.0000001201e-1f));
+    p = MulAdd(p, x * x, x + F(1.0f));
+    return Select(input != input, input, p * Pow2(n));
+}
+
+template <typename F> inline F LogImpl(const F &x) noexcept {
+    // x = m * 2^e with m in [sqrt(1/2), sqrt(2)), then log(x) = log1p(m - 1) + e * ln2
+    F m = Mantissa(x);
+    F e = Exponent(x);
+    const auto upper = m > F(1.41421356f);
+    m = Select(upper, m * F(0.5f), m) - F(1.0f);
+    e = Select(upper, e + F(1.0f), e);
+
+    const F z = m * m;
+    F p = MulAdd(F(7.0376836292e-2f), m, F(-1.1514610310e-1f));
+    p = MulAdd(p, m, F(1.1676998740e-1f));
+    p = MulAdd(p, m, F(-1.2420140846e-1f));
+    p = MulAdd(p, m, F(1.4249322787e-1f));
+    p = MulAdd(p, m, F(-1.6668057665e-1f));
+    p = MulAdd(p, m, F(2.0000714765e-1f));
+    p = MulAdd(p, m, F(-2.4999993993e-1f));
+    p = MulAdd(p, m, F(3.3333331174e-1f));
+
+    F y = p * m * z;
+    y = MulAdd(e, F(-2.12194440e-4f), y);
+    y = MulAdd(z, F(-0.5f), y);
+    F result = MulAdd(e, F(0.693359375f), m + y);
+
+    // zero and denormals give -inf, negative and nan give nan
+    result = Select(x < F(std::numeric_limits<f32>::min()), F(-std::numeric_limits<f32>::infinity()), result);
+    result = Select(x >= F(0.0f), result, F(std::numeric_limits<f32>::quiet_NaN()));
+    return Select(x == F(std::numeric_limits<f32>::infinity()), x, result);
+}
+
+template <typename F> inline void SinCosImpl(const F &x, F &sin, F &cos) noexcept {
+    // reduce to |r| <= pi/4 around the nearest multiple q of pi/2, pi/2 is split in three so q * pi/2 stays exact.
+    // min returns the limit for nan, out of range lanes are replaced by nan at the end
+    const F a = Min(Abs(x), F(FAST_SIN_COS_MAX_ARGUMENT));
+    const F q = Floor(MulAdd(a, F(0.636619772f), F(0.5f)));
+    F r = MulAdd(q, F(-1.5703125f), a);
+    r = MulAdd(q, F(-4.837512969970703125e-4f), r);
+    r = MulAdd(q, F(-7.54978995489188216e-8f), r);
+
+    const F z = r * r;
+    F s = MulAdd(F(-1.9515295891e-4f), z, F(8.3321608736e-3f));
+    s = MulAdd(s, z, F(-1.6666654611e-1f));
+    s = MulAdd(s * z, r, r);
+    F c = MulAdd(F(2.443315711809948e-5f), z, F(-1.388731625493765e-3f));
+    c = MulAdd(c, z, F(4.166664568298827e-2f));
+    c = MulAdd(c * z, z, MulAdd(z, F(-0.5f), F(1.0f)));
+
+    // quadrant q mod 4 picks the polynomial and the signs
+    const F quadrant = q - F(4.0f) * Floor(q * F(0.25f));
+    const auto odd = (quadrant == F(1.0f)) | (quadrant == F(3.0f));
+    const F sin_a = Select(odd, c, s);
+    const F cos_a = Select(odd, s, c);
+    sin = Select(quadrant >= F(2.0f), -sin_a, sin_a);
+    sin = Select(x < F(0.0f), -sin, sin);
+    cos = Select((quadrant == F(1.0f)) | (quadrant == F(2.0f)), -cos_a, cos_a);
+
+    const auto valid = Abs(x) <= F(FAST_SIN_COS_MAX_ARGUMENT);
+    sin = Select(valid, sin, F(std::numeric_limits<f32>::quiet_NaN()));
+    cos = Select(valid, cos, F(std::numeric_limits<f32>::quiet_NaN()));
+}
+
+template <typename F> inline F Atan2Impl(const F &y, const F &x) noexcept {
+    // atan of min/max in [0, 1], folded to [0, tan(pi/8)] by atan(a) = pi/4 + atan((a - 1) / (a + 1))
+    const F ax = Abs(x), ay = Abs(y);
+    const F hi = Max(ax, ay);
+    F a = Select(hi > F(0.0f), Min(ax, ay) / hi, F(0.0f));
+    const auto fold = a > F(0.414213562f);
+    a = Select(fold, (a - F(1.0f)) / (a + F(1.0f)), a);
+
+    const F z = a * a;
+    F p = MulAdd(F(8.05374449538e-2f), z, F(-1.38776856032e-1f));
+    p = MulAdd(p, z, F(1.99777106478e-1f));
+    p = MulAdd(p, z, F(-3.33329491539e-1f));
+    F result = MulAdd(p * z, a, a) + Select(fold, F(FAST_PIDIV4), F(0.0f));
+
+    result = Select(ay > ax, F(FAST_PIDIV2) - result, result);
+    result = Select(x < F(0.0f), F(FAST_PI) - result, result);
+    return Select(y < F(0.0f), -result, result);
+}
+
+template <typename F> inline F AcosImpl(const F &x) noexcept {
+    // asin polynomial on [0, 1/2], above that acos(a) = 2 * asin(sqrt((1 - a) / 2))
+    const F a = Abs(x);
+    const auto upper = a > F(0.5f);
+    const F z = Select(upper, (F(1.0f) - a) * F(0.5f), a * a);
+    const F s = Select(upper, Sqrt(z), a);
+
+    F p = MulAdd(F(4.2163199048e-2f), z, F(2.4181311049e-2f));
+    p = MulAdd(p, z, F(4.5470025998e-2f));
+    p = MulAdd(p, z, F(7.4953002686e-2f));
+    p = MulAdd(p, z, F(1.6666752422e-1f));
+    const F asin = MulAdd(s * z, p, s);
+
+    const F result = Select(upper, asin + asin, F(FAST_PIDIV2) - asin);
+    return Select(x < F(0.0f), F(FAST_PI) - result, result);
+}
+
+} // namespace Detail
+
+// relative error below 1.2e-7 (1.3 ulp). x is clamped to [-87.33, 88.37], so the result saturates to FLT_MIN and
+// about 2.4e38 instead of 0 and inf. nan gives nan.
+inline f32x4 Exp(const f32x4 &x) noexcept { return Detail::ExpImpl(x); }
+inline f32x8 Exp(const f32x8 &x) noexcept { return Detail::ExpImpl(x); }
+inline f32 Exp(f32 x) noexcept { return Detail::ExpImpl(x); }
+
+// absolute error below 4e-8 on [0.5, 2], relative error below 1e-7 (0.8 ulp) elsewhere. 0 and denormals give -inf,
+// negative values and nan give nan.
+inline f32x4 Log(const f32x4 &x) noexcept { return Detail::LogImpl(x); }
+inline f32x8 Log(const f32x8 &x) noexcept { return Detail::LogImpl(x); }
+inline f32 Log(f32 x) noexcept { return Detail::LogImpl(x); }
+
+// exp(y * log(x)) for x > 0 and 0 for x <= 0. the relative error grows with the exponent, it stays below
+// 1.2e-7 * (1 + |y * log(x)|)
+inline f32x4 Pow(const f32x4 &x, const f32x4 &y) noexcept {
+    return Select(x > f32x4(0.0f), Exp(y * Log(x)), f32x4(0.0f));
+}
+inline f32x8 Pow(const f32x8 &x, const f32x8 &y) noexcept {
+    return Select(x > f32x8(0.0f), Exp(y * Log(x)), f32x8(0.0f));
+}
+inline f32 Pow(f32 x, f32 y) noexcept { return x > 0.0f ? Exp(y * Log(x)) : 0.0f; }
+
+// absolute error below 1e-7 for |x| <= 8192, the reduction loses precision on larger arguments. |x| above 2^24, inf
+// and nan give nan.
+inline void SinCos(const f32x4 &x, f32x4 &sin, f32x4 &cos) noexcept { Detail::SinCosImpl(x, sin, cos); }
+inline void SinCos(const f32x8 &x, f32x8 &sin, f32x8 &cos) noexcept { Detail::SinCosImpl(x, sin, cos); }
+inline void SinCos(f32 x, f32 &sin, f32 &cos) noexcept { Detail::SinCosImpl(x, sin, cos); }
+
+inline f32x4 Sin(const f32x4 &x) noexcept {
+    f32x4 sin, cos;
+    SinCos(x, sin, cos);
+    return sin;
+}
+inline f32x8 Sin(const f32x8 &x) noexcept {
+    f32x8 sin, cos;
+    SinCos(x, sin, cos);
+    return sin;
+}
+inline f32 Sin(f32 x) noexcept {
+    f32 sin, cos;
+    SinCos(x, sin, cos);
+    return sin;
+}
+
+inline f32x4 Cos(const f32x4 &x) noexcept {
+    f32x4 sin, cos;
+    SinCos(x, sin, cos);
+    return cos;
+}
+inline f32x8 Cos(const f32x8 &x) noexcept {
+    f32x8 sin, cos;
+    SinCos(x, sin, cos);
+    return cos;
+}
+inline f32 Cos(f32 x) noexcept {
+    f32 sin, cos;
+    SinCos(x, sin, cos);
+    return cos;
+}
+
+// absolute error below 3e-7, atan2(0, 0) is 0
+inline f32x4 Atan2(const f32x4 &y, const f32x4 &x) noexcept { return Detail::Atan2Impl(y, x); }
+inline f32x8 Atan2(const f32x8 &y, const f32x8 &x) noexcept { return Detail::Atan2Impl(y, x); }
+inline f32 Atan2(f32 y, f32 x) noexcept { return Detail::Atan2Impl(y, x); }
+
+// absolute error below 3.1e-7 on [-1, 1], nan outside
+inline f32x4 Acos(const f32x4 &x) noexcept { return Detail::AcosImpl(x); }
+inline f32x8 Acos(const f32x8 &x) noexcept { return Detail::AcosImpl(x); }
+inline f32 Acos(f32 x) noexcept { return Detail::AcosImpl(x); }
+
+} // namespace Fract::Math
@@ -0,0 +1,203 @@
+/*****************************************************************//**
+ * \file   Matrix.h
+ * \brief  4x4 matrix and quaternion
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cmath>
+
+#include "Vector.h"
+
+namespace Fract::Math {
+
+struct quaternion;
+
+// row major with row vectors (v' = v * m) and a right handed view space like SimpleMath, so matrices built here
+// match the ones the shaders were written against
+struct float4x4 {
+    f32 m[4][4]{};
+
+    float4x4() noexcept = default;
+    constexpr float4x4(f32 m00, f32 m01, f32 m02, f32 m03, f32 m10, f32 m11, f32 m12, f32 m13, f32 m20, f32 m21,
+                       f32 m22, f32 m23, f32 m30, f32 m31, f32 m32, f32 m33) noexcept
+        : m{{m00, m01, m02, m03}, {m10, m11, m12, m13}, {m20, m21, m22, m23}, {m30, m31, m32, m33}} {}
+
+    f32x4 Row(u32 row) const noexcept { return f32x4::Load(m[row]); }
+    void SetRow(u32 row, const f32x4 &value) noexcept { value.Store(m[row]); }
+
+    float4x4 Transpose() const noexcept {
+        return {m[0][0], m[1][0], m[2][0], m[3][0], m[0][1], m[1][1], m[2][1], m[3][1],
+                m[0][2], m[1][2], m[2][2], m[3][2], m[0][3], m[1][3], m[2][3], m[3][3]};
+    }
+
+    // cofactor expansion, returns the zero matrix if it is singular
+    float4x4 Invert() const noexcept;
+
+    static float4x4 Identity() noexcept {
+        return {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    }
+
+    static float4x4 CreateTranslation(const float3 &t) noexcept {
+        return {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, t.x, t.y, t.z, 1.0f};
+    }
+
+    static float4x4 CreateScale(const float3 &s) noexcept {
+        return {s.x, 0.0f, 0.0f, 0.0f, 0.0f, s.y, 0.0f, 0.0f, 0.0f, 0.0f, s.z, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+    }
+
+    static float4x4 CreateFromQuaternion(const quaternion &q) noexcept;
+
+    // view matrix looking from eye to target, -z is forward
+    static float4x4 CreateLookAt(const float3 &eye, const float3 &target, const float3 &up) noexcept {
+        const float3 z = Normalize(eye - target);
+        const float3 x = Normalize(Cross(up, z));
+        const float3 y = Cross(z, x);
+        return {x.x, y.x, z.x, 0.0f, //
+                x.y, y.y, z.y, 0.0f, //
+                x.z, y.z, z.z, 0.0f, //
+                -Dot(x, eye), -Dot(y, eye), -Dot(z, eye), 1.0f};
+    }
+
+    // depth maps near to 0 and far to 1
+    static float4x4 CreatePerspectiveFieldOfView(f32 fov, f32 aspect_ratio, f32 near_plane, f32 far_plane) noexcept {
+        const f32 height = 1.0f / std::tan(fov * 0.5f);
+        const f32 width = height / aspect_ratio;
+        const f32 range = far_plane / (near_plane - far_plane);
+        return {width, 0.0f, 0.0f, 0.0f,  //
+                0.0f, height, 0.0f, 0.0f, //
+                0.0f, 0.0f, range, -1.0f, //
+                0.0f, 0.0f, range * near_plane, 0.0f};
+    }
+};
+
+inline float4x4 operator*(const float4x4 &lhs, const float4x4 &rhs) noexcept {
+    const f32x4 r0 = rhs.Row(0), r1 = rhs.Row(1), r2 = rhs.Row(2), r3 = rhs.Row(3);
+    float4x4 result;
+    for (u32 i = 0; i < 4; i++) {
+        f32x4 row = f32x4(lhs.m[i][0]) * r0;
+        row = MulAdd(f32x4(lhs.m[i][1]), r1, row);
+        row = MulAdd(f32x4(lhs.m[i][2]), r2, row);
+        row = MulAdd(f32x4(lhs.m[i][3]), r3, row);
+        result.SetRow(i, row);
+    }
+    return result;
+}
+
+inline float4x4 &operator*=(float4x4 &lhs, const float4x4 &rhs) noexcept { return lhs = lhs * rhs; }
+
+inline float4 Transform(const float4 &v, const float4x4 &m) noexcept {
+    f32x4 result = f32x4(v.x) * m.Row(0);
+    result = MulAdd(f32x4(v.y), m.Row(1), result);
+    result = MulAdd(f32x4(v.z), m.Row(2), result);
+    return MulAdd(f32x4(v.w), m.Row(3), result);
+}
+
+// w = 1, no perspective divide
+inline float3 TransformPoint(const float3 &p, const float4x4 &m) noexcept {
+    const float4 result = Transform(float4{p, 1.0f}, m);
+    return {result.x, result.y, result.z};
+}
+
+// w = 0, ignores the translation
+inline float3 TransformVector(const float3 &v, const float4x4 &m) noexcept {
+    const float4 result = Transform(float4{v, 0.0f}, m);
+    return {result.x, result.y, result.z};
+}
+
+inline float4x4 float4x4::Invert() const noexcept {
+    // 2x2 sub determinants of the upper and lower two rows
+    const f32 s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    const f32 s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    const f32 s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    const f32 s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    const f32 s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    const f32 s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+    const f32 c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+    const f32 c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    const f32 c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    const f32 c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    const f32 c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    const f32 c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+
+    const f32 determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (determinant == 0.0f) {
+        return {};
+    }
+    const f32 inv = 1.0f / determinant;
+    return {(m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * inv,  (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * inv,
+            (m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * inv,  (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * inv,
+            (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * inv, (m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * inv,
+            (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * inv, (m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * inv,
+            (m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * inv,  (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * inv,
+            (m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * inv,  (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * inv,
+            (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * inv, (m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * inv,
+            (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * inv, (m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * inv};
+}
+
+// unit quaternion, w is the scalar part
+struct quaternion {
+    f32 x{}, y{}, z{}, w{1.0f};
+
+    quaternion() noexcept = default;
+    constexpr quaternion(f32 x, f32 y, f32 z, f32 w) noexcept : x(x), y(y), z(z), w(w) {}
+
+    quaternion Conjugate() const noexcept { return {-x, -y, -z, w}; }
+
+    static quaternion CreateFromAxisAngle(const float3 &axis, f32 angle) noexcept {
+        const float3 a = Normalize(axis) * std::sin(angle * 0.5f);
+        return {a.x, a.y, a.z, std::cos(angle * 0.5f)};
+    }
+};
+
+// hamilton product, rotating by the result applies rhs first
+inline quaternion operator*(const quaternion &lhs, const quaternion &rhs) noexcept {
+    return {lhs.w * rhs.x + lhs.x * rhs.w + lhs.y * rhs.z - lhs.z * rhs.y,
+            lhs.w * rhs.y - lhs.x * rhs.z + lhs.y * rhs.w + lhs.z * rhs.x,
+            lhs.w * rhs.z + lhs.x * rhs.y - lhs.y * rhs.x + lhs.z * rhs.w,
+            lhs.w * rhs.w - lhs.x * rhs.x - lhs.y * rhs.y - lhs.z * rhs.z};
+}
+
+inline quaternion Normalize(const quaternion &q) noexcept {
+    const f32 inv_length = 1.0f / std::sqrt(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+    return {q.x * inv_length, q.y * inv_length, q.z * inv_length, q.w * inv_length};
+}
+
+inline float3 Rotate(const float3 &v, const quaternion &q) noexcept {
+    // v + 2w(u x v) + 2u x (u x v)
+    const float3 u{q.x, q.y, q.z};
+    const float3 t = Cross(u, v) * 2.0f;
+    return v + t * q.w + Cross(u, t);
+}
+
+// shortest path, falls back to nlerp for nearly parallel rotations
+inline quaternion Slerp(const quaternion &a, quaternion b, f32 t) noexcept {
+    f32 cos_theta = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    if (cos_theta < 0.0f) {
+        b = {-b.x, -b.y, -b.z, -b.w};
+        cos_theta = -cos_theta;
+    }
+    f32 wa = 1.0f - t, wb = t;
+    if (cos_theta < 0.9995f) {
+        const f32 theta = std::acos(cos_theta);
+        const f32 inv_sin = 1.0f / std::sin(theta);
+        wa = std::sin((1.0f - t) * theta) * inv_sin;
+        wb = std::sin(t * theta) * inv_sin;
+    }
+    return Normalize(quaternion{a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb});
+}
+
+inline float4x4 float4x4::CreateFromQuaternion(const quaternion &q) noexcept {
+    const f32 xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    const f32 xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const f32 wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+    return {1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz),        2.0f * (xz - wy),        0.0f,
+            2.0f * (xy - wz),        1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx),        0.0f,
+            2.0f * (xz + wy),        2.0f * (yz - wx),        1.0f - 2.0f * (xx + yy), 0.0f,
+            0.0f,                    0.0f,                    0.0f,                    1.0f};
+}
+
+} // namespace Fract::Math
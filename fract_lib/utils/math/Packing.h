@@ -0,0 +1,294 @@
+/*****************************************************************//**
+ * \file   Packing.h
+ * \brief  half float, normalized integer and octahedral encodings
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "Math.h"
+
+// batch conversions use f16c and avx-512 when the compiler targets them, msvc has no f16c macro but /arch:AVX2
+// implies it. MATH_FORCE_SCALAR disables both like the backends in Simd.h.
+#ifndef MATH_FORCE_SCALAR
+#if defined(__AVX512F__)
+#define MATH_USE_AVX512
+#endif
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+#define MATH_USE_F16C
+#endif
+#endif // MATH_FORCE_SCALAR
+
+#if defined(MATH_USE_AVX512) || defined(MATH_USE_F16C)
+#include <immintrin.h>
+#endif
+
+namespace Fract::Math {
+
+// ieee 754 binary16, round to nearest even, nan payload is kept and quieted
+inline u16 FloatToHalf(f32 value) {
+    constexpr u32 f32_infinity = 255u << 23;
+    constexpr u32 f16_max = (127u + 16u) << 23;
+    constexpr u32 denorm_magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const u32 sign = bits & 0x80000000u;
+    bits ^= sign;
+
+    u32 half;
+    if (bits >= f16_max) {
+        // inf or nan, values that round past 65504 end up here as well
+        half = bits > f32_infinity ? 0x7e00u | ((bits >> 13) & 0x3ffu) : 0x7c00u;
+    } else if (bits < (113u << 23)) {
+        // half subnormal or zero, let the fpu do the rounding
+        f32 f, magic;
+        std::memcpy(&f, &bits, sizeof(f));
+        std::memcpy(&magic, &denorm_magic, sizeof(magic));
+        f += magic;
+        std::memcpy(&bits, &f, sizeof(bits));
+        half = bits - denorm_magic;
+    } else {
+        const u32 mantissa_odd = (bits >> 13) & 1u;
+        bits += ((15u - 127u) << 23) + 0xfffu;
+        bits += mantissa_odd;
+        half = bits >> 13;
+    }
+    return static_cast<u16>(half | (sign >> 16));
+}
+
+// nan is quieted, matching f16c
+inline f32 HalfToFloat(u16 value) {
+    constexpr u32 shifted_exponent = 0x7c00u << 13;
+    constexpr u32 magic_bits = 113u << 23;
+
+    u32 bits = (value & 0x7fffu) << 13;
+    const u32 exponent = shifted_exponent & bits;
+    bits += (127u - 15u) << 23;
+
+    if (exponent == shifted_exponent) {
+        // inf or nan
+        bits += (128u - 16u) << 23;
+        if (bits & 0x7fffffu) {
+            bits |= 0x400000u;
+        }
+    } else if (exponent == 0) {
+        // zero or subnormal, renormalize
+        bits += 1u << 23;
+        f32 f, magic;
+        std::memcpy(&f, &bits, sizeof(f));
+        std::memcpy(&magic, &magic_bits, sizeof(magic));
+        f -= magic;
+        std::memcpy(&bits, &f, sizeof(bits));
+    }
+    bits |= static_cast<u32>(value & 0x8000u) << 16;
+
+    f32 result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// the quantizers clamp nan to the low end, converting it would be undefined. the comparison picks the bound for nan
+// like maxps does in the batch versions.
+
+// [0, 1] <-> [0, 65535]
+inline u16 QuantizeUnorm16(f32 value) {
+    return static_cast<u16>(std::min(value > 0.0f ? value : 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+
+inline f32 DequantizeUnorm16(u16 value) {
+    return static_cast<f32>(value) * (1.0f / 65535.0f);
+}
+
+// [-1, 1] <-> [-32767, 32767]
+inline i16 QuantizeSnorm16(f32 value) {
+    return static_cast<i16>(std::round(std::min(value > -1.0f ? value : -1.0f, 1.0f) * 32767.0f));
+}
+
+inline f32 DequantizeSnorm16(i16 value) {
+    return std::max(static_cast<f32>(value) * (1.0f / 32767.0f), -1.0f);
+}
+
+// [0, 1] -> [0, 255]
+inline u8 QuantizeUnorm8(f32 value) {
+    return static_cast<u8>(std::min(value > 0.0f ? value : 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// batch versions of the conversions above, bit exact with them for every input nan included.
+// src and dst must not overlap.
+
+inline void FloatToHalf(const f32 *src, u16 *dst, size_t count) {
+    size_t i = 0;
+#if defined(MATH_USE_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        const __m256i half = _mm512_cvtps_ph(_mm512_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), half);
+    }
+#endif
+#if defined(MATH_USE_F16C)
+    for (; i + 8 <= count; i += 8) {
+        const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), half);
+    }
+    // one rgba texel
+    for (; i + 4 <= count; i += 4) {
+        const __m128i half = _mm_cvtps_ph(_mm_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), half);
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = FloatToHalf(src[i]);
+    }
+}
+
+inline void HalfToFloat(const u16 *src, f32 *dst, size_t count) {
+    size_t i = 0;
+#if defined(MATH_USE_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        _mm512_storeu_ps(dst + i, _mm512_cvtph_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i))));
+    }
+#endif
+#if defined(MATH_USE_F16C)
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i))));
+    }
+    // one rgba texel
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(dst + i, _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i))));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = HalfToFloat(src[i]);
+    }
+}
+
+#if defined(MATH_USE_SSE)
+namespace Detail {
+
+// clamps to [low, high], nan becomes low
+inline __m128 Clamp(__m128 value, f32 low, f32 high) noexcept {
+    return _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(low)), _mm_set1_ps(high));
+}
+
+// value * scale + 0.5 truncated, the scalar quantizers' rounding
+inline __m128i QuantizeUnsigned(__m128 value, f32 scale) noexcept {
+    return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Clamp(value, 0.0f, 1.0f), _mm_set1_ps(scale)), _mm_set1_ps(0.5f)));
+}
+
+// std::round of value * scale, half away from zero. adding just under 0.5 keeps 0.49999997 from rounding up.
+inline __m128i QuantizeSigned(__m128 value, f32 scale) noexcept {
+    value = _mm_mul_ps(Clamp(value, -1.0f, 1.0f), _mm_set1_ps(scale));
+    const __m128 bias = _mm_or_ps(_mm_and_ps(value, _mm_set1_ps(-0.0f)), _mm_set1_ps(0.49999997f));
+    return _mm_cvttps_epi32(_mm_add_ps(value, bias));
+}
+
+} // namespace Detail
+#endif
+
+// quantized lanes are converted with truncation so the sse paths below match the scalar casts. sse2 has no unsigned
+// saturating pack, unorm16 is biased into the signed range and back.
+
+inline void QuantizeUnorm8(const f32 *src, u8 *dst, size_t count) {
+    size_t i = 0;
+#if defined(MATH_USE_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        __m512 value = _mm512_max_ps(_mm512_loadu_ps(src + i), _mm512_setzero_ps());
+        value = _mm512_min_ps(value, _mm512_set1_ps(1.0f));
+        value = _mm512_add_ps(_mm512_mul_ps(value, _mm512_set1_ps(255.0f)), _mm512_set1_ps(0.5f));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm512_cvtepi32_epi8(_mm512_cvttps_epi32(value)));
+    }
+#endif
+#if defined(MATH_USE_SSE)
+    for (; i + 8 <= count; i += 8) {
+        const __m128i words = _mm_packs_epi32(Detail::QuantizeUnsigned(_mm_loadu_ps(src + i), 255.0f),
+                                              Detail::QuantizeUnsigned(_mm_loadu_ps(src + i + 4), 255.0f));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(words, words));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = QuantizeUnorm8(src[i]);
+    }
+}
+
+inline void QuantizeUnorm16(const f32 *src, u16 *dst, size_t count) {
+    size_t i = 0;
+#if defined(MATH_USE_AVX512)
+    for (; i + 16 <= count; i += 16) {
+        __m512 value = _mm512_max_ps(_mm512_loadu_ps(src + i), _mm512_setzero_ps());
+        value = _mm512_min_ps(value, _mm512_set1_ps(1.0f));
+        value = _mm512_add_ps(_mm512_mul_ps(value, _mm512_set1_ps(65535.0f)), _mm512_set1_ps(0.5f));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm512_cvtepi32_epi16(_mm512_cvttps_epi32(value)));
+    }
+#endif
+#if defined(MATH_USE_SSE)
+    const __m128i bias = _mm_set1_epi32(32768);
+    for (; i + 8 <= count; i += 8) {
+        const __m128i lo = _mm_sub_epi32(Detail::QuantizeUnsigned(_mm_loadu_ps(src + i), 65535.0f), bias);
+        const __m128i hi = _mm_sub_epi32(Detail::QuantizeUnsigned(_mm_loadu_ps(src + i + 4), 65535.0f), bias);
+        const __m128i words = _mm_packs_epi32(lo, hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(words, _mm_set1_epi16(-32768)));
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = QuantizeUnorm16(src[i]);
+    }
+}
+
+inline void QuantizeSnorm16(const f32 *src, i16 *dst, size_t count) {
+    size_t i = 0;
+#if defined(MATH_USE_SSE)
+    for (; i + 8 <= count; i += 8) {
+        const __m128i words = _mm_packs_epi32(Detail::QuantizeSigned(_mm_loadu_ps(src + i), 32767.0f),
+                                              Detail::QuantizeSigned(_mm_loadu_ps(src + i + 4), 32767.0f));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), words);
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] = QuantizeSnorm16(src[i]);
+    }
+}
+
+// octahedral mapping of unit vectors to [-1, 1]^2
+// http://jcgt.org/published/0003/02/01/
+inline float2 OctEncode(const float3 &n) {
+    const f32 inv_l1 = 1.0f / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+    f32 x = n.x * inv_l1;
+    f32 y = n.y * inv_l1;
+    if (n.z < 0.0f) {
+        const f32 wrapped_x = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        const f32 wrapped_y = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = wrapped_x;
+        y = wrapped_y;
+    }
+    return float2{x, y};
+}
+
+inline float3 OctDecode(const float2 &e) {
+    float3 n{e.x, e.y, 1.0f - std::abs(e.x) - std::abs(e.y)};
+    const f32 t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return Normalize(n);
+}
+
+// unit vector -> 2 x snorm16
+inline u32 PackOctahedral(const float3 &n) {
+    const float2 e = OctEncode(n);
+    return static_cast<u32>(static_cast<u16>(QuantizeSnorm16(e.x))) |
+           (static_cast<u32>(static_cast<u16>(QuantizeSnorm16(e.y))) << 16);
+}
+
+inline float3 UnpackOctahedral(u32 packed) {
+    const i16 x = static_cast<i16>(packed & 0xffffu);
+    const i16 y = static_cast<i16>(packed >> 16);
+    return OctDecode(float2{DequantizeSnorm16(x), DequantizeSnorm16(y)});
+}
+
+} // namespace Fract::Math
@@ -0,0 +1,650 @@
+/*****************************************************************//**
+ * \file   Simd.h
+ * \brief  4 and 8 wide float registers over sse, avx2, neon or plain arrays
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// the backend follows the compiler flags (/arch:AVX2, -mavx2, aarch64), MATH_FORCE_SCALAR disables all of them
+#ifndef MATH_FORCE_SCALAR
+#if defined(__AVX2__)
+#define MATH_USE_AVX2
+#define MATH_USE_SSE
+#if defined(__FMA__) || defined(_MSC_VER)
+#define MATH_USE_FMA
+#endif
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATH_USE_SSE
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define MATH_USE_NEON
+#endif
+#endif // MATH_FORCE_SCALAR
+
+#if defined(MATH_USE_AVX2)
+#include <immintrin.h>
+#elif defined(MATH_USE_SSE)
+#include <emmintrin.h>
+#elif defined(MATH_USE_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace Fract::Math {
+
+// comparisons return lanes with all bits set or cleared, use them with Select(), Any(), All() or MoveMask()
+struct f32x4 {
+#if defined(MATH_USE_SSE)
+    using Native = __m128;
+#elif defined(MATH_USE_NEON)
+    using Native = float32x4_t;
+#else
+    struct Native {
+        float lane[4];
+    };
+#endif
+    static constexpr uint32_t WIDTH = 4;
+
+    Native v;
+
+    f32x4() noexcept = default;
+    f32x4(Native native) noexcept : v(native) {}
+    f32x4(float value) noexcept {
+#if defined(MATH_USE_SSE)
+        v = _mm_set1_ps(value);
+#elif defined(MATH_USE_NEON)
+        v = vdupq_n_f32(value);
+#else
+        v = Native{{value, value, value, value}};
+#endif
+    }
+    f32x4(float x, float y, float z, float w) noexcept {
+#if defined(MATH_USE_SSE)
+        v = _mm_setr_ps(x, y, z, w);
+#elif defined(MATH_USE_NEON)
+        const float lanes[4] = {x, y, z, w};
+        v = vld1q_f32(lanes);
+#else
+        v = Native{{x, y, z, w}};
+#endif
+    }
+
+    // unaligned
+    static f32x4 Load(const float *data) noexcept {
+#if defined(MATH_USE_SSE)
+        return _mm_loadu_ps(data);
+#elif defined(MATH_USE_NEON)
+        return vld1q_f32(data);
+#else
+        return Native{{data[0], data[1], data[2], data[3]}};
+#endif
+    }
+
+    void Store(float *data) const noexcept {
+#if defined(MATH_USE_SSE)
+        _mm_storeu_ps(data, v);
+#elif defined(MATH_USE_NEON)
+        vst1q_f32(data, v);
+#else
+        for (uint32_t i = 0; i < WIDTH; i++) {
+            data[i] = v.lane[i];
+        }
+#endif
+    }
+
+    float operator[](uint32_t lane) const noexcept {
+        float lanes[WIDTH];
+        Store(lanes);
+        return lanes[lane];
+    }
+};
+
+namespace Detail {
+
+inline float FromBits(uint32_t bits) noexcept {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline uint32_t ToBits(float value) noexcept {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+#if !defined(MATH_USE_SSE) && !defined(MATH_USE_NEON)
+template <typename Op> inline f32x4 Map(const f32x4 &a, const f32x4 &b, Op op) noexcept {
+    return f32x4::Native{{op(a.v.lane[0], b.v.lane[0]), op(a.v.lane[1], b.v.lane[1]), op(a.v.lane[2], b.v.lane[2]),
+                          op(a.v.lane[3], b.v.lane[3])}};
+}
+
+template <typename Op> inline f32x4 Map(const f32x4 &a, Op op) noexcept {
+    return f32x4::Native{{op(a.v.lane[0]), op(a.v.lane[1]), op(a.v.lane[2]), op(a.v.lane[3])}};
+}
+
+inline float MaskOf(bool condition) noexcept { return FromBits(condition ? ~0u : 0u); }
+#endif
+
+#if defined(MATH_USE_NEON)
+inline float32x4_t MaskOf(uint32x4_t mask) noexcept { return vreinterpretq_f32_u32(mask); }
+inline uint32x4_t BitsOf(float32x4_t value) noexcept { return vreinterpretq_u32_f32(value); }
+#endif
+
+} // namespace Detail
+
+inline f32x4 operator+(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_add_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return vaddq_f32(a.v, b.v);
+#else
+    return Detail::Map(a, b, [](float x, float y) { return x + y; });
+#endif
+}
+
+inline f32x4 operator-(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_sub_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return vsubq_f32(a.v, b.v);
+#else
+    return Detail::Map(a, b, [](float x, float y) { return x - y; });
+#endif
+}
+
+inline f32x4 operator*(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_mul_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return vmulq_f32(a.v, b.v);
+#else
+    return Detail::Map(a, b, [](float x, float y) { return x * y; });
+#endif
+}
+
+inline f32x4 operator/(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_div_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return vdivq_f32(a.v, b.v);
+#else
+    return Detail::Map(a, b, [](float x, float y) { return x / y; });
+#endif
+}
+
+inline f32x4 operator-(const f32x4 &a) noexcept { return f32x4(0.0f) - a; }
+
+inline f32x4 &operator+=(f32x4 &a, const f32x4 &b) noexcept { return a = a + b; }
+inline f32x4 &operator-=(f32x4 &a, const f32x4 &b) noexcept { return a = a - b; }
+inline f32x4 &operator*=(f32x4 &a, const f32x4 &b) noexcept { return a = a * b; }
+inline f32x4 &operator/=(f32x4 &a, const f32x4 &b) noexcept { return a = a / b; }
+
+inline f32x4 operator&(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_and_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(vandq_u32(Detail::BitsOf(a.v), Detail::BitsOf(b.v)));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::FromBits(Detail::ToBits(x) & Detail::ToBits(y)); });
+#endif
+}
+
+inline f32x4 operator|(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_or_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(vorrq_u32(Detail::BitsOf(a.v), Detail::BitsOf(b.v)));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::FromBits(Detail::ToBits(x) | Detail::ToBits(y)); });
+#endif
+}
+
+inline f32x4 operator^(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_xor_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(veorq_u32(Detail::BitsOf(a.v), Detail::BitsOf(b.v)));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::FromBits(Detail::ToBits(x) ^ Detail::ToBits(y)); });
+#endif
+}
+
+// ~a & b
+inline f32x4 AndNot(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_andnot_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(vbicq_u32(Detail::BitsOf(b.v), Detail::BitsOf(a.v)));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::FromBits(~Detail::ToBits(x) & Detail::ToBits(y)); });
+#endif
+}
+
+inline f32x4 operator<(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_cmplt_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(vcltq_f32(a.v, b.v));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::MaskOf(x < y); });
+#endif
+}
+
+inline f32x4 operator<=(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_cmple_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(vcleq_f32(a.v, b.v));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::MaskOf(x <= y); });
+#endif
+}
+
+inline f32x4 operator==(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_cmpeq_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return Detail::MaskOf(vceqq_f32(a.v, b.v));
+#else
+    return Detail::Map(a, b, [](float x, float y) { return Detail::MaskOf(x == y); });
+#endif
+}
+
+inline f32x4 operator>(const f32x4 &a, const f32x4 &b) noexcept { return b < a; }
+inline f32x4 operator>=(const f32x4 &a, const f32x4 &b) noexcept { return b <= a; }
+inline f32x4 operator!=(const f32x4 &a, const f32x4 &b) noexcept {
+    return AndNot(a == b, f32x4(Detail::FromBits(~0u)));
+}
+
+// lanes of a where the mask is set, b elsewhere
+inline f32x4 Select(const f32x4 &mask, const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_AVX2)
+    return _mm_blendv_ps(b.v, a.v, mask.v);
+#elif defined(MATH_USE_SSE)
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+#elif defined(MATH_USE_NEON)
+    return vbslq_f32(Detail::BitsOf(mask.v), a.v, b.v);
+#else
+    return (mask & a) | AndNot(mask, b);
+#endif
+}
+
+// bit i is the sign of lane i
+inline uint32_t MoveMask(const f32x4 &mask) noexcept {
+#if defined(MATH_USE_SSE)
+    return static_cast<uint32_t>(_mm_movemask_ps(mask.v));
+#elif defined(MATH_USE_NEON)
+    const uint32x4_t bits = vshrq_n_u32(Detail::BitsOf(mask.v), 31);
+    const int32_t shift[4] = {0, 1, 2, 3};
+    return vaddvq_u32(vshlq_u32(bits, vld1q_s32(shift)));
+#else
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < f32x4::WIDTH; i++) {
+        result |= (Detail::ToBits(mask.v.lane[i]) >> 31) << i;
+    }
+    return result;
+#endif
+}
+
+inline bool Any(const f32x4 &mask) noexcept { return MoveMask(mask) != 0; }
+inline bool All(const f32x4 &mask) noexcept { return MoveMask(mask) == 0xf; }
+
+inline f32x4 Min(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_min_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    // not vminq_f32, a nan in either lane returns b like minps and the scalar path
+    return vbslq_f32(vcltq_f32(a.v, b.v), a.v, b.v);
+#else
+    return Detail::Map(a, b, [](float x, float y) { return x < y ? x : y; });
+#endif
+}
+
+inline f32x4 Max(const f32x4 &a, const f32x4 &b) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_max_ps(a.v, b.v);
+#elif defined(MATH_USE_NEON)
+    return vbslq_f32(vcgtq_f32(a.v, b.v), a.v, b.v);
+#else
+    return Detail::Map(a, b, [](float x, float y) { return x > y ? x : y; });
+#endif
+}
+
+inline f32x4 Abs(const f32x4 &a) noexcept { return AndNot(f32x4(-0.0f), a); }
+
+// a * b + c, fused where the target has fma
+inline f32x4 MulAdd(const f32x4 &a, const f32x4 &b, const f32x4 &c) noexcept {
+#if defined(MATH_USE_FMA)
+    return _mm_fmadd_ps(a.v, b.v, c.v);
+#elif defined(MATH_USE_NEON)
+    return vfmaq_f32(c.v, a.v, b.v);
+#else
+    return a * b + c;
+#endif
+}
+
+inline f32x4 Sqrt(const f32x4 &a) noexcept {
+#if defined(MATH_USE_SSE)
+    return _mm_sqrt_ps(a.v);
+#elif defined(MATH_USE_NEON)
+    return vsqrtq_f32(a.v);
+#else
+    return Detail::Map(a, [](float x) { return std::sqrt(x); });
+#endif
+}
+
+// hardware estimate refined by newton steps, relative error below 1e-6. like the scalar path 0 gives inf and inf
+// gives 0, the step itself would turn them into nan (0 * inf)
+inline f32x4 Rsqrt(const f32x4 &a) noexcept {
+#if defined(MATH_USE_SSE)
+    const f32x4 estimate = _mm_rsqrt_ps(a.v);
+    const f32x4 refined = estimate * (f32x4(1.5f) - f32x4(0.5f) * a * estimate * estimate);
+    return Select(refined != refined, estimate, refined);
+#elif defined(MATH_USE_NEON)
+    // the neon estimate has 8 bits against 12 on x86, two steps reach the same precision. vrsqrtsq_f32 handles
+    // 0 * inf itself
+    float32x4_t estimate = vrsqrteq_f32(a.v);
+    estimate = vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+    return vmulq_f32(estimate, vrsqrtsq_f32(vmulq_f32(a.v, estimate), estimate));
+#else
+    return Detail::Map(a, [](float x) { return 1.0f / std::sqrt(x); });
+#endif
+}
+
+// hardware estimate refined by newton steps, 0 and inf behave as in Rsqrt()
+inline f32x4 Rcp(const f32x4 &a) noexcept {
+#if defined(MATH_USE_SSE)
+    const f32x4 estimate = _mm_rcp_ps(a.v);
+    const f32x4 refined = estimate * (f32x4(2.0f) - a * estimate);
+    return Select(refined != refined, estimate, refined);
+#elif defined(MATH_USE_NEON)
+    float32x4_t estimate = vrecpeq_f32(a.v);
+    estimate = vmulq_f32(estimate, vrecpsq_f32(a.v, estimate));
+    return vmulq_f32(estimate, vrecpsq_f32(a.v, estimate));
+#else
+    return Detail::Map(a, [](float x) { return 1.0f / x; });
+#endif
+}
+
+inline f32x4 Floor(const f32x4 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    return _mm_floor_ps(a.v);
+#elif defined(MATH_USE_SSE)
+    // truncate and step down for negative fractions, values above 2^23 have no fraction
+    const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+    const __m128 floored = _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.0f)));
+    return Select(Abs(a) < f32x4(8388608.0f), floored, a);
+#elif defined(MATH_USE_NEON)
+    return vrndmq_f32(a.v);
+#else
+    return Detail::Map(a, [](float x) { return std::floor(x); });
+#endif
+}
+
+// 2^n for integer valued n in [-126, 127], written straight into the exponent bits
+inline f32x4 Pow2(const f32x4 &n) noexcept {
+#if defined(MATH_USE_SSE)
+    const __m128i exponent = _mm_add_epi32(_mm_cvttps_epi32(n.v), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(exponent, 23));
+#elif defined(MATH_USE_NEON)
+    const int32x4_t exponent = vaddq_s32(vcvtq_s32_f32(n.v), vdupq_n_s32(127));
+    return vreinterpretq_f32_s32(vshlq_n_s32(exponent, 23));
+#else
+    return Detail::Map(n, [](float x) {
+        return Detail::FromBits(static_cast<uint32_t>(static_cast<int32_t>(x) + 127) << 23);
+    });
+#endif
+}
+
+// floor(log2(|x|)) of a normal x, read from the exponent bits
+inline f32x4 Exponent(const f32x4 &x) noexcept {
+#if defined(MATH_USE_SSE)
+    const __m128i biased = _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(x.v), 23), _mm_set1_epi32(0xff));
+    return _mm_cvtepi32_ps(_mm_sub_epi32(biased, _mm_set1_epi32(127)));
+#elif defined(MATH_USE_NEON)
+    const uint32x4_t biased = vandq_u32(vshrq_n_u32(Detail::BitsOf(x.v), 23), vdupq_n_u32(0xff));
+    return vcvtq_f32_s32(vsubq_s32(vreinterpretq_s32_u32(biased), vdupq_n_s32(127)));
+#else
+    return Detail::Map(x, [](float v) {
+        return static_cast<float>(static_cast<int32_t>((Detail::ToBits(v) >> 23) & 0xff) - 127);
+    });
+#endif
+}
+
+inline float ReduceAdd(const f32x4 &a) noexcept {
+#if defined(MATH_USE_SSE)
+    const __m128 pairs = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+    return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+#elif defined(MATH_USE_NEON)
+    return vaddvq_f32(a.v);
+#else
+    return (a.v.lane[0] + a.v.lane[1]) + (a.v.lane[2] + a.v.lane[3]);
+#endif
+}
+
+inline float ReduceMin(const f32x4 &a) noexcept {
+    const float x = a[0] < a[1] ? a[0] : a[1];
+    const float y = a[2] < a[3] ? a[2] : a[3];
+    return x < y ? x : y;
+}
+
+inline float ReduceMax(const f32x4 &a) noexcept {
+    const float x = a[0] > a[1] ? a[0] : a[1];
+    const float y = a[2] > a[3] ? a[2] : a[3];
+    return x > y ? x : y;
+}
+
+// 8 lanes, one ymm register with avx2 and two 4 wide halves otherwise
+struct f32x8 {
+#if defined(MATH_USE_AVX2)
+    using Native = __m256;
+#else
+    struct Native {
+        f32x4 lo, hi;
+    };
+#endif
+    static constexpr uint32_t WIDTH = 8;
+
+    Native v;
+
+    f32x8() noexcept = default;
+    f32x8(Native native) noexcept : v(native) {}
+    f32x8(float value) noexcept {
+#if defined(MATH_USE_AVX2)
+        v = _mm256_set1_ps(value);
+#else
+        v = Native{f32x4(value), f32x4(value)};
+#endif
+    }
+#if !defined(MATH_USE_AVX2)
+    f32x8(const f32x4 &lo, const f32x4 &hi) noexcept : v{lo, hi} {}
+#endif
+
+    static f32x8 Load(const float *data) noexcept {
+#if defined(MATH_USE_AVX2)
+        return _mm256_loadu_ps(data);
+#else
+        return f32x8(f32x4::Load(data), f32x4::Load(data + 4));
+#endif
+    }
+
+    void Store(float *data) const noexcept {
+#if defined(MATH_USE_AVX2)
+        _mm256_storeu_ps(data, v);
+#else
+        v.lo.Store(data);
+        v.hi.Store(data + 4);
+#endif
+    }
+
+    float operator[](uint32_t lane) const noexcept {
+        float lanes[WIDTH];
+        Store(lanes);
+        return lanes[lane];
+    }
+};
+
+#if defined(MATH_USE_AVX2)
+#define MATH_F32X8_BINARY(name, avx, op)                                                                              \
+    inline f32x8 name(const f32x8 &a, const f32x8 &b) noexcept { return avx(a.v, b.v); }
+#else
+#define MATH_F32X8_BINARY(name, avx, op)                                                                              \
+    inline f32x8 name(const f32x8 &a, const f32x8 &b) noexcept { return f32x8(op(a.v.lo, b.v.lo), op(a.v.hi, b.v.hi)); }
+#endif
+
+MATH_F32X8_BINARY(operator+, _mm256_add_ps, operator+)
+MATH_F32X8_BINARY(operator-, _mm256_sub_ps, operator-)
+MATH_F32X8_BINARY(operator*, _mm256_mul_ps, operator*)
+MATH_F32X8_BINARY(operator/, _mm256_div_ps, operator/)
+MATH_F32X8_BINARY(operator&, _mm256_and_ps, operator&)
+MATH_F32X8_BINARY(operator|, _mm256_or_ps, operator|)
+MATH_F32X8_BINARY(operator^, _mm256_xor_ps, operator^)
+MATH_F32X8_BINARY(AndNot, _mm256_andnot_ps, AndNot)
+MATH_F32X8_BINARY(Min, _mm256_min_ps, Min)
+MATH_F32X8_BINARY(Max, _mm256_max_ps, Max)
+
+#undef MATH_F32X8_BINARY
+
+inline f32x8 operator-(const f32x8 &a) noexcept { return f32x8(0.0f) - a; }
+
+inline f32x8 &operator+=(f32x8 &a, const f32x8 &b) noexcept { return a = a + b; }
+inline f32x8 &operator-=(f32x8 &a, const f32x8 &b) noexcept { return a = a - b; }
+inline f32x8 &operator*=(f32x8 &a, const f32x8 &b) noexcept { return a = a * b; }
+inline f32x8 &operator/=(f32x8 &a, const f32x8 &b) noexcept { return a = a / b; }
+
+#if defined(MATH_USE_AVX2)
+inline f32x8 operator<(const f32x8 &a, const f32x8 &b) noexcept { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline f32x8 operator<=(const f32x8 &a, const f32x8 &b) noexcept { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline f32x8 operator==(const f32x8 &a, const f32x8 &b) noexcept { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); }
+inline f32x8 operator!=(const f32x8 &a, const f32x8 &b) noexcept { return _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ); }
+#else
+inline f32x8 operator<(const f32x8 &a, const f32x8 &b) noexcept { return f32x8(a.v.lo < b.v.lo, a.v.hi < b.v.hi); }
+inline f32x8 operator<=(const f32x8 &a, const f32x8 &b) noexcept {
+    return f32x8(a.v.lo <= b.v.lo, a.v.hi <= b.v.hi);
+}
+inline f32x8 operator==(const f32x8 &a, const f32x8 &b) noexcept {
+    return f32x8(a.v.lo == b.v.lo, a.v.hi == b.v.hi);
+}
+inline f32x8 operator!=(const f32x8 &a, const f32x8 &b) noexcept {
+    return f32x8(a.v.lo != b.v.lo, a.v.hi != b.v.hi);
+}
+#endif
+inline f32x8 operator>(const f32x8 &a, const f32x8 &b) noexcept { return b < a; }
+inline f32x8 operator>=(const f32x8 &a, const f32x8 &b) noexcept { return b <= a; }
+
+inline f32x8 Select(const f32x8 &mask, const f32x8 &a, const f32x8 &b) noexcept {
+#if defined(MATH_USE_AVX2)
+    return _mm256_blendv_ps(b.v, a.v, mask.v);
+#else
+    return f32x8(Select(mask.v.lo, a.v.lo, b.v.lo), Select(mask.v.hi, a.v.hi, b.v.hi));
+#endif
+}
+
+inline uint32_t MoveMask(const f32x8 &mask) noexcept {
+#if defined(MATH_USE_AVX2)
+    return static_cast<uint32_t>(_mm256_movemask_ps(mask.v));
+#else
+    return MoveMask(mask.v.lo) | (MoveMask(mask.v.hi) << 4);
+#endif
+}
+
+inline bool Any(const f32x8 &mask) noexcept { return MoveMask(mask) != 0; }
+inline bool All(const f32x8 &mask) noexcept { return MoveMask(mask) == 0xff; }
+
+inline f32x8 Abs(const f32x8 &a) noexcept { return AndNot(f32x8(-0.0f), a); }
+
+inline f32x8 MulAdd(const f32x8 &a, const f32x8 &b, const f32x8 &c) noexcept {
+#if defined(MATH_USE_FMA)
+    return _mm256_fmadd_ps(a.v, b.v, c.v);
+#elif defined(MATH_USE_AVX2)
+    return _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v);
+#else
+    return f32x8(MulAdd(a.v.lo, b.v.lo, c.v.lo), MulAdd(a.v.hi, b.v.hi, c.v.hi));
+#endif
+}
+
+inline f32x8 Sqrt(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    return _mm256_sqrt_ps(a.v);
+#else
+    return f32x8(Sqrt(a.v.lo), Sqrt(a.v.hi));
+#endif
+}
+
+inline f32x8 Rsqrt(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    const f32x8 estimate = _mm256_rsqrt_ps(a.v);
+    const f32x8 refined = estimate * (f32x8(1.5f) - f32x8(0.5f) * a * estimate * estimate);
+    return Select(refined != refined, estimate, refined);
+#else
+    return f32x8(Rsqrt(a.v.lo), Rsqrt(a.v.hi));
+#endif
+}
+
+inline f32x8 Rcp(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    const f32x8 estimate = _mm256_rcp_ps(a.v);
+    const f32x8 refined = estimate * (f32x8(2.0f) - a * estimate);
+    return Select(refined != refined, estimate, refined);
+#else
+    return f32x8(Rcp(a.v.lo), Rcp(a.v.hi));
+#endif
+}
+
+inline f32x8 Floor(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    return _mm256_floor_ps(a.v);
+#else
+    return f32x8(Floor(a.v.lo), Floor(a.v.hi));
+#endif
+}
+
+inline f32x8 Pow2(const f32x8 &n) noexcept {
+#if defined(MATH_USE_AVX2)
+    const __m256i exponent = _mm256_add_epi32(_mm256_cvttps_epi32(n.v), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(exponent, 23));
+#else
+    return f32x8(Pow2(n.v.lo), Pow2(n.v.hi));
+#endif
+}
+
+inline f32x8 Exponent(const f32x8 &x) noexcept {
+#if defined(MATH_USE_AVX2)
+    const __m256i biased = _mm256_and_si256(_mm256_srli_epi32(_mm256_castps_si256(x.v), 23), _mm256_set1_epi32(0xff));
+    return _mm256_cvtepi32_ps(_mm256_sub_epi32(biased, _mm256_set1_epi32(127)));
+#else
+    return f32x8(Exponent(x.v.lo), Exponent(x.v.hi));
+#endif
+}
+
+inline float ReduceAdd(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    return ReduceAdd(f32x4(_mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1))));
+#else
+    return ReduceAdd(a.v.lo + a.v.hi);
+#endif
+}
+
+inline float ReduceMin(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    return ReduceMin(f32x4(_mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1))));
+#else
+    return ReduceMin(Min(a.v.lo, a.v.hi));
+#endif
+}
+
+inline float ReduceMax(const f32x8 &a) noexcept {
+#if defined(MATH_USE_AVX2)
+    return ReduceMax(f32x4(_mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1))));
+#else
+    return ReduceMax(Max(a.v.lo, a.v.hi));
+#endif
+}
+
+} // namespace Fract::Math
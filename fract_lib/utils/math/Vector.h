@@ -0,0 +1,168 @@
+/*****************************************************************//**
+ * \file   Vector.h
+ * \brief  float2, float3 and float4
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cmath>
+
+#include "../defination.h"
+#include "Simd.h"
+
+namespace Fract::Math {
+
+// plain structs without padding so arrays of them can be uploaded or memcpy'd, float3 stays 12 bytes. float4 math
+// goes through f32x4, float2 and float3 are left to the compiler.
+
+struct float2 {
+    f32 x{}, y{};
+
+    float2() noexcept = default;
+    constexpr float2(f32 x, f32 y) noexcept : x(x), y(y) {}
+    constexpr explicit float2(f32 value) noexcept : x(value), y(value) {}
+
+    f32 &operator[](u32 axis) noexcept { return (&x)[axis]; }
+    f32 operator[](u32 axis) const noexcept { return (&x)[axis]; }
+
+    float2 &operator+=(const float2 &rhs) noexcept { return x += rhs.x, y += rhs.y, *this; }
+    float2 &operator-=(const float2 &rhs) noexcept { return x -= rhs.x, y -= rhs.y, *this; }
+    float2 &operator*=(const float2 &rhs) noexcept { return x *= rhs.x, y *= rhs.y, *this; }
+    float2 &operator*=(f32 rhs) noexcept { return x *= rhs, y *= rhs, *this; }
+    float2 &operator/=(f32 rhs) noexcept { return *this *= 1.0f / rhs; }
+
+    f32 Dot(const float2 &rhs) const noexcept { return x * rhs.x + y * rhs.y; }
+    f32 LengthSquared() const noexcept { return Dot(*this); }
+    f32 Length() const noexcept { return std::sqrt(LengthSquared()); }
+};
+
+struct float3 {
+    f32 x{}, y{}, z{};
+
+    float3() noexcept = default;
+    constexpr float3(f32 x, f32 y, f32 z) noexcept : x(x), y(y), z(z) {}
+    constexpr explicit float3(f32 value) noexcept : x(value), y(value), z(value) {}
+
+    f32 &operator[](u32 axis) noexcept { return (&x)[axis]; }
+    f32 operator[](u32 axis) const noexcept { return (&x)[axis]; }
+
+    float3 &operator+=(const float3 &rhs) noexcept { return x += rhs.x, y += rhs.y, z += rhs.z, *this; }
+    float3 &operator-=(const float3 &rhs) noexcept { return x -= rhs.x, y -= rhs.y, z -= rhs.z, *this; }
+    float3 &operator*=(const float3 &rhs) noexcept { return x *= rhs.x, y *= rhs.y, z *= rhs.z, *this; }
+    float3 &operator*=(f32 rhs) noexcept { return x *= rhs, y *= rhs, z *= rhs, *this; }
+    float3 &operator/=(f32 rhs) noexcept { return *this *= 1.0f / rhs; }
+
+    f32 Dot(const float3 &rhs) const noexcept { return x * rhs.x + y * rhs.y + z * rhs.z; }
+    float3 Cross(const float3 &rhs) const noexcept {
+        return {y * rhs.z - z * rhs.y, z * rhs.x - x * rhs.z, x * rhs.y - y * rhs.x};
+    }
+    f32 LengthSquared() const noexcept { return Dot(*this); }
+    f32 Length() const noexcept { return std::sqrt(LengthSquared()); }
+    void Normalize() noexcept { *this *= 1.0f / Length(); }
+    void Normalize(float3 &result) const noexcept { (result = *this).Normalize(); }
+};
+
+struct float4 {
+    f32 x{}, y{}, z{}, w{};
+
+    float4() noexcept = default;
+    constexpr float4(f32 x, f32 y, f32 z, f32 w) noexcept : x(x), y(y), z(z), w(w) {}
+    constexpr float4(const float3 &xyz, f32 w) noexcept : x(xyz.x), y(xyz.y), z(xyz.z), w(w) {}
+    constexpr explicit float4(f32 value) noexcept : x(value), y(value), z(value), w(value) {}
+    float4(const f32x4 &value) noexcept { value.Store(&x); }
+
+    operator f32x4() const noexcept { return f32x4::Load(&x); }
+
+    f32 &operator[](u32 axis) noexcept { return (&x)[axis]; }
+    f32 operator[](u32 axis) const noexcept { return (&x)[axis]; }
+
+    float4 &operator+=(const float4 &rhs) noexcept { return *this = f32x4(*this) + f32x4(rhs); }
+    float4 &operator-=(const float4 &rhs) noexcept { return *this = f32x4(*this) - f32x4(rhs); }
+    float4 &operator*=(const float4 &rhs) noexcept { return *this = f32x4(*this) * f32x4(rhs); }
+    float4 &operator*=(f32 rhs) noexcept { return *this = f32x4(*this) * f32x4(rhs); }
+    float4 &operator/=(f32 rhs) noexcept { return *this *= 1.0f / rhs; }
+
+    f32 Dot(const float4 &rhs) const noexcept { return ReduceAdd(f32x4(*this) * f32x4(rhs)); }
+    f32 LengthSquared() const noexcept { return Dot(*this); }
+    f32 Length() const noexcept { return std::sqrt(LengthSquared()); }
+};
+
+static_assert(sizeof(float2) == 8 && sizeof(float3) == 12 && sizeof(float4) == 16);
+
+inline float2 operator+(float2 lhs, const float2 &rhs) noexcept { return lhs += rhs; }
+inline float2 operator-(float2 lhs, const float2 &rhs) noexcept { return lhs -= rhs; }
+inline float2 operator*(float2 lhs, const float2 &rhs) noexcept { return lhs *= rhs; }
+inline float2 operator/(const float2 &lhs, const float2 &rhs) noexcept { return {lhs.x / rhs.x, lhs.y / rhs.y}; }
+inline float2 operator*(float2 lhs, f32 rhs) noexcept { return lhs *= rhs; }
+inline float2 operator*(f32 lhs, float2 rhs) noexcept { return rhs *= lhs; }
+inline float2 operator/(float2 lhs, f32 rhs) noexcept { return lhs /= rhs; }
+inline float2 operator-(const float2 &v) noexcept { return {-v.x, -v.y}; }
+inline bool operator==(const float2 &lhs, const float2 &rhs) noexcept { return lhs.x == rhs.x && lhs.y == rhs.y; }
+inline bool operator!=(const float2 &lhs, const float2 &rhs) noexcept { return !(lhs == rhs); }
+
+inline float3 operator+(float3 lhs, const float3 &rhs) noexcept { return lhs += rhs; }
+inline float3 operator-(float3 lhs, const float3 &rhs) noexcept { return lhs -= rhs; }
+inline float3 operator*(float3 lhs, const float3 &rhs) noexcept { return lhs *= rhs; }
+inline float3 operator/(const float3 &lhs, const float3 &rhs) noexcept {
+    return {lhs.x / rhs.x, lhs.y / rhs.y, lhs.z / rhs.z};
+}
+inline float3 operator*(float3 lhs, f32 rhs) noexcept { return lhs *= rhs; }
+inline float3 operator*(f32 lhs, float3 rhs) noexcept { return rhs *= lhs; }
+inline float3 operator/(float3 lhs, f32 rhs) noexcept { return lhs /= rhs; }
+inline float3 operator-(const float3 &v) noexcept { return {-v.x, -v.y, -v.z}; }
+inline bool operator==(const float3 &lhs, const float3 &rhs) noexcept {
+    return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+}
+inline bool operator!=(const float3 &lhs, const float3 &rhs) noexcept { return !(lhs == rhs); }
+
+inline float4 operator+(float4 lhs, const float4 &rhs) noexcept { return lhs += rhs; }
+inline float4 operator-(float4 lhs, const float4 &rhs) noexcept { return lhs -= rhs; }
+inline float4 operator*(float4 lhs, const float4 &rhs) noexcept { return lhs *= rhs; }
+inline float4 operator/(const float4 &lhs, const float4 &rhs) noexcept { return f32x4(lhs) / f32x4(rhs); }
+inline float4 operator*(float4 lhs, f32 rhs) noexcept { return lhs *= rhs; }
+inline float4 operator*(f32 lhs, float4 rhs) noexcept { return rhs *= lhs; }
+inline float4 operator/(float4 lhs, f32 rhs) noexcept { return lhs /= rhs; }
+inline float4 operator-(const float4 &v) noexcept { return -f32x4(v); }
+inline bool operator==(const float4 &lhs, const float4 &rhs) noexcept { return All(f32x4(lhs) == f32x4(rhs)); }
+inline bool operator!=(const float4 &lhs, const float4 &rhs) noexcept { return !(lhs == rhs); }
+
+inline f32 Dot(const float2 &lhs, const float2 &rhs) noexcept { return lhs.Dot(rhs); }
+inline f32 Dot(const float3 &lhs, const float3 &rhs) noexcept { return lhs.Dot(rhs); }
+inline f32 Dot(const float4 &lhs, const float4 &rhs) noexcept { return lhs.Dot(rhs); }
+
+inline float3 Cross(const float3 &lhs, const float3 &rhs) noexcept { return lhs.Cross(rhs); }
+
+inline f32 Length(const float2 &v) noexcept { return v.Length(); }
+inline f32 Length(const float3 &v) noexcept { return v.Length(); }
+inline f32 Length(const float4 &v) noexcept { return v.Length(); }
+
+inline float2 Normalize(const float2 &v) noexcept { return v * (1.0f / v.Length()); }
+inline float3 Normalize(const float3 &v) noexcept { return v * (1.0f / v.Length()); }
+inline float4 Normalize(const float4 &v) noexcept { return v * (1.0f / v.Length()); }
+
+inline f32 GetComponent(const float3 &v, u32 axis) noexcept { return v[axis]; }
+
+// component-wise min/max
+inline float2 Min(const float2 &lhs, const float2 &rhs) noexcept {
+    return {std::fmin(lhs.x, rhs.x), std::fmin(lhs.y, rhs.y)};
+}
+inline float3 Min(const float3 &lhs, const float3 &rhs) noexcept {
+    return {std::fmin(lhs.x, rhs.x), std::fmin(lhs.y, rhs.y), std::fmin(lhs.z, rhs.z)};
+}
+inline float4 Min(const float4 &lhs, const float4 &rhs) noexcept { return Min(f32x4(lhs), f32x4(rhs)); }
+
+inline float2 Max(const float2 &lhs, const float2 &rhs) noexcept {
+    return {std::fmax(lhs.x, rhs.x), std::fmax(lhs.y, rhs.y)};
+}
+inline float3 Max(const float3 &lhs, const float3 &rhs) noexcept {
+    return {std::fmax(lhs.x, rhs.x), std::fmax(lhs.y, rhs.y), std::fmax(lhs.z, rhs.z)};
+}
+inline float4 Max(const float4 &lhs, const float4 &rhs) noexcept { return Max(f32x4(lhs), f32x4(rhs)); }
+
+inline float3 Abs(const float3 &v) noexcept { return {std::abs(v.x), std::abs(v.y), std::abs(v.z)}; }
+inline float4 Abs(const float4 &v) noexcept { return Abs(f32x4(v)); }
+
+} // namespace Fract::Math
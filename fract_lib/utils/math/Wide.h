@@ -0,0 +1,189 @@
+/*****************************************************************//**
+ * \file   Wide.h
+ * \brief  structure of arrays vectors for ray packets
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include "Simd.h"
+#include "Vector.h"
+
+namespace Fract::Math {
+
+// one vector per lane, F is f32x4 or f32x8. lane masks come from the comparisons of F.
+template <typename F> struct Float2Wide {
+    static constexpr u32 WIDTH = F::WIDTH;
+    F x, y;
+
+    Float2Wide() noexcept = default;
+    Float2Wide(const F &x, const F &y) noexcept : x(x), y(y) {}
+    explicit Float2Wide(const float2 &v) noexcept : x(v.x), y(v.y) {}
+
+    // WIDTH consecutive vectors
+    static Float2Wide Load(const float2 *values) noexcept {
+        f32 lanes[2][WIDTH];
+        for (u32 i = 0; i < WIDTH; i++) {
+            lanes[0][i] = values[i].x;
+            lanes[1][i] = values[i].y;
+        }
+        return {F::Load(lanes[0]), F::Load(lanes[1])};
+    }
+
+    void Store(float2 *values) const noexcept {
+        f32 lanes[2][WIDTH];
+        x.Store(lanes[0]);
+        y.Store(lanes[1]);
+        for (u32 i = 0; i < WIDTH; i++) {
+            values[i] = float2{lanes[0][i], lanes[1][i]};
+        }
+    }
+
+    float2 operator[](u32 lane) const noexcept { return {x[lane], y[lane]}; }
+};
+
+template <typename F> struct Float3Wide {
+    static constexpr u32 WIDTH = F::WIDTH;
+    F x, y, z;
+
+    Float3Wide() noexcept = default;
+    Float3Wide(const F &x, const F &y, const F &z) noexcept : x(x), y(y), z(z) {}
+    explicit Float3Wide(const float3 &v) noexcept : x(v.x), y(v.y), z(v.z) {}
+
+    static Float3Wide Load(const float3 *values) noexcept {
+        f32 lanes[3][WIDTH];
+        for (u32 i = 0; i < WIDTH; i++) {
+            lanes[0][i] = values[i].x;
+            lanes[1][i] = values[i].y;
+            lanes[2][i] = values[i].z;
+        }
+        return {F::Load(lanes[0]), F::Load(lanes[1]), F::Load(lanes[2])};
+    }
+
+    void Store(float3 *values) const noexcept {
+        f32 lanes[3][WIDTH];
+        x.Store(lanes[0]);
+        y.Store(lanes[1]);
+        z.Store(lanes[2]);
+        for (u32 i = 0; i < WIDTH; i++) {
+            values[i] = float3{lanes[0][i], lanes[1][i], lanes[2][i]};
+        }
+    }
+
+    float3 operator[](u32 lane) const noexcept { return {x[lane], y[lane], z[lane]}; }
+};
+
+template <typename F> struct Float4Wide {
+    static constexpr u32 WIDTH = F::WIDTH;
+    F x, y, z, w;
+
+    Float4Wide() noexcept = default;
+    Float4Wide(const F &x, const F &y, const F &z, const F &w) noexcept : x(x), y(y), z(z), w(w) {}
+    explicit Float4Wide(const float4 &v) noexcept : x(v.x), y(v.y), z(v.z), w(v.w) {}
+
+    static Float4Wide Load(const float4 *values) noexcept {
+        f32 lanes[4][WIDTH];
+        for (u32 i = 0; i < WIDTH; i++) {
+            for (u32 c = 0; c < 4; c++) {
+                lanes[c][i] = values[i][c];
+            }
+        }
+        return {F::Load(lanes[0]), F::Load(lanes[1]), F::Load(lanes[2]), F::Load(lanes[3])};
+    }
+
+    void Store(float4 *values) const noexcept {
+        f32 lanes[4][WIDTH];
+        x.Store(lanes[0]);
+        y.Store(lanes[1]);
+        z.Store(lanes[2]);
+        w.Store(lanes[3]);
+        for (u32 i = 0; i < WIDTH; i++) {
+            values[i] = float4{lanes[0][i], lanes[1][i], lanes[2][i], lanes[3][i]};
+        }
+    }
+
+    float4 operator[](u32 lane) const noexcept { return {x[lane], y[lane], z[lane], w[lane]}; }
+};
+
+// float4x4 is the matrix, 4 lanes of float4 are Float4Wide<f32x4>
+using float2x4 = Float2Wide<f32x4>;
+using float3x4 = Float3Wide<f32x4>;
+using float2x8 = Float2Wide<f32x8>;
+using float3x8 = Float3Wide<f32x8>;
+using float4x8 = Float4Wide<f32x8>;
+
+template <typename F> inline Float2Wide<F> operator+(const Float2Wide<F> &a, const Float2Wide<F> &b) noexcept {
+    return {a.x + b.x, a.y + b.y};
+}
+template <typename F> inline Float2Wide<F> operator-(const Float2Wide<F> &a, const Float2Wide<F> &b) noexcept {
+    return {a.x - b.x, a.y - b.y};
+}
+template <typename F> inline Float2Wide<F> operator*(const Float2Wide<F> &a, const Float2Wide<F> &b) noexcept {
+    return {a.x * b.x, a.y * b.y};
+}
+template <typename F> inline Float2Wide<F> operator*(const Float2Wide<F> &a, const F &s) noexcept {
+    return {a.x * s, a.y * s};
+}
+template <typename F> inline F Dot(const Float2Wide<F> &a, const Float2Wide<F> &b) noexcept {
+    return MulAdd(a.x, b.x, a.y * b.y);
+}
+template <typename F>
+inline Float2Wide<F> Select(const F &mask, const Float2Wide<F> &a, const Float2Wide<F> &b) noexcept {
+    return {Select(mask, a.x, b.x), Select(mask, a.y, b.y)};
+}
+
+template <typename F> inline Float3Wide<F> operator+(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {a.x + b.x, a.y + b.y, a.z + b.z};
+}
+template <typename F> inline Float3Wide<F> operator-(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {a.x - b.x, a.y - b.y, a.z - b.z};
+}
+template <typename F> inline Float3Wide<F> operator-(const Float3Wide<F> &a) noexcept { return {-a.x, -a.y, -a.z}; }
+template <typename F> inline Float3Wide<F> operator*(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {a.x * b.x, a.y * b.y, a.z * b.z};
+}
+template <typename F> inline Float3Wide<F> operator*(const Float3Wide<F> &a, const F &s) noexcept {
+    return {a.x * s, a.y * s, a.z * s};
+}
+template <typename F> inline Float3Wide<F> operator/(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {a.x / b.x, a.y / b.y, a.z / b.z};
+}
+template <typename F> inline F Dot(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return MulAdd(a.x, b.x, MulAdd(a.y, b.y, a.z * b.z));
+}
+template <typename F> inline Float3Wide<F> Cross(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+template <typename F> inline F Length(const Float3Wide<F> &a) noexcept { return Sqrt(Dot(a, a)); }
+template <typename F> inline Float3Wide<F> Normalize(const Float3Wide<F> &a) noexcept { return a * Rsqrt(Dot(a, a)); }
+template <typename F> inline Float3Wide<F> Min(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {Min(a.x, b.x), Min(a.y, b.y), Min(a.z, b.z)};
+}
+template <typename F> inline Float3Wide<F> Max(const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {Max(a.x, b.x), Max(a.y, b.y), Max(a.z, b.z)};
+}
+template <typename F>
+inline Float3Wide<F> Select(const F &mask, const Float3Wide<F> &a, const Float3Wide<F> &b) noexcept {
+    return {Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z)};
+}
+
+template <typename F> inline Float4Wide<F> operator+(const Float4Wide<F> &a, const Float4Wide<F> &b) noexcept {
+    return {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+}
+template <typename F> inline Float4Wide<F> operator-(const Float4Wide<F> &a, const Float4Wide<F> &b) noexcept {
+    return {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w};
+}
+template <typename F> inline Float4Wide<F> operator*(const Float4Wide<F> &a, const Float4Wide<F> &b) noexcept {
+    return {a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w};
+}
+template <typename F> inline Float4Wide<F> operator*(const Float4Wide<F> &a, const F &s) noexcept {
+    return {a.x * s, a.y * s, a.z * s, a.w * s};
+}
+template <typename F>
+inline Float4Wide<F> Select(const F &mask, const Float4Wide<F> &a, const Float4Wide<F> &b) noexcept {
+    return {Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z), Select(mask, a.w, b.w)};
+}
+
+} // namespace Fract::Math
@@ -8,13 +8,21 @@
 
 #include "Allocators.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
 #include <mimalloc.h>
 
-#include "../log/Log.h"
+#include "../log/log.h"
+#include "Memory.h"
 
 namespace Fract::Memory {
 
-GlobalMemoryAllocator::GlobalMemoryAllocator() noexcept {
+GlobalMemoryAllocator::GlobalMemoryAllocator(MemoryTag tag, size_t huge_page_threshold) noexcept
+    : m_tag(tag), m_huge_page_threshold(huge_page_threshold) {
 }
 
 GlobalMemoryAllocator::~GlobalMemoryAllocator() noexcept {
@@ -22,37 +30,164 @@ GlobalMemoryAllocator::~GlobalMemoryAllocator() noexcept {
 
 void *GlobalMemoryAllocator::do_allocate(size_t bytes, size_t alignment) {
 #ifdef MEMORY_RESOURCE_TRACKING
-    LOG_DEBUG("allocate {} Bytes with alignment {}", bytes, alignment);
+    RecordAllocation(m_tag, bytes);
 #endif
+    // the size decides the path so deallocation needs no bookkeeping
+    if (m_huge_page_threshold && bytes >= m_huge_page_threshold && alignment <= HUGE_PAGE_SIZE) {
+        void *ptr = AllocateHugePages(bytes);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
     return mi_malloc_aligned(bytes, alignment);
 }
 
 void GlobalMemoryAllocator::do_deallocate(void *ptr, size_t bytes, size_t alignment) {
 #ifdef MEMORY_RESOURCE_TRACKING
-    LOG_DEBUG("deallocate {} Bytes with alignment {}", bytes, alignment);
+    RecordDeallocation(m_tag, bytes);
 #endif
+    if (m_huge_page_threshold && bytes >= m_huge_page_threshold && alignment <= HUGE_PAGE_SIZE) {
+        FreeHugePages(ptr, bytes);
+        return;
+    }
     mi_free_aligned(ptr, alignment);
 }
 
+// instances differ in their tag, freeing through another one would attribute the bytes to the wrong tag
 bool GlobalMemoryAllocator::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
     return this == &other;
 }
 
-LocalMemoryAllocator::LocalMemoryAllocator() noexcept {
+namespace {
+
+// arenas holding blocks, never destroyed since threads may exit after static destruction
+struct LocalAllocatorRegistry {
+    std::mutex mutex;
+    std::vector<LocalMemoryAllocator *> allocators;
+};
+
+LocalAllocatorRegistry &GetLocalAllocatorRegistry() {
+    static auto *registry = new LocalAllocatorRegistry();
+    return *registry;
+}
+
+} // namespace
+
+LocalMemoryAllocator::LocalMemoryAllocator(size_t block_size, std::pmr::memory_resource *upstream) noexcept
+    : m_upstream(upstream), m_block_size(block_size) {
 }
 
 LocalMemoryAllocator::~LocalMemoryAllocator() noexcept {
+    if (!m_registered) {
+        return;
+    }
+    // under the lock so a concurrent ReleaseAll() can't free the blocks twice
+    LocalAllocatorRegistry &registry = GetLocalAllocatorRegistry();
+    std::lock_guard lock(registry.mutex);
+    registry.allocators.erase(std::remove(registry.allocators.begin(), registry.allocators.end(), this),
+                              registry.allocators.end());
+    Release();
 }
 
-void *LocalMemoryAllocator::do_allocate(size_t bytes, size_t alignment) { 
-    return nullptr; 
+void LocalMemoryAllocator::ReleaseAll() noexcept {
+    LocalAllocatorRegistry &registry = GetLocalAllocatorRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (LocalMemoryAllocator *allocator : registry.allocators) {
+        allocator->Release();
+    }
+}
+
+void LocalMemoryAllocator::Reset() noexcept {
+    m_current = m_first;
+    m_used_before_current = 0;
+    m_cursor = m_first ? reinterpret_cast<char *>(m_first + 1) : nullptr;
+    m_end = m_first ? reinterpret_cast<char *>(m_first) + m_first->size : nullptr;
+}
+
+void LocalMemoryAllocator::Release() noexcept {
+    for (Block *block = m_first; block;) {
+        Block *next = block->next;
+        block->upstream->deallocate(block, block->size, alignof(std::max_align_t));
+        block = next;
+    }
+    m_first = nullptr;
+    m_reserved_size = 0;
+    Reset();
+}
+
+void LocalMemoryAllocator::Rewind(const Marker &marker) noexcept {
+    if (!marker.block) {
+        Reset();
+        return;
+    }
+    // blocks after the marked one stay in the chain for reuse
+    m_current = static_cast<Block *>(marker.block);
+    m_cursor = marker.cursor;
+    m_end = reinterpret_cast<char *>(m_current) + m_current->size;
+    m_used_before_current = marker.used_before_current;
+}
+
+size_t LocalMemoryAllocator::GetUsedSize() const noexcept {
+    return m_current ? m_used_before_current + (m_cursor - reinterpret_cast<char *>(m_current + 1)) : 0;
+}
+
+void *LocalMemoryAllocator::do_allocate(size_t bytes, size_t alignment) {
+    // hot path, bump the cursor inside the current block
+    const uintptr_t cursor = reinterpret_cast<uintptr_t>(m_cursor);
+    const uintptr_t aligned = (cursor + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    if (m_cursor && aligned + bytes <= reinterpret_cast<uintptr_t>(m_end)) {
+        m_cursor = reinterpret_cast<char *>(aligned + bytes);
+        return reinterpret_cast<void *>(aligned);
+    }
+    return AllocateFromNextBlock(bytes, alignment);
+}
+
+void *LocalMemoryAllocator::AllocateFromNextBlock(size_t bytes, size_t alignment) {
+    const size_t required = sizeof(Block) + bytes + alignment;
+    if (m_current) {
+        m_used_before_current += m_cursor - reinterpret_cast<char *>(m_current + 1);
+    }
+
+    // reuse the blocks kept by Reset(), a new block is linked in after the current one
+    Block *next = m_current ? m_current->next : m_first;
+    if (!next || next->size < required) {
+        std::pmr::memory_resource *upstream = m_upstream ? m_upstream : GetGlobalAllocator(MemoryTag::SCRATCH);
+        if (!upstream) {
+            LOG_ERROR("thread arena used outside Memory::initialize() and Memory::destroy()");
+            throw std::bad_alloc();
+        }
+        if (!m_registered) {
+            LocalAllocatorRegistry &registry = GetLocalAllocatorRegistry();
+            std::lock_guard lock(registry.mutex);
+            registry.allocators.push_back(this);
+            m_registered = true;
+        }
+        const size_t size = required > m_block_size ? required : m_block_size;
+        auto *block = static_cast<Block *>(upstream->allocate(size, alignof(std::max_align_t)));
+        block->upstream = upstream;
+        block->size = size;
+        block->next = next;
+        if (m_current) {
+            m_current->next = block;
+        } else {
+            m_first = block;
+        }
+        m_reserved_size += size;
+        next = block;
+    }
+
+    m_current = next;
+    m_cursor = reinterpret_cast<char *>(next + 1);
+    m_end = reinterpret_cast<char *>(next) + next->size;
+    return do_allocate(bytes, alignment);
 }
 
 void LocalMemoryAllocator::do_deallocate(void *ptr, size_t bytes, size_t alignment) {
 }
 
-bool LocalMemoryAllocator::do_is_equal(const std::pmr::memory_resource &other) const noexcept { 
-    return false; 
+bool LocalMemoryAllocator::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
 }
 
 } // namespace Fract::Memory
\ No newline at end of file
@@ -8,41 +8,158 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <memory_resource>
 
-#ifndef NDEBUG
-//#define MEMORY_RESOURCE_TRACKING
-#endif
+#include "HugePages.h"
+#include "MemoryStats.h"
+
+// per tag counters (see MemoryStats.h), cheap enough to keep in release builds
+#define MEMORY_RESOURCE_TRACKING
 
 namespace Fract::Memory {
 
+// large long lived arrays (bvh nodes, vertex streams) go to huge pages to cut tlb misses
+static constexpr size_t HUGE_PAGE_ALLOCATION_THRESHOLD = 4 * HUGE_PAGE_SIZE;
+
+// mimalloc backed, one instance per tag so statistics are attributed to the subsystem that owns the memory.
+// allocations of at least huge_page_threshold bytes are mapped from huge pages instead, 0 disables that.
 class GlobalMemoryAllocator : public std::pmr::memory_resource {
   public:
-    GlobalMemoryAllocator() noexcept;
+    GlobalMemoryAllocator(MemoryTag tag = MemoryTag::GENERAL, size_t huge_page_threshold = 0) noexcept;
     ~GlobalMemoryAllocator() noexcept;
 
+    MemoryTag GetTag() const noexcept { return m_tag; }
+
   private:
     void *do_allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
 
     void do_deallocate(void *ptr, size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
 
     bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    MemoryTag m_tag{};
+    size_t m_huge_page_threshold{};
 };
 
-// TODO(hylu): our memory allocator need to support multithreading cases
+static constexpr size_t LOCAL_MEMORY_BLOCK_SIZE = 256 * 1024;
 
+// linear allocator over a chain of blocks from an upstream resource, deallocate does nothing and Reset() rewinds to
+// the first block keeping every block for reuse. not thread safe, each thread owns one (see GetLocalAllocator()).
+// a null upstream is the SCRATCH global allocator looked up per block, so arenas can be created before
+// Memory::initialize() and outlive Memory::destroy(), which releases them all.
 class LocalMemoryAllocator : public std::pmr::memory_resource {
   public:
-    LocalMemoryAllocator() noexcept;
+    LocalMemoryAllocator(size_t block_size = LOCAL_MEMORY_BLOCK_SIZE,
+                         std::pmr::memory_resource *upstream = nullptr) noexcept;
     ~LocalMemoryAllocator() noexcept;
 
+    LocalMemoryAllocator(const LocalMemoryAllocator &rhs) noexcept = delete;
+    LocalMemoryAllocator &operator=(const LocalMemoryAllocator &rhs) noexcept = delete;
+    LocalMemoryAllocator(LocalMemoryAllocator &&rhs) noexcept = delete;
+    LocalMemoryAllocator &operator=(LocalMemoryAllocator &&rhs) noexcept = delete;
+
+    // O(1), everything allocated so far becomes invalid
+    void Reset() noexcept;
+
+    // give all blocks back to the upstream resource
+    void Release() noexcept;
+
+    // Release() on every arena holding blocks, no other thread may use its arena meanwhile
+    static void ReleaseAll() noexcept;
+
+    struct Marker {
+        void *block;
+        char *cursor;
+        size_t used_before_current;
+    };
+
+    // Rewind() frees everything allocated after GetMarker(), scopes must rewind in lifo order
+    Marker GetMarker() const noexcept { return Marker{m_current, m_cursor, m_used_before_current}; }
+    void Rewind(const Marker &marker) noexcept;
+
+    size_t GetUsedSize() const noexcept;
+    size_t GetReservedSize() const noexcept { return m_reserved_size; }
+
   private:
+    struct Block {
+        Block *next;
+        std::pmr::memory_resource *upstream; // the block goes back where it came from
+        size_t size;                         // including this header
+    };
+
     void *do_allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
 
     void do_deallocate(void *ptr, size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
 
     bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    void *AllocateFromNextBlock(size_t bytes, size_t alignment);
+
+    std::pmr::memory_resource *m_upstream{};
+    size_t m_block_size{};
+    Block *m_first{};
+    Block *m_current{};
+    char *m_cursor{};
+    char *m_end{};
+    size_t m_used_before_current{}; // bytes handed out from the blocks before m_current
+    size_t m_reserved_size{};
+    bool m_registered{}; // listed for ReleaseAll()
+};
+
+// scratch arena of the calling thread, owners reset it per tile or per frame
+LocalMemoryAllocator &GetLocalAllocator();
+
+// bump allocator over an inline buffer for per call temporaries. when the buffer is full it spills into the thread
+// arena and rewinds it on destruction, so arena allocations made while it lives must not outlive it. lives on the
+// stack, never share it across threads.
+template <size_t Size> class StackMemoryResource : public std::pmr::memory_resource {
+  public:
+    StackMemoryResource() noexcept = default;
+    ~StackMemoryResource() noexcept {
+        if (m_spilled) {
+            GetLocalAllocator().Rewind(m_spill_marker);
+        }
+    }
+
+    StackMemoryResource(const StackMemoryResource &rhs) noexcept = delete;
+    StackMemoryResource &operator=(const StackMemoryResource &rhs) noexcept = delete;
+    StackMemoryResource(StackMemoryResource &&rhs) noexcept = delete;
+    StackMemoryResource &operator=(StackMemoryResource &&rhs) noexcept = delete;
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override {
+        // align the address, not the offset, the buffer itself is only max_align_t aligned
+        const uintptr_t cursor = reinterpret_cast<uintptr_t>(m_buffer) + m_offset;
+        const uintptr_t aligned = (cursor + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        const size_t offset = static_cast<size_t>(aligned - reinterpret_cast<uintptr_t>(m_buffer));
+        if (offset + bytes <= Size) {
+            m_offset = offset + bytes;
+            return m_buffer + offset;
+        }
+        LocalMemoryAllocator &arena = GetLocalAllocator();
+        if (!m_spilled) {
+            m_spill_marker = arena.GetMarker();
+            m_spilled = true;
+        }
+        return arena.allocate(bytes, alignment);
+    }
+
+    // the inline buffer is reclaimed when the resource goes out of scope, only the last allocation is rolled back
+    // so a growing vector can reuse its space
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment = alignof(std::max_align_t)) override {
+        if (static_cast<unsigned char *>(ptr) + bytes == m_buffer + m_offset) {
+            m_offset -= bytes;
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    alignas(std::max_align_t) unsigned char m_buffer[Size];
+    size_t m_offset{};
+    bool m_spilled{};
+    LocalMemoryAllocator::Marker m_spill_marker{};
 };
 
 } // namespace Fract::Memory
\ No newline at end of file
@@ -0,0 +1,125 @@
+/*****************************************************************//**
+ * \file   FrameAllocator.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "FrameAllocator.h"
+
+#include <cassert>
+
+#include "../log/log.h"
+
+namespace Fract::Memory {
+
+FrameAllocator::FrameAllocator(size_t capacity, std::pmr::memory_resource *upstream)
+    : m_upstream(upstream), m_capacity(capacity) {
+    assert(capacity > 0 && capacity % FRAME_ALLOCATOR_MAX_ALIGNMENT == 0);
+    m_buffer = static_cast<unsigned char *>(m_upstream->allocate(m_capacity, FRAME_ALLOCATOR_MAX_ALIGNMENT));
+    for (auto &frame : m_frames) {
+        frame.overflows = Container::Array<Overflow>(upstream);
+    }
+}
+
+FrameAllocator::~FrameAllocator() noexcept {
+    ReleaseFrames(~0ull);
+    // overflows allocated before the first BeginFrame()
+    for (auto &frame : m_frames) {
+        for (const Overflow &overflow : frame.overflows) {
+            m_upstream->deallocate(overflow.ptr, overflow.bytes, overflow.alignment);
+        }
+    }
+    m_upstream->deallocate(m_buffer, m_capacity, FRAME_ALLOCATOR_MAX_ALIGNMENT);
+}
+
+bool FrameAllocator::BeginFrame(uint64_t frame_index) {
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+    if (m_frame_count == MAX_FRAMES_IN_FLIGHT) {
+        LOG_ERROR("frame {} begins with {} frames in flight", frame_index, m_frame_count);
+        return false;
+    }
+    const uint64_t head = m_head.load(std::memory_order_acquire);
+    if (m_frame_count > 0) {
+        m_frames[(m_first_frame + m_frame_count - 1) % MAX_FRAMES_IN_FLIGHT].end = head;
+    } else {
+        // nothing in flight, the whole ring is free
+        m_tail.store(head, std::memory_order_release);
+    }
+    Frame &frame = m_frames[(m_first_frame + m_frame_count) % MAX_FRAMES_IN_FLIGHT];
+    frame.index = frame_index;
+    frame.end = head;
+    m_frame_count++;
+    return true;
+}
+
+void FrameAllocator::ReleaseFrames(uint64_t completed_frame_index) {
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+    // the frame being recorded is only released by the destructor
+    while (m_frame_count > 0) {
+        Frame &frame = m_frames[m_first_frame];
+        const bool recording = m_frame_count == 1 && completed_frame_index != ~0ull;
+        if (frame.index > completed_frame_index || recording) {
+            break;
+        }
+        for (const Overflow &overflow : frame.overflows) {
+            m_upstream->deallocate(overflow.ptr, overflow.bytes, overflow.alignment);
+        }
+        frame.overflows.clear();
+        m_tail.store(frame.end, std::memory_order_release);
+        m_first_frame = (m_first_frame + 1) % MAX_FRAMES_IN_FLIGHT;
+        m_frame_count--;
+    }
+}
+
+uint64_t FrameAllocator::GetFrameIndex() const noexcept {
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+    if (m_frame_count == 0) {
+        return 0;
+    }
+    return m_frames[(m_first_frame + m_frame_count - 1) % MAX_FRAMES_IN_FLIGHT].index;
+}
+
+size_t FrameAllocator::GetUsedSize() const noexcept {
+    return static_cast<size_t>(m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_relaxed));
+}
+
+void *FrameAllocator::do_allocate(size_t bytes, size_t alignment) {
+    if (alignment > FRAME_ALLOCATOR_MAX_ALIGNMENT || bytes > m_capacity) {
+        return AllocateOverflow(bytes, alignment);
+    }
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    while (true) {
+        const uint64_t offset = head % m_capacity;
+        uint64_t begin = head + ((alignment - offset % alignment) % alignment);
+        if (begin % m_capacity + bytes > m_capacity || begin % m_capacity < offset) {
+            // never straddle the end of the buffer, skip to the start
+            begin = head + (m_capacity - offset);
+        }
+        const uint64_t end = begin + bytes;
+        if (end - m_tail.load(std::memory_order_acquire) > m_capacity) {
+            return AllocateOverflow(bytes, alignment);
+        }
+        if (m_head.compare_exchange_weak(head, end, std::memory_order_relaxed)) {
+            return m_buffer + begin % m_capacity;
+        }
+    }
+}
+
+void *FrameAllocator::AllocateOverflow(size_t bytes, size_t alignment) {
+    void *ptr = m_upstream->allocate(bytes, alignment);
+    std::lock_guard<std::mutex> lock(m_frame_mutex);
+    const uint32_t current = (m_first_frame + m_frame_count + MAX_FRAMES_IN_FLIGHT - 1) % MAX_FRAMES_IN_FLIGHT;
+    m_frames[current].overflows.push_back(Overflow{ptr, bytes, alignment});
+    return ptr;
+}
+
+void FrameAllocator::do_deallocate(void *, size_t, size_t) {
+}
+
+bool FrameAllocator::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+} // namespace Fract::Memory
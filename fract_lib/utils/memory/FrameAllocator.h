@@ -0,0 +1,86 @@
+/*****************************************************************//**
+ * \file   FrameAllocator.h
+ * \brief  ring allocator for memory that lives until the gpu finished a frame
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <mutex>
+
+#include "../container/Container.h"
+
+namespace Fract::Memory {
+
+static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+static constexpr size_t FRAME_ALLOCATOR_CAPACITY = 8 * 1024 * 1024;
+static constexpr size_t FRAME_ALLOCATOR_MAX_ALIGNMENT = 256; // d3d12 constant buffer alignment
+
+// allocations belong to the frame being recorded and are reclaimed all at once when the fence of that frame
+// completed, deallocate does nothing. allocation is lock free and thread safe, frames are begun and released by
+// one thread while others may still allocate. when the ring is full allocations spill to the upstream resource until
+// their frame is released.
+// the capacity is a multiple of FRAME_ALLOCATOR_MAX_ALIGNMENT so ring offsets keep the alignment of positions.
+class FrameAllocator : public std::pmr::memory_resource {
+  public:
+    FrameAllocator(size_t capacity = FRAME_ALLOCATOR_CAPACITY,
+                   std::pmr::memory_resource *upstream = GetGlobalAllocator(MemoryTag::RHI));
+    ~FrameAllocator() noexcept;
+
+    FrameAllocator(const FrameAllocator &rhs) noexcept = delete;
+    FrameAllocator &operator=(const FrameAllocator &rhs) noexcept = delete;
+    FrameAllocator(FrameAllocator &&rhs) noexcept = delete;
+    FrameAllocator &operator=(FrameAllocator &&rhs) noexcept = delete;
+
+    // frame indices increase, at most MAX_FRAMES_IN_FLIGHT frames may be unreleased including the new one
+    bool BeginFrame(uint64_t frame_index);
+
+    // every frame up to completed_frame_index finished on the gpu
+    void ReleaseFrames(uint64_t completed_frame_index);
+
+    // frame currently being recorded, 0 before the first BeginFrame()
+    uint64_t GetFrameIndex() const noexcept;
+    size_t GetCapacity() const noexcept { return m_capacity; }
+    size_t GetUsedSize() const noexcept;
+
+  private:
+    struct Overflow {
+        void *ptr;
+        size_t bytes;
+        size_t alignment;
+    };
+
+    struct Frame {
+        uint64_t index{};
+        uint64_t end{}; // ring position after the last allocation of the frame, set by the next BeginFrame()
+        Container::Array<Overflow> overflows;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
+
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    void *AllocateOverflow(size_t bytes, size_t alignment);
+
+    std::pmr::memory_resource *m_upstream{};
+    unsigned char *m_buffer{};
+    size_t m_capacity{};
+
+    // positions grow forever, the buffer offset is position % capacity
+    std::atomic<uint64_t> m_head{0};
+    std::atomic<uint64_t> m_tail{0}; // start of the oldest unreleased frame
+
+    Container::FixedArray<Frame, MAX_FRAMES_IN_FLIGHT> m_frames{};
+    uint32_t m_first_frame{};
+    uint32_t m_frame_count{};
+    mutable std::mutex m_frame_mutex; // frames and their overflows, overflowing threads read them during BeginFrame()
+};
+
+} // namespace Fract::Memory
@@ -0,0 +1,98 @@
+/*****************************************************************//**
+ * \file   HugePages.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "HugePages.h"
+
+#include <atomic>
+#include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Fract::Memory {
+
+namespace {
+
+// explicit huge pages need a reserved pool (or a privilege on windows), stop asking once the os said no
+std::atomic<bool> explicit_huge_pages_available{true};
+
+size_t RoundUp(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+void *AllocateHugePages(size_t bytes) {
+    const size_t size = RoundUp(bytes);
+    if (explicit_huge_pages_available.load(std::memory_order_relaxed) && GetLargePageMinimum() != 0) {
+        // needs SeLockMemoryPrivilege
+        void *ptr = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        if (ptr) {
+            return ptr;
+        }
+        explicit_huge_pages_available.store(false, std::memory_order_relaxed);
+    }
+    return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+}
+
+void FreeHugePages(void *ptr, size_t bytes) {
+    if (ptr) {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+}
+
+#else
+
+void *AllocateHugePages(size_t bytes) {
+    const size_t size = RoundUp(bytes);
+#ifdef MAP_HUGETLB
+    if (explicit_huge_pages_available.load(std::memory_order_relaxed)) {
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED) {
+            return ptr;
+        }
+        explicit_huge_pages_available.store(false, std::memory_order_relaxed);
+    }
+#endif
+
+    // over-map so the range can be trimmed to a huge page boundary, the kernel only backs aligned 2MB ranges with
+    // transparent huge pages
+    const size_t mapped_size = size + HUGE_PAGE_SIZE;
+    void *mapping = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return nullptr;
+    }
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(mapping);
+    const uintptr_t aligned = (begin + HUGE_PAGE_SIZE - 1) & ~(static_cast<uintptr_t>(HUGE_PAGE_SIZE) - 1);
+    if (aligned > begin) {
+        munmap(mapping, aligned - begin);
+    }
+    const uintptr_t end = begin + mapped_size;
+    if (end > aligned + size) {
+        munmap(reinterpret_cast<void *>(aligned + size), end - (aligned + size));
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void *>(aligned), size, MADV_HUGEPAGE);
+#endif
+    return reinterpret_cast<void *>(aligned);
+}
+
+void FreeHugePages(void *ptr, size_t bytes) {
+    if (ptr) {
+        munmap(ptr, RoundUp(bytes));
+    }
+}
+
+#endif // _WIN32
+
+} // namespace Fract::Memory
@@ -0,0 +1,25 @@
+/*****************************************************************//**
+ * \file   HugePages.h
+ * \brief  page allocation backed by 2MB pages where the os allows it
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+namespace Fract::Memory {
+
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// maps whole huge pages, aligned to HUGE_PAGE_SIZE. tries explicit huge pages first (MAP_HUGETLB on linux,
+// MEM_LARGE_PAGES on windows), then transparent huge pages through madvise, then regular pages. returns nullptr only
+// if the os is out of memory.
+void *AllocateHugePages(size_t bytes);
+
+// bytes must be the size passed to AllocateHugePages()
+void FreeHugePages(void *ptr, size_t bytes);
+
+} // namespace Fract::Memory
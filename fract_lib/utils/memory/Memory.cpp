@@ -8,18 +8,43 @@
 
 #include "Memory.h"
 
+#include "../log/log.h"
+#include "Numa.h"
+
 namespace Fract::Memory {
 
 std::pmr::memory_resource *global_memory_resource;
 
-std::pmr::memory_resource *local_memory_resource;
+std::pmr::memory_resource *tagged_memory_resources[MEMORY_TAG_COUNT];
 
 void initialize() { 
-    global_memory_resource = new GlobalMemoryAllocator(); 
+    for (size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        const bool use_huge_pages = tag == static_cast<size_t>(MemoryTag::GEOMETRY) ||
+                                    tag == static_cast<size_t>(MemoryTag::ACCELERATION);
+        tagged_memory_resources[tag] = new GlobalMemoryAllocator(
+            static_cast<MemoryTag>(tag), use_huge_pages ? HUGE_PAGE_ALLOCATION_THRESHOLD : 0);
+    }
+    global_memory_resource = tagged_memory_resources[static_cast<size_t>(MemoryTag::GENERAL)];
+}
+
+void destroy(const std::filesystem::path &statistics_file) { 
+    // arenas of every thread would otherwise free into deleted resources at exit, the caller made sure they are idle
+    LocalMemoryAllocator::ReleaseAll();
+    if (!statistics_file.empty() && !DumpMemoryStatistics(statistics_file)) {
+        LOG_ERROR("failed to write memory statistics to {}", statistics_file.string());
+    }
+    for (auto &resource : tagged_memory_resources) {
+        delete resource;
+        resource = nullptr;
+    }
+    global_memory_resource = nullptr;
 }
 
-void destroy() { 
-    delete global_memory_resource; 
+LocalMemoryAllocator &GetLocalAllocator() {
+    // threads bound to a numa node get their blocks from that node
+    static thread_local LocalMemoryAllocator local_allocator(
+        LOCAL_MEMORY_BLOCK_SIZE, GetThreadNumaNode() >= 0 ? GetNumaAllocator(GetThreadNumaNode()) : nullptr);
+    return local_allocator;
 }
 
 } // namespace Fract::Memory
\ No newline at end of file
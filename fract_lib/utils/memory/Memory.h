@@ -11,21 +11,27 @@
 #include <memory>
 #include <memory_resource>
 #include <type_traits>
-#include <xtr1common>
 
 #include "Allocators.h"
 
 namespace Fract::Memory {
 
 extern std::pmr::memory_resource *global_memory_resource;
-// extern std::pmr::memory_resource *local_memory_resource;
+extern std::pmr::memory_resource *tagged_memory_resources[MEMORY_TAG_COUNT];
 
 void initialize();
 
-void destroy();
+// releases the arenas of every thread, other threads must be done allocating. writes the allocation statistics to
+// statistics_file if given.
+void destroy(const std::filesystem::path &statistics_file = {});
+
+// alignment used for objects of type T, over-aligned types (simd data, bvh nodes) keep their own alignment
+template <typename T> constexpr size_t GetAlignment() {
+    return alignof(T) > alignof(std::max_align_t) ? alignof(T) : alignof(std::max_align_t);
+}
 
 template <typename T, typename... Args> T *Alloc(std::pmr::memory_resource &allocator, Args &&...args) {
-    auto memory = allocator.allocate(sizeof(T), alignof(std::max_align_t));
+    auto memory = allocator.allocate(sizeof(T), GetAlignment<T>());
     return new (memory) T(std::forward<Args>(args)...);
 }
 
@@ -38,7 +44,7 @@ template <typename T> void Free(std::pmr::memory_resource &allocator, T *ptr) {
         return;
     }
     ptr->~T();
-    allocator.deallocate(ptr, sizeof(T), alignof(std::max_align_t));
+    allocator.deallocate(ptr, sizeof(T), GetAlignment<T>());
 }
 
 template <typename T> void Free(T *ptr) {
@@ -48,39 +54,89 @@ template <typename T> void Free(T *ptr) {
     Free(*Fract::Memory::global_memory_resource, ptr);
 }
 
+// value initialized array, alignment can be raised above alignof(T), e.g. 64 for avx friendly soa buffers. FreeArray
+// must get the same count and alignment.
+template <typename T>
+T *AllocArray(std::pmr::memory_resource &allocator, size_t count, size_t alignment = GetAlignment<T>()) {
+    if (count == 0) {
+        return nullptr;
+    }
+    alignment = alignment > GetAlignment<T>() ? alignment : GetAlignment<T>();
+    T *ptr = static_cast<T *>(allocator.allocate(sizeof(T) * count, alignment));
+    std::uninitialized_value_construct_n(ptr, count);
+    return ptr;
+}
+
+template <typename T> T *AllocArray(size_t count, size_t alignment = GetAlignment<T>()) {
+    return AllocArray<T>(*Fract::Memory::global_memory_resource, count, alignment);
+}
+
+template <typename T>
+void FreeArray(std::pmr::memory_resource &allocator, T *ptr, size_t count, size_t alignment = GetAlignment<T>()) {
+    if (!ptr) {
+        return;
+    }
+    alignment = alignment > GetAlignment<T>() ? alignment : GetAlignment<T>();
+    std::destroy_n(ptr, count);
+    allocator.deallocate(ptr, sizeof(T) * count, alignment);
+}
+
+template <typename T> void FreeArray(T *ptr, size_t count, size_t alignment = GetAlignment<T>()) {
+    FreeArray(*Fract::Memory::global_memory_resource, ptr, count, alignment);
+}
+
 inline std::pmr::memory_resource *GetGlobalAllocator() {
     return global_memory_resource; 
 };
 
-inline std::pmr::monotonic_buffer_resource GetStackMemoryResource(size_t size = 1024) {
-    return std::pmr::monotonic_buffer_resource(size);
+inline std::pmr::memory_resource *GetGlobalAllocator(MemoryTag tag) {
+    return tagged_memory_resources[static_cast<size_t>(tag)];
 }
 
 // smart_ptr with pmr
 
-template <typename T> using UniquePtr = std::unique_ptr<T>;
+// returns the object to the resource it was allocated from
+template <typename T> struct Deleter {
+    std::pmr::memory_resource *resource{};
+
+    void operator()(T *ptr) const { Free(*resource, ptr); }
+};
+
+template <typename T> struct Deleter<T[]> {
+    std::pmr::memory_resource *resource{};
+    size_t count{};
+    size_t alignment{};
+
+    void operator()(T *ptr) const { FreeArray(*resource, ptr, count, alignment); }
+};
+
+template <typename T> using UniquePtr = std::unique_ptr<T, Deleter<T>>;
 
 template <typename T, typename... Args, std::enable_if_t<!std::is_array_v<T>, int> = 0>
-_NODISCARD UniquePtr<T> MakeUnique(std::pmr::memory_resource &allocator, Args &&...args) { // make a unique_ptr
-    void *memory = allocator.allocate(sizeof(T), alignof(std::max_align_t));
-    T *object = new (memory) T(std::forward<Args>(args)...);
-    return UniquePtr<T>(object);
+[[nodiscard]] UniquePtr<T> MakeUnique(std::pmr::memory_resource &allocator, Args &&...args) { // make a unique_ptr
+    T *object = Alloc<T>(allocator, std::forward<Args>(args)...);
+    return UniquePtr<T>(object, Deleter<T>{&allocator});
 }
 
 template <typename T, typename... Args, std::enable_if_t<!std::is_array_v<T>, int> = 0>
-_NODISCARD UniquePtr<T> MakeUnique(Args &&...args) { // make a unique_ptr
+[[nodiscard]] UniquePtr<T> MakeUnique(Args &&...args) { // make a unique_ptr
     return Memory::MakeUnique<T, Args...>(*Fract::Memory::global_memory_resource, std::forward<Args>(args)...);
 }
 
-// we prefer using Container::Array than using unique_ptr<T[]>
-// TODO(hylu): https://stackoverflow.com/questions/16711697/is-there-any-use-for-unique-ptr-with-array
+// we prefer using Container::Array than using unique_ptr<T[]>, this is for fixed size over-aligned buffers
 
-// template <class T, std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0, int> = 0>
-//_NODISCARD UniquePtr<T> MakeUnique(std::pmr::memory_resource &allocator, const size_t _Size) { // make a unique_ptr
-//     using _Elem = std::remove_extent_t<T>;
-//     void *memory = allocator.allocate(sizeof(T) * _Size, alignof(std::max_align_t));
-//     return UniquePtr<T>(new (memory) _Elem[_Size]());
-// }
+template <typename T, std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0, int> = 0>
+[[nodiscard]] UniquePtr<T> MakeUnique(std::pmr::memory_resource &allocator, size_t count,
+                                   size_t alignment = GetAlignment<std::remove_extent_t<T>>()) {
+    using Element = std::remove_extent_t<T>;
+    Element *elements = AllocArray<Element>(allocator, count, alignment);
+    return UniquePtr<T>(elements, Deleter<T>{&allocator, count, alignment});
+}
+
+template <typename T, std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0, int> = 0>
+[[nodiscard]] UniquePtr<T> MakeUnique(size_t count, size_t alignment = GetAlignment<std::remove_extent_t<T>>()) {
+    return Memory::MakeUnique<T>(*Fract::Memory::global_memory_resource, count, alignment);
+}
 
 template <class T, class... Args, std::enable_if_t<std::extent_v<T> != 0, int> = 0>
 void MakeUnique(Args &&...) = delete;
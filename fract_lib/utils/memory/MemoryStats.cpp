@@ -0,0 +1,250 @@
+/*****************************************************************//**
+ * \file   MemoryStats.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "MemoryStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace Fract::Memory {
+
+namespace {
+
+// live bytes a thread accumulates before publishing them for the peak
+constexpr int64_t LIVE_BYTES_PUBLISH_THRESHOLD = 64 * 1024;
+
+// written by the owning thread only, atomics so queries from other threads can read them
+struct TagCounters {
+    std::atomic<uint64_t> allocated_bytes{};
+    std::atomic<uint64_t> deallocated_bytes{};
+    std::atomic<uint64_t> allocation_count{};
+    std::atomic<uint64_t> deallocation_count{};
+    std::array<std::atomic<uint64_t>, MEMORY_SIZE_CLASS_COUNT> size_classes{};
+    int64_t unpublished_bytes{};
+};
+
+struct ThreadCounters {
+    std::array<TagCounters, MEMORY_TAG_COUNT> tags;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<ThreadCounters *> threads;
+    MemoryStatistics retired{}; // counters of exited threads
+    std::array<std::atomic<int64_t>, MEMORY_TAG_COUNT> published_bytes{};
+    std::array<std::atomic<uint64_t>, MEMORY_TAG_COUNT> peak_bytes{};
+};
+
+// never destroyed, allocations may still happen during static destruction
+Registry &GetRegistry() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+
+void Increment(std::atomic<uint64_t> &counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+size_t GetSizeClass(size_t bytes) {
+    size_t size_class = 0;
+    for (size_t size = 16; size < bytes && size_class < MEMORY_SIZE_CLASS_COUNT - 1; size <<= 1) {
+        size_class++;
+    }
+    return size_class;
+}
+
+void Publish(Registry &registry, size_t tag, int64_t bytes) {
+    const int64_t live = registry.published_bytes[tag].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = registry.peak_bytes[tag].load(std::memory_order_relaxed);
+    while (live > 0 && static_cast<uint64_t>(live) > peak &&
+           !registry.peak_bytes[tag].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+void Merge(MemoryTagStatistics &dst, const TagCounters &src) {
+    const uint64_t allocated = src.allocated_bytes.load(std::memory_order_relaxed);
+    const uint64_t deallocated = src.deallocated_bytes.load(std::memory_order_relaxed);
+    dst.live_bytes += static_cast<int64_t>(allocated) - static_cast<int64_t>(deallocated);
+    dst.allocation_count += src.allocation_count.load(std::memory_order_relaxed);
+    dst.deallocation_count += src.deallocation_count.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < MEMORY_SIZE_CLASS_COUNT; i++) {
+        dst.size_classes[i] += src.size_classes[i].load(std::memory_order_relaxed);
+    }
+}
+
+enum class ThreadState { NONE, ALIVE, EXITED };
+
+thread_local ThreadState thread_state = ThreadState::NONE;
+thread_local ThreadCounters *thread_counters = nullptr;
+
+// merges the counters of the thread into the registry when it exits
+struct ThreadCountersOwner {
+    ~ThreadCountersOwner() {
+        Registry &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+            TagCounters &counters = thread_counters->tags[tag];
+            Merge(registry.retired.tags[tag], counters);
+            Publish(registry, tag, counters.unpublished_bytes);
+        }
+        registry.threads.erase(std::remove(registry.threads.begin(), registry.threads.end(), thread_counters),
+                               registry.threads.end());
+        delete thread_counters;
+        thread_counters = nullptr;
+        thread_state = ThreadState::EXITED;
+    }
+};
+
+ThreadCounters *GetThreadCounters() {
+    if (thread_state == ThreadState::ALIVE) {
+        return thread_counters;
+    }
+    if (thread_state == ThreadState::EXITED) {
+        return nullptr;
+    }
+    // called from noexcept allocation hooks, when the counters can't be set up the thread records into the retired
+    // counters and tries again on its next allocation
+    auto *counters = new (std::nothrow) ThreadCounters();
+    if (!counters) {
+        return nullptr;
+    }
+    {
+        Registry &registry = GetRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        try {
+            registry.threads.push_back(counters);
+        } catch (const std::bad_alloc &) {
+            delete counters;
+            return nullptr;
+        }
+    }
+    thread_counters = counters;
+    static thread_local ThreadCountersOwner owner;
+    thread_state = ThreadState::ALIVE;
+    return thread_counters;
+}
+
+// allocations from threads whose counters are already gone
+void RecordRetired(size_t tag, size_t bytes, bool allocation) {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    MemoryTagStatistics &statistics = registry.retired.tags[tag];
+    if (allocation) {
+        statistics.live_bytes += bytes;
+        statistics.allocation_count++;
+        statistics.size_classes[GetSizeClass(bytes)]++;
+    } else {
+        statistics.live_bytes -= bytes;
+        statistics.deallocation_count++;
+    }
+    Publish(registry, tag, allocation ? static_cast<int64_t>(bytes) : -static_cast<int64_t>(bytes));
+}
+
+} // namespace
+
+void RecordAllocation(MemoryTag tag, size_t bytes) noexcept {
+    const size_t index = static_cast<size_t>(tag);
+    ThreadCounters *counters = GetThreadCounters();
+    if (!counters) {
+        RecordRetired(index, bytes, true);
+        return;
+    }
+    TagCounters &tag_counters = counters->tags[index];
+    Increment(tag_counters.allocated_bytes, bytes);
+    Increment(tag_counters.allocation_count, 1);
+    Increment(tag_counters.size_classes[GetSizeClass(bytes)], 1);
+    tag_counters.unpublished_bytes += bytes;
+    if (tag_counters.unpublished_bytes >= LIVE_BYTES_PUBLISH_THRESHOLD) {
+        Publish(GetRegistry(), index, tag_counters.unpublished_bytes);
+        tag_counters.unpublished_bytes = 0;
+    }
+}
+
+void RecordDeallocation(MemoryTag tag, size_t bytes) noexcept {
+    const size_t index = static_cast<size_t>(tag);
+    ThreadCounters *counters = GetThreadCounters();
+    if (!counters) {
+        RecordRetired(index, bytes, false);
+        return;
+    }
+    TagCounters &tag_counters = counters->tags[index];
+    Increment(tag_counters.deallocated_bytes, bytes);
+    Increment(tag_counters.deallocation_count, 1);
+    tag_counters.unpublished_bytes -= bytes;
+    if (tag_counters.unpublished_bytes <= -LIVE_BYTES_PUBLISH_THRESHOLD) {
+        Publish(GetRegistry(), index, tag_counters.unpublished_bytes);
+        tag_counters.unpublished_bytes = 0;
+    }
+}
+
+MemoryStatistics GetMemoryStatistics() {
+    Registry &registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    MemoryStatistics statistics = registry.retired;
+    for (const ThreadCounters *counters : registry.threads) {
+        for (size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+            Merge(statistics.tags[tag], counters->tags[tag]);
+        }
+    }
+    for (size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        MemoryTagStatistics &tag_statistics = statistics.tags[tag];
+        const uint64_t peak = registry.peak_bytes[tag].load(std::memory_order_relaxed);
+        const uint64_t live = tag_statistics.live_bytes > 0 ? static_cast<uint64_t>(tag_statistics.live_bytes) : 0;
+        tag_statistics.peak_bytes = peak > live ? peak : live;
+    }
+    return statistics;
+}
+
+const char *GetMemoryTagName(MemoryTag tag) noexcept {
+    switch (tag) {
+    case MemoryTag::GENERAL:
+        return "general";
+    case MemoryTag::RHI:
+        return "rhi";
+    case MemoryTag::GEOMETRY:
+        return "geometry";
+    case MemoryTag::ACCELERATION:
+        return "acceleration";
+    case MemoryTag::TEXTURE:
+        return "texture";
+    case MemoryTag::SCRATCH:
+        return "scratch";
+    default:
+        return "unknown";
+    }
+}
+
+bool DumpMemoryStatistics(const std::filesystem::path &file_name) {
+    std::ofstream file(file_name);
+    if (!file) {
+        return false;
+    }
+    const MemoryStatistics statistics = GetMemoryStatistics();
+    file << "{\n";
+    for (size_t tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        const MemoryTagStatistics &tag_statistics = statistics.tags[tag];
+        file << "  \"" << GetMemoryTagName(static_cast<MemoryTag>(tag)) << "\": {\n";
+        file << "    \"live_bytes\": " << tag_statistics.live_bytes << ",\n";
+        file << "    \"peak_bytes\": " << tag_statistics.peak_bytes << ",\n";
+        file << "    \"allocation_count\": " << tag_statistics.allocation_count << ",\n";
+        file << "    \"deallocation_count\": " << tag_statistics.deallocation_count << ",\n";
+        file << "    \"size_classes\": [";
+        for (size_t i = 0; i < MEMORY_SIZE_CLASS_COUNT; i++) {
+            file << (i ? ", " : "") << tag_statistics.size_classes[i];
+        }
+        file << "]\n  }" << (tag + 1 < MEMORY_TAG_COUNT ? "," : "") << "\n";
+    }
+    file << "}\n";
+    return static_cast<bool>(file);
+}
+
+} // namespace Fract::Memory
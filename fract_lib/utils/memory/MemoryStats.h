@@ -0,0 +1,46 @@
+/*****************************************************************//**
+ * \file   MemoryStats.h
+ * \brief  per tag allocation statistics
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+
+namespace Fract::Memory {
+
+// subsystem an allocation is accounted to, every tag has its own global allocator (see GetGlobalAllocator())
+enum class MemoryTag : uint32_t { GENERAL, RHI, GEOMETRY, ACCELERATION, TEXTURE, SCRATCH, COUNT };
+
+static constexpr size_t MEMORY_TAG_COUNT = static_cast<size_t>(MemoryTag::COUNT);
+// power of two size classes from 16 bytes, the last one takes everything above 256KB
+static constexpr size_t MEMORY_SIZE_CLASS_COUNT = 16;
+
+struct MemoryTagStatistics {
+    int64_t live_bytes;
+    uint64_t peak_bytes; // approximate, threads publish their live bytes in batches
+    uint64_t allocation_count;
+    uint64_t deallocation_count;
+    std::array<uint64_t, MEMORY_SIZE_CLASS_COUNT> size_classes; // allocation count per size class
+};
+
+struct MemoryStatistics {
+    std::array<MemoryTagStatistics, MEMORY_TAG_COUNT> tags;
+};
+
+// cheap, counters are thread local and only merged when queried
+void RecordAllocation(MemoryTag tag, size_t bytes) noexcept;
+void RecordDeallocation(MemoryTag tag, size_t bytes) noexcept;
+
+MemoryStatistics GetMemoryStatistics();
+
+const char *GetMemoryTagName(MemoryTag tag) noexcept;
+
+bool DumpMemoryStatistics(const std::filesystem::path &file_name);
+
+} // namespace Fract::Memory
@@ -0,0 +1,186 @@
+/*****************************************************************//**
+ * \file   Numa.cpp
+ * \brief
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "Numa.h"
+
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Fract::Memory {
+
+namespace {
+
+thread_local int32_t thread_numa_node = -1;
+
+#ifndef _WIN32
+
+constexpr int MPOL_PREFERRED_MODE = 1; // MPOL_PREFERRED from <linux/mempolicy.h>
+
+// cpus of every node parsed from sysfs, empty without numa
+const std::vector<std::vector<int>> &GetNodeCpus() {
+    static const std::vector<std::vector<int>> node_cpus = [] {
+        std::vector<std::vector<int>> result;
+        for (uint32_t node = 0;; node++) {
+            std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+            if (!file) {
+                break;
+            }
+            // "0-15,32-47"
+            std::vector<int> cpus;
+            std::string range;
+            while (std::getline(file, range, ',')) {
+                const size_t dash = range.find('-');
+                const int first = std::stoi(range.substr(0, dash));
+                const int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+                for (int cpu = first; cpu <= last; cpu++) {
+                    cpus.push_back(cpu);
+                }
+            }
+            result.push_back(std::move(cpus));
+        }
+        return result;
+    }();
+    return node_cpus;
+}
+
+#endif // _WIN32
+
+} // namespace
+
+#ifdef _WIN32
+
+uint32_t GetNumaNodeCount() {
+    ULONG highest_node = 0;
+    if (!GetNumaHighestNodeNumber(&highest_node)) {
+        return 1;
+    }
+    return static_cast<uint32_t>(highest_node) + 1;
+}
+
+bool BindThreadToNumaNode(uint32_t node) {
+    GROUP_AFFINITY affinity{};
+    if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity) || affinity.Mask == 0) {
+        return false;
+    }
+    if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr)) {
+        return false;
+    }
+    thread_numa_node = static_cast<int32_t>(node);
+    return true;
+}
+
+void *AllocateOnNumaNode(size_t bytes, uint32_t node) {
+    return VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+}
+
+void FreeOnNumaNode(void *ptr, size_t bytes) {
+    if (ptr) {
+        VirtualFree(ptr, 0, MEM_RELEASE);
+    }
+}
+
+#else
+
+uint32_t GetNumaNodeCount() {
+    const size_t count = GetNodeCpus().size();
+    return count > 0 ? static_cast<uint32_t>(count) : 1;
+}
+
+bool BindThreadToNumaNode(uint32_t node) {
+    const auto &node_cpus = GetNodeCpus();
+    if (node >= node_cpus.size() || node_cpus[node].empty()) {
+        return false;
+    }
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : node_cpus[node]) {
+        CPU_SET(cpu, &cpu_set);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+        return false;
+    }
+    thread_numa_node = static_cast<int32_t>(node);
+    return true;
+}
+
+void *AllocateOnNumaNode(size_t bytes, uint32_t node) {
+    void *ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    // preferred instead of bind so a full node spills over instead of failing, pages are placed on first touch
+    if (node < 64 && GetNodeCpus().size() > 1) {
+        const unsigned long node_mask = 1ul << node;
+        syscall(SYS_mbind, ptr, bytes, MPOL_PREFERRED_MODE, &node_mask, 64, 0);
+    }
+    return ptr;
+}
+
+void FreeOnNumaNode(void *ptr, size_t bytes) {
+    if (ptr) {
+        munmap(ptr, bytes);
+    }
+}
+
+#endif // _WIN32
+
+int32_t GetThreadNumaNode() noexcept {
+    return thread_numa_node;
+}
+
+NumaMemoryResource::NumaMemoryResource(uint32_t node, MemoryTag tag) noexcept : m_node(node), m_tag(tag) {
+}
+
+NumaMemoryResource::~NumaMemoryResource() noexcept {
+}
+
+void *NumaMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+    void *ptr = AllocateOnNumaNode(bytes, m_node);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    RecordAllocation(m_tag, bytes);
+    return ptr;
+}
+
+void NumaMemoryResource::do_deallocate(void *ptr, size_t bytes, size_t alignment) {
+    RecordDeallocation(m_tag, bytes);
+    FreeOnNumaNode(ptr, bytes);
+}
+
+bool NumaMemoryResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    auto *numa = dynamic_cast<const NumaMemoryResource *>(&other);
+    return this == &other || (numa && numa->m_node == m_node);
+}
+
+std::pmr::memory_resource *GetNumaAllocator(uint32_t node) {
+    // never destroyed, thread local arenas may release into them at exit
+    static NumaMemoryResource **resources = [] {
+        const uint32_t node_count = GetNumaNodeCount();
+        auto **result = new NumaMemoryResource *[node_count];
+        for (uint32_t i = 0; i < node_count; i++) {
+            result[i] = new NumaMemoryResource(i);
+        }
+        return result;
+    }();
+    return node < GetNumaNodeCount() ? resources[node] : nullptr;
+}
+
+} // namespace Fract::Memory
@@ -0,0 +1,122 @@
+/*****************************************************************//**
+ * \file   Numa.h
+ * \brief  numa node discovery, thread binding and node local memory
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+
+#include "../container/Container.h"
+#include "MemoryStats.h"
+
+namespace Fract::Memory {
+
+// 1 on machines without numa support
+uint32_t GetNumaNodeCount();
+
+// node the calling thread was bound to with BindThreadToNumaNode(), -1 if it is not bound
+int32_t GetThreadNumaNode() noexcept;
+
+// restrict the calling thread to the cpus of a node. bind render workers before their first allocation so their
+// scratch arena (GetLocalAllocator()) is placed on the node as well.
+bool BindThreadToNumaNode(uint32_t node);
+
+// page granular, falls back to any node if the node is out of memory
+void *AllocateOnNumaNode(size_t bytes, uint32_t node);
+void FreeOnNumaNode(void *ptr, size_t bytes);
+
+// page granular resource on one node, meant as upstream for arenas and large buffers such as film tiles
+class NumaMemoryResource : public std::pmr::memory_resource {
+  public:
+    NumaMemoryResource(uint32_t node, MemoryTag tag = MemoryTag::SCRATCH) noexcept;
+    ~NumaMemoryResource() noexcept;
+
+    uint32_t GetNode() const noexcept { return m_node; }
+
+  private:
+    void *do_allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
+
+    void do_deallocate(void *ptr, size_t bytes, size_t alignment = alignof(std::max_align_t)) override;
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+
+    uint32_t m_node{};
+    MemoryTag m_tag{};
+};
+
+// shared resource of a node, valid until exit
+std::pmr::memory_resource *GetNumaAllocator(uint32_t node);
+
+// read only data copied to every node, threads bound to a node read their local copy
+template <typename T> class NumaReplicatedArray {
+  public:
+    NumaReplicatedArray() noexcept = default;
+    ~NumaReplicatedArray() noexcept { Clear(); }
+
+    NumaReplicatedArray(const NumaReplicatedArray &rhs) noexcept = delete;
+    NumaReplicatedArray &operator=(const NumaReplicatedArray &rhs) noexcept = delete;
+    NumaReplicatedArray(NumaReplicatedArray &&rhs) noexcept
+        : m_replicas(std::move(rhs.m_replicas)), m_count(rhs.m_count) {
+        rhs.m_replicas.clear();
+        rhs.m_count = 0;
+    }
+    NumaReplicatedArray &operator=(NumaReplicatedArray &&rhs) noexcept {
+        if (this != &rhs) {
+            Clear();
+            m_replicas = std::move(rhs.m_replicas);
+            m_count = rhs.m_count;
+            rhs.m_replicas.clear();
+            rhs.m_count = 0;
+        }
+        return *this;
+    }
+
+    // does nothing on a single node
+    void Replicate(const T *data, size_t count) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Clear();
+        const uint32_t node_count = GetNumaNodeCount();
+        if (node_count < 2 || count == 0) {
+            return;
+        }
+        m_count = count;
+        m_replicas.resize(node_count);
+        for (uint32_t node = 0; node < node_count; node++) {
+            // threads of a node without a copy read the shared data
+            m_replicas[node] = static_cast<T *>(AllocateOnNumaNode(sizeof(T) * count, node));
+            if (m_replicas[node]) {
+                std::memcpy(m_replicas[node], data, sizeof(T) * count);
+            }
+        }
+    }
+
+    void Clear() noexcept {
+        for (T *replica : m_replicas) {
+            FreeOnNumaNode(replica, sizeof(T) * m_count);
+        }
+        m_replicas.clear();
+        m_count = 0;
+    }
+
+    // the copy of the calling thread's node, shared otherwise
+    const T *Get(const T *shared) const noexcept {
+        if (m_replicas.empty()) {
+            return shared;
+        }
+        const int32_t node = GetThreadNumaNode();
+        const T *replica = node >= 0 && static_cast<size_t>(node) < m_replicas.size() ? m_replicas[node] : nullptr;
+        return replica ? replica : shared;
+    }
+
+  private:
+    Container::Array<T *> m_replicas;
+    size_t m_count{};
+};
+
+} // namespace Fract::Memory
@@ -0,0 +1,159 @@
+/*****************************************************************//**
+ * \file   ObjectPool.h
+ * \brief  fixed size object pool
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <memory_resource>
+#include <mutex>
+#include <utility>
+
+#include "Memory.h"
+
+namespace Fract::Memory {
+
+static constexpr size_t OBJECT_POOL_SLAB_SIZE = 64;         // objects per slab
+static constexpr size_t OBJECT_POOL_THREAD_CACHE_SIZE = 16; // slots per thread cache
+
+// slots of T carved out of slabs from an upstream resource and recycled through an intrusive free list, slabs are only
+// returned when the pool is destroyed. objects still alive at that point are not destructed.
+template <typename T, size_t SlabSize = OBJECT_POOL_SLAB_SIZE> class ObjectPool {
+  public:
+    ObjectPool(std::pmr::memory_resource *upstream = GetGlobalAllocator()) noexcept : m_upstream(upstream) {}
+
+    ~ObjectPool() noexcept {
+        while (m_slabs) {
+            Slab *next = m_slabs->next;
+            m_upstream->deallocate(m_slabs, sizeof(Slab), alignof(Slab));
+            m_slabs = next;
+        }
+    }
+
+    ObjectPool(const ObjectPool &rhs) noexcept = delete;
+    ObjectPool &operator=(const ObjectPool &rhs) noexcept = delete;
+    ObjectPool(ObjectPool &&rhs) noexcept = delete;
+    ObjectPool &operator=(ObjectPool &&rhs) noexcept = delete;
+
+    // thread safe
+    template <typename... Args> T *Acquire(Args &&...args) {
+        void *memory;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            memory = PopSlot();
+        }
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    // thread safe
+    void Release(T *object) {
+        if (!object) {
+            return;
+        }
+        object->~T();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        PushSlot(object);
+    }
+
+    size_t GetCapacity() const noexcept { return m_capacity; }
+
+    // a few free slots kept by one thread in front of the shared free list, it takes the pool lock only when empty or
+    // full. owned by a single thread and must not outlive the pool.
+    class ThreadCache {
+      public:
+        ThreadCache(ObjectPool &pool) noexcept : m_pool(pool) {}
+        ~ThreadCache() noexcept { Flush(); }
+
+        ThreadCache(const ThreadCache &rhs) noexcept = delete;
+        ThreadCache &operator=(const ThreadCache &rhs) noexcept = delete;
+        ThreadCache(ThreadCache &&rhs) noexcept = delete;
+        ThreadCache &operator=(ThreadCache &&rhs) noexcept = delete;
+
+        template <typename... Args> T *Acquire(Args &&...args) {
+            if (m_count == 0) {
+                // refill half so alternating acquire and release doesn't bounce on the lock
+                std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+                while (m_count < OBJECT_POOL_THREAD_CACHE_SIZE / 2) {
+                    m_slots[m_count++] = m_pool.PopSlot();
+                }
+            }
+            return new (m_slots[--m_count]) T(std::forward<Args>(args)...);
+        }
+
+        void Release(T *object) {
+            if (!object) {
+                return;
+            }
+            object->~T();
+            if (m_count == OBJECT_POOL_THREAD_CACHE_SIZE) {
+                std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+                while (m_count > OBJECT_POOL_THREAD_CACHE_SIZE / 2) {
+                    m_pool.PushSlot(m_slots[--m_count]);
+                }
+            }
+            m_slots[m_count++] = object;
+        }
+
+        // hand all cached slots back to the pool
+        void Flush() {
+            if (m_count == 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(m_pool.m_mutex);
+            while (m_count > 0) {
+                m_pool.PushSlot(m_slots[--m_count]);
+            }
+        }
+
+      private:
+        ObjectPool &m_pool;
+        void *m_slots[OBJECT_POOL_THREAD_CACHE_SIZE]{};
+        size_t m_count{};
+    };
+
+  private:
+    union Slot {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct Slab {
+        Slot slots[SlabSize];
+        Slab *next;
+    };
+
+    // under m_mutex
+    void *PopSlot() {
+        if (!m_free_list) {
+            auto *slab = static_cast<Slab *>(m_upstream->allocate(sizeof(Slab), alignof(Slab)));
+            slab->next = m_slabs;
+            m_slabs = slab;
+            for (size_t i = 0; i < SlabSize; i++) {
+                slab->slots[i].next = i + 1 < SlabSize ? &slab->slots[i + 1] : nullptr;
+            }
+            m_free_list = &slab->slots[0];
+            m_capacity += SlabSize;
+        }
+        Slot *slot = m_free_list;
+        m_free_list = slot->next;
+        return slot;
+    }
+
+    // under m_mutex
+    void PushSlot(void *memory) {
+        Slot *slot = static_cast<Slot *>(memory);
+        slot->next = m_free_list;
+        m_free_list = slot;
+    }
+
+    std::pmr::memory_resource *m_upstream{};
+    std::mutex m_mutex;
+    Slot *m_free_list{};
+    Slab *m_slabs{};
+    size_t m_capacity{};
+};
+
+} // namespace Fract::Memory
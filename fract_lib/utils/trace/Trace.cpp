@@ -0,0 +1,250 @@
+/*****************************************************************//**
+ * \file   Trace.cpp
+ * \brief  per thread record chunks and the trace file writer
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include "Trace.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "../log/log.h"
+
+namespace Fract::Trace {
+
+namespace {
+
+// 128KB of records, threads only take the registry lock when one is full
+constexpr uint32_t TRACE_CHUNK_RECORDS = 4096;
+
+struct Chunk {
+    uint32_t thread_index{};
+    uint32_t record_count{};
+    TraceRecord records[TRACE_CHUNK_RECORDS];
+};
+
+// written by its thread only, the capture reads records below the published count
+struct ThreadBuffer {
+    uint32_t thread_index{};
+    uint64_t generation{};
+    std::unique_ptr<Chunk> chunk;
+    std::atomic<uint32_t> record_count{TRACE_CHUNK_RECORDS};
+    std::atomic<uint64_t> dropped_records{};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> threads; // kept after the thread exits
+    std::vector<std::unique_ptr<Chunk>> full_chunks;
+    std::atomic<uint64_t> generation{}; // bumped by every capture, threads recycle chunks of older ones
+    uint64_t chunk_budget{};
+    uint64_t chunk_count{};
+    uint64_t start_ticks{};
+    std::chrono::steady_clock::time_point start_time;
+};
+
+// never destroyed, threads may still record during static destruction
+Registry &GetRegistry() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+
+ThreadBuffer &GetThreadBuffer() {
+    thread_local ThreadBuffer *buffer = [] {
+        Registry &registry = GetRegistry();
+        std::lock_guard lock(registry.mutex);
+        auto &thread = registry.threads.emplace_back(std::make_unique<ThreadBuffer>());
+        thread->thread_index = static_cast<uint32_t>(registry.threads.size() - 1);
+        return thread.get();
+    }();
+    return *buffer;
+}
+
+// hands a full chunk to the capture and takes an empty one, false once the budget is spent
+bool Refill(ThreadBuffer &buffer) {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    const uint64_t generation = registry.generation.load(std::memory_order_relaxed);
+    if (buffer.generation != generation) {
+        // first event of a new capture, a chunk left from an earlier one is reused
+        buffer.generation = generation;
+        buffer.dropped_records.store(0, std::memory_order_relaxed);
+    } else if (buffer.chunk) {
+        buffer.chunk->record_count = buffer.record_count.load(std::memory_order_relaxed);
+        registry.full_chunks.push_back(std::move(buffer.chunk));
+    }
+    if (!buffer.chunk && registry.chunk_count < registry.chunk_budget) {
+        buffer.chunk.reset(new Chunk); // records are left uninitialized
+        registry.chunk_count++;
+    }
+    if (!buffer.chunk) {
+        return false;
+    }
+    buffer.chunk->thread_index = buffer.thread_index;
+    buffer.record_count.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T> void WriteValue(std::ofstream &file, const T &value) {
+    file.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+} // namespace
+
+namespace Detail {
+
+void Write(const TraceSite &site, Phase phase, const uint32_t (&payload)[TRACE_PAYLOAD_COUNT]) noexcept {
+    ThreadBuffer &buffer = GetThreadBuffer();
+    uint32_t record_count = buffer.record_count.load(std::memory_order_relaxed);
+    if (record_count == TRACE_CHUNK_RECORDS ||
+        buffer.generation != GetRegistry().generation.load(std::memory_order_relaxed)) {
+        const bool out_of_budget =
+            !buffer.chunk && buffer.generation == GetRegistry().generation.load(std::memory_order_relaxed);
+        if (out_of_budget || !Refill(buffer)) {
+            buffer.dropped_records.store(buffer.dropped_records.load(std::memory_order_relaxed) + 1,
+                                         std::memory_order_relaxed);
+            return;
+        }
+        record_count = 0;
+    }
+    TraceRecord &record = buffer.chunk->records[record_count];
+    record.timestamp = ReadTimestamp();
+    record.site = reinterpret_cast<uint64_t>(&site);
+    record.phase = phase;
+    std::memcpy(record.payload, payload, sizeof(record.payload));
+    buffer.record_count.store(record_count + 1, std::memory_order_release);
+}
+
+} // namespace Detail
+
+bool StartCapture(uint64_t budget_bytes) {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    if (Detail::g_capturing.load(std::memory_order_relaxed)) {
+        LOG_ERROR("a trace capture is already running");
+        return false;
+    }
+    registry.chunk_count -= registry.full_chunks.size();
+    registry.full_chunks.clear();
+    registry.generation.fetch_add(1, std::memory_order_relaxed);
+    registry.chunk_budget = budget_bytes / sizeof(Chunk);
+    registry.start_time = std::chrono::steady_clock::now();
+    registry.start_ticks = Detail::ReadTimestamp();
+    Detail::g_capturing.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+bool StopCapture(const std::filesystem::path &file_name) {
+    Registry &registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+    if (!Detail::g_capturing.exchange(false, std::memory_order_relaxed)) {
+        LOG_ERROR("no trace capture is running");
+        return false;
+    }
+    const uint64_t stop_ticks = Detail::ReadTimestamp();
+    const auto elapsed = std::chrono::steady_clock::now() - registry.start_time;
+
+    // the partially filled chunk of every thread, threads still inside Write() only append past the snapshot
+    std::vector<std::pair<const Chunk *, uint32_t>> chunks;
+    for (const auto &chunk : registry.full_chunks) {
+        chunks.emplace_back(chunk.get(), chunk->record_count);
+    }
+    uint64_t dropped_records = 0;
+    for (const auto &thread : registry.threads) {
+        if (thread->generation != registry.generation.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        dropped_records += thread->dropped_records.load(std::memory_order_relaxed);
+        const uint32_t record_count = thread->record_count.load(std::memory_order_acquire);
+        if (thread->chunk && record_count > 0) {
+            chunks.emplace_back(thread->chunk.get(), record_count);
+        }
+    }
+
+    std::unordered_set<const TraceSite *> sites;
+    for (const auto &[chunk, record_count] : chunks) {
+        for (uint32_t i = 0; i < record_count; i++) {
+            sites.insert(reinterpret_cast<const TraceSite *>(chunk->records[i].site));
+        }
+    }
+
+    std::ofstream file(file_name, std::ios::binary);
+    if (!file) {
+        LOG_ERROR("failed to open trace file {}", file_name.string());
+        return false;
+    }
+
+    TraceFileHeader header{};
+    std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    header.ticks_per_second =
+        nanoseconds > 0 ? static_cast<uint64_t>(static_cast<double>(stop_ticks - registry.start_ticks) * 1e9 /
+                                                static_cast<double>(nanoseconds))
+                        : 1000000000ull;
+    header.start_ticks = registry.start_ticks;
+    header.dropped_records = dropped_records;
+    header.site_count = static_cast<uint32_t>(sites.size());
+    header.chunk_count = static_cast<uint32_t>(chunks.size());
+    WriteValue(file, header);
+
+    for (const TraceSite *site : sites) {
+        const std::string_view name = site->name, source = site->file;
+        TraceSiteEntry entry{};
+        entry.site = reinterpret_cast<uint64_t>(site);
+        entry.line = site->line;
+        entry.name_length = static_cast<uint16_t>(name.size());
+        entry.file_length = static_cast<uint16_t>(source.size());
+        entry.category = site->category;
+        entry.payload_count = site->payload_count;
+        WriteValue(file, entry);
+        file.write(name.data(), entry.name_length);
+        file.write(source.data(), entry.file_length);
+    }
+
+    for (const auto &[chunk, record_count] : chunks) {
+        WriteValue(file, TraceChunkHeader{chunk->thread_index, record_count});
+        file.write(reinterpret_cast<const char *>(chunk->records), sizeof(TraceRecord) * record_count);
+    }
+
+    if (!file) {
+        LOG_ERROR("failed to write trace file {}", file_name.string());
+        return false;
+    }
+    if (dropped_records > 0) {
+        LOG_WARN("trace capture ran out of budget, {} records were dropped", dropped_records);
+    }
+    return true;
+}
+
+CaptureScope::CaptureScope(const std::filesystem::path &file_name, uint64_t budget_bytes) : m_file_name(file_name) {
+    if (m_file_name.empty()) {
+        if (const char *environment = std::getenv(TRACE_FILE_ENVIRONMENT_VARIABLE)) {
+            m_file_name = environment;
+        }
+    }
+    if (!m_file_name.empty()) {
+        m_capturing = StartCapture(budget_bytes);
+        if (m_capturing) {
+            LOG_INFO("tracing to {}", m_file_name.string());
+        }
+    }
+}
+
+CaptureScope::~CaptureScope() noexcept {
+    if (m_capturing) {
+        StopCapture(m_file_name);
+    }
+}
+
+} // namespace Fract::Trace
@@ -0,0 +1,131 @@
+/*****************************************************************//**
+ * \file   Trace.h
+ * \brief  binary event tracing into per thread buffers
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <type_traits>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FRACT_TRACE_USE_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define FRACT_TRACE_USE_RDTSC
+#endif
+
+#include "TraceFormat.h"
+
+// bit mask of the categories compiled in, events of the other categories expand to nothing and their payload is never
+// evaluated. enabled categories cost one relaxed load while no capture is running.
+#ifndef FRACT_TRACE_CATEGORIES
+#define FRACT_TRACE_CATEGORIES 0xffffffffu
+#endif
+
+namespace Fract::Trace {
+
+// default memory a capture may use for records, later records are dropped and counted
+static constexpr uint64_t TRACE_DEFAULT_BUDGET = 256ull << 20;
+
+constexpr bool IsCategoryEnabled(Category category) noexcept {
+    return ((FRACT_TRACE_CATEGORIES) >> static_cast<uint32_t>(category)) & 1u;
+}
+
+// one per FRACT_TRACE_* call, records point to it and the file maps it back to name and location
+struct TraceSite {
+    Category category;
+    uint8_t payload_count;
+    uint32_t line;
+    const char *name;
+    const char *file;
+};
+
+// starts recording events of every thread, false if a capture is already running
+bool StartCapture(uint64_t budget_bytes = TRACE_DEFAULT_BUDGET);
+
+// stops recording and writes the events for fract_trace_decoder
+bool StopCapture(const std::filesystem::path &file_name);
+
+// names the capture file when a host has no --trace argument
+static constexpr const char *TRACE_FILE_ENVIRONMENT_VARIABLE = "FRACT_TRACE";
+
+// captures for its lifetime and writes file_name on destruction. an empty file_name falls back to FRACT_TRACE, the
+// scope does nothing when neither is set.
+class CaptureScope {
+  public:
+    CaptureScope(const std::filesystem::path &file_name = {}, uint64_t budget_bytes = TRACE_DEFAULT_BUDGET);
+    ~CaptureScope() noexcept;
+
+    CaptureScope(const CaptureScope &rhs) noexcept = delete;
+    CaptureScope &operator=(const CaptureScope &rhs) noexcept = delete;
+    CaptureScope(CaptureScope &&rhs) noexcept = delete;
+    CaptureScope &operator=(CaptureScope &&rhs) noexcept = delete;
+
+    bool IsCapturing() const noexcept { return m_capturing; }
+
+  private:
+    std::filesystem::path m_file_name;
+    bool m_capturing{};
+};
+
+namespace Detail {
+
+inline std::atomic<bool> g_capturing{false};
+
+// rdtsc where available, steady clock nanoseconds otherwise. the file stores the measured rate either way.
+inline uint64_t ReadTimestamp() noexcept {
+#if defined(FRACT_TRACE_USE_RDTSC)
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+}
+
+void Write(const TraceSite &site, Phase phase, const uint32_t (&payload)[TRACE_PAYLOAD_COUNT]) noexcept;
+
+// only used in decltype to count the payload of a call site
+template <typename... Args> std::integral_constant<uint8_t, sizeof...(Args)> CountPayload(const Args &...) noexcept;
+
+struct Recorder {
+    const TraceSite &site;
+    Phase phase;
+
+    // integers and enums, truncated to 32 bits
+    template <typename... Args> void operator()(const Args &...args) const noexcept {
+        static_assert(sizeof...(Args) <= TRACE_PAYLOAD_COUNT, "too many trace payload values");
+        static_assert((... && (std::is_integral_v<Args> || std::is_enum_v<Args>)), "trace payload must be integers");
+        if (g_capturing.load(std::memory_order_relaxed)) {
+            const uint32_t payload[TRACE_PAYLOAD_COUNT]{static_cast<uint32_t>(args)...};
+            Write(site, phase, payload);
+        }
+    }
+};
+
+} // namespace Detail
+
+} // namespace Fract::Trace
+
+#define FRACT_TRACE_RECORD(phase, category, name, ...)                                                                 \
+    do {                                                                                                               \
+        if constexpr (::Fract::Trace::IsCategoryEnabled(::Fract::Trace::Category::category)) {                         \
+            static constexpr ::Fract::Trace::TraceSite fract_trace_site{                                               \
+                ::Fract::Trace::Category::category,                                                                    \
+                decltype(::Fract::Trace::Detail::CountPayload(__VA_ARGS__))::value, __LINE__, name, __FILE__};         \
+            ::Fract::Trace::Detail::Recorder{fract_trace_site, ::Fract::Trace::Phase::phase}(__VA_ARGS__);             \
+        }                                                                                                              \
+    } while (false)
+
+// FRACT_TRACE_EVENT(TEXTURE, "evict", texture, mip), the name must be a literal, up to 3 integer payload values
+#define FRACT_TRACE_EVENT(category, name, ...) FRACT_TRACE_RECORD(INSTANT, category, name, __VA_ARGS__)
+
+// a span on the calling thread's timeline, every begin needs an end in the same category on the same thread
+#define FRACT_TRACE_BEGIN(category, name, ...) FRACT_TRACE_RECORD(BEGIN, category, name, __VA_ARGS__)
+#define FRACT_TRACE_END(category, name) FRACT_TRACE_RECORD(END, category, name, )
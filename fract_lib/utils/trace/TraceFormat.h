@@ -0,0 +1,70 @@
+/*****************************************************************//**
+ * \file   TraceFormat.h
+ * \brief  binary layout of trace files, shared with the decoder
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+namespace Fract::Trace {
+
+// one bit of FRACT_TRACE_CATEGORIES each, keep CATEGORY_NAMES in sync
+enum class Category : uint8_t { FRAME, SUBMIT, TEXTURE, RENDER, COUNT };
+
+static constexpr const char *CATEGORY_NAMES[] = {"frame", "submit", "texture", "render"};
+static_assert(sizeof(CATEGORY_NAMES) / sizeof(CATEGORY_NAMES[0]) == static_cast<uint32_t>(Category::COUNT));
+
+// begin and end records nest per thread like a call stack
+enum class Phase : uint8_t { INSTANT, BEGIN, END };
+
+static constexpr uint32_t TRACE_PAYLOAD_COUNT = 3;
+
+struct TraceRecord {
+    uint64_t timestamp; // ticks, see TraceFileHeader::ticks_per_second
+    uint64_t site;      // key into the site table
+    Phase phase;
+    uint8_t reserved[3];
+    uint32_t payload[TRACE_PAYLOAD_COUNT];
+};
+static_assert(sizeof(TraceRecord) == 32);
+
+// file layout, little endian:
+// TraceFileHeader
+// site_count x (TraceSiteEntry, name_length name bytes, file_length file bytes)
+// chunk_count x (TraceChunkHeader, record_count x TraceRecord)
+static constexpr char TRACE_MAGIC[8] = {'F', 'R', 'A', 'C', 'T', 'T', 'R', 'C'};
+static constexpr uint32_t TRACE_VERSION = 1;
+
+struct TraceFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t ticks_per_second;
+    uint64_t start_ticks;
+    uint64_t dropped_records; // lost because the capture ran out of budget
+    uint32_t site_count;
+    uint32_t chunk_count;
+};
+static_assert(sizeof(TraceFileHeader) == 48);
+
+struct TraceSiteEntry {
+    uint64_t site;
+    uint32_t line;
+    uint16_t name_length;
+    uint16_t file_length;
+    Category category;
+    uint8_t payload_count;
+    uint8_t reserved[6];
+};
+static_assert(sizeof(TraceSiteEntry) == 24);
+
+struct TraceChunkHeader {
+    uint32_t thread_index; // order in which threads recorded their first event
+    uint32_t record_count;
+};
+
+} // namespace Fract::Trace
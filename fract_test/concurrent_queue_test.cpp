@@ -0,0 +1,139 @@
+/*****************************************************************//**
+ * \file   concurrent_queue_test.cpp
+ * \brief  stress tests of MpmcQueue and SpscQueue, every pushed item must be popped exactly once
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include <utils/container/ConcurrentQueue.h>
+
+namespace {
+
+constexpr uint32_t ITEMS_PER_PRODUCER = 1 << 18;
+
+// small so producers and consumers keep running into a full and an empty queue
+constexpr size_t QUEUE_CAPACITY = 64;
+
+// producer index in the high bits, sequence in the low bits
+uint64_t MakeItem(uint32_t producer, uint32_t sequence) {
+    return static_cast<uint64_t>(producer) << 32 | sequence;
+}
+
+bool TestMpmc(uint32_t producer_count, uint32_t consumer_count) {
+    Fract::Container::MpmcQueue<uint64_t> queue(QUEUE_CAPACITY);
+    const uint64_t total = static_cast<uint64_t>(producer_count) * ITEMS_PER_PRODUCER;
+
+    // one counter per item, written by whichever consumer popped it
+    std::vector<std::atomic<uint32_t>> seen(total);
+    std::atomic<uint64_t> popped{0};
+    std::atomic<bool> ordered{true};
+
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producer_count; p++) {
+        threads.emplace_back([&queue, p] {
+            for (uint32_t i = 0; i < ITEMS_PER_PRODUCER; i++) {
+                while (!queue.try_push(MakeItem(p, i))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (uint32_t c = 0; c < consumer_count; c++) {
+        threads.emplace_back([&, producer_count] {
+            // items of one producer leave the queue in push order, so each consumer sees them increasing
+            std::vector<int64_t> last(producer_count, -1);
+            uint64_t item;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (!queue.try_pop(item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const uint32_t producer = static_cast<uint32_t>(item >> 32);
+                const uint32_t sequence = static_cast<uint32_t>(item);
+                if (static_cast<int64_t>(sequence) <= last[producer]) {
+                    ordered.store(false, std::memory_order_relaxed);
+                }
+                last[producer] = sequence;
+                seen[static_cast<uint64_t>(producer) * ITEMS_PER_PRODUCER + sequence].fetch_add(
+                    1, std::memory_order_relaxed);
+                popped.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    uint64_t missing = 0, duplicated = 0;
+    for (const std::atomic<uint32_t> &count : seen) {
+        const uint32_t value = count.load(std::memory_order_relaxed);
+        missing += value == 0;
+        duplicated += value > 1;
+    }
+    const bool passed = missing == 0 && duplicated == 0 && ordered.load() && queue.empty();
+    std::printf("mpmc %u producers %u consumers: %llu missing, %llu duplicated, %s order %s\n", producer_count,
+                consumer_count, static_cast<unsigned long long>(missing), static_cast<unsigned long long>(duplicated),
+                ordered.load() ? "kept" : "broken", passed ? "passed" : "FAILED");
+    return passed;
+}
+
+bool TestSpsc() {
+    Fract::Container::SpscQueue<uint64_t> queue(QUEUE_CAPACITY);
+    const uint64_t total = ITEMS_PER_PRODUCER * 4ull;
+
+    std::thread producer([&queue, total] {
+        for (uint64_t i = 0; i < total; i++) {
+            while (!queue.try_push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // a single consumer must see exactly 0, 1, 2, ...
+    uint64_t expected = 0;
+    bool passed = true;
+    uint64_t item;
+    while (expected < total) {
+        if (!queue.try_pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (item != expected) {
+            passed = false;
+            break;
+        }
+        expected++;
+    }
+    if (!passed) {
+        // drain so the producer can finish
+        while (expected < total) {
+            expected += queue.try_pop(item);
+        }
+    }
+    producer.join();
+
+    std::printf("spsc: %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
+
+} // namespace
+
+int main() {
+    const uint32_t hardware_threads = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() : 2;
+    const uint32_t half = hardware_threads / 2 > 1 ? hardware_threads / 2 : 2;
+
+    bool passed = true;
+    passed &= TestMpmc(1, 1);
+    passed &= TestMpmc(4, 1);
+    passed &= TestMpmc(1, 4);
+    passed &= TestMpmc(half, half);
+    passed &= TestSpsc();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*****************************************************************//**
+ * \file   packing_test.cpp
+ * \brief  batch half and normalized integer conversions must match the scalar ones bit for bit
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include <utils/math/Packing.h>
+
+namespace {
+
+using Fract::f32;
+using Fract::i16;
+using Fract::u16;
+using Fract::u32;
+using Fract::u8;
+
+constexpr u32 RANDOM_COUNT = 1 << 22;
+constexpr u32 STRIDE = 4099; // odd, walks every exponent of the f32 bit patterns
+constexpr size_t MAX_TAIL = 17; // covers every wide loop and the scalar tail after it
+
+f32 FromBits(u32 bits) {
+    f32 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// every half widened, a stride over all f32 bit patterns, random patterns and the edges of the quantizers
+std::vector<f32> MakeFloats() {
+    std::vector<f32> values;
+    for (u32 half = 0; half <= 0xffffu; half++) {
+        values.push_back(Fract::Math::HalfToFloat(static_cast<u16>(half)));
+    }
+    for (uint64_t bits = 0; bits <= 0xffffffffu; bits += STRIDE) {
+        values.push_back(FromBits(static_cast<u32>(bits)));
+    }
+    u32 random = 0x9e3779b9u;
+    for (u32 i = 0; i < RANDOM_COUNT; i++) {
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        values.push_back(FromBits(random));
+    }
+    const f32 edges[] = {
+        0.0f, -0.0f, 1.0f, -1.0f, 0.5f, -0.5f, 0.49999997f, -0.49999997f,
+        0.5f / 255.0f, 0.5f / 65535.0f, 0.5f / 32767.0f, -0.5f / 32767.0f, 65504.0f, 65519.996f, 65520.0f,
+        std::numeric_limits<f32>::denorm_min(), std::numeric_limits<f32>::min(), std::numeric_limits<f32>::max(),
+        std::numeric_limits<f32>::infinity(), -std::numeric_limits<f32>::infinity(), FromBits(0x7fc00000u),
+        FromBits(0xffc00000u), FromBits(0x7f800001u), FromBits(0x7fbfffffu), FromBits(0xffffffffu)};
+    values.insert(values.end(), std::begin(edges), std::end(edges));
+    return values;
+}
+
+// runs batch on the whole input and on every short prefix, each output must equal scalar of its input
+template <typename In, typename Out, typename Batch, typename Scalar>
+bool Compare(const char *name, const std::vector<In> &input, Batch batch, Scalar scalar) {
+    std::vector<Out> output(input.size());
+    bool passed = true;
+    for (size_t count = 0; count <= MAX_TAIL + 1 && passed; count++) {
+        const size_t n = count <= MAX_TAIL ? count : input.size();
+        batch(input.data(), output.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            const Out expected = scalar(input[i]);
+            if (std::memcmp(&output[i], &expected, sizeof(Out)) != 0) {
+                u32 bits = 0;
+                std::memcpy(&bits, &input[i], sizeof(In));
+                std::printf("%s: input 0x%08x at %zu of %zu differs from the scalar conversion\n", name, bits, i, n);
+                passed = false;
+                break;
+            }
+        }
+    }
+    std::printf("%s: %zu inputs, %s\n", name, input.size(), passed ? "passed" : "FAILED");
+    return passed;
+}
+
+} // namespace
+
+int main() {
+    namespace Math = Fract::Math;
+
+    std::vector<u16> halves(0x10000);
+    for (u32 i = 0; i < halves.size(); i++) {
+        halves[i] = static_cast<u16>(i);
+    }
+    const std::vector<f32> floats = MakeFloats();
+
+    bool passed = true;
+    passed &= Compare<u16, f32>(
+        "HalfToFloat", halves, [](const u16 *src, f32 *dst, size_t count) { Math::HalfToFloat(src, dst, count); },
+        [](u16 value) { return Math::HalfToFloat(value); });
+    passed &= Compare<f32, u16>(
+        "FloatToHalf", floats, [](const f32 *src, u16 *dst, size_t count) { Math::FloatToHalf(src, dst, count); },
+        [](f32 value) { return Math::FloatToHalf(value); });
+    passed &= Compare<f32, u8>(
+        "QuantizeUnorm8", floats,
+        [](const f32 *src, u8 *dst, size_t count) { Math::QuantizeUnorm8(src, dst, count); },
+        [](f32 value) { return Math::QuantizeUnorm8(value); });
+    passed &= Compare<f32, u16>(
+        "QuantizeUnorm16", floats,
+        [](const f32 *src, u16 *dst, size_t count) { Math::QuantizeUnorm16(src, dst, count); },
+        [](f32 value) { return Math::QuantizeUnorm16(value); });
+    passed &= Compare<f32, i16>(
+        "QuantizeSnorm16", floats,
+        [](const f32 *src, i16 *dst, size_t count) { Math::QuantizeSnorm16(src, dst, count); },
+        [](f32 value) { return Math::QuantizeSnorm16(value); });
+    return passed ? 0 : 1;
+}
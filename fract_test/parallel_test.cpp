@@ -0,0 +1,110 @@
+/*****************************************************************//**
+ * \file   parallel_test.cpp
+ * \brief  ParallelFor, ParallelReduce and ParallelScan must give the same result for a fixed grain on any thread count
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <utils/job/Job.h>
+#include <utils/job/Parallel.h>
+#include <utils/memory/Memory.h>
+
+namespace {
+
+constexpr uint64_t ELEMENT_COUNT = 1 << 20;
+constexpr uint64_t GRAIN_SIZE = 1000; // not a power of two so the last block is partial
+constexpr uint32_t THREAD_COUNTS[] = {1, 2, 4, 8};
+constexpr uint32_t REPEAT_COUNT = 4;
+
+struct Results {
+    float sum{};
+    std::vector<float> scan;
+    float scan_total{};
+};
+
+bool SameBits(float lhs, float rhs) { return std::memcmp(&lhs, &rhs, sizeof(float)) == 0; }
+
+bool SameBits(const std::vector<float> &lhs, const std::vector<float> &rhs) {
+    return lhs.size() == rhs.size() && std::memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(float)) == 0;
+}
+
+// every index exactly once
+bool TestFor() {
+    std::vector<std::atomic<uint32_t>> seen(ELEMENT_COUNT);
+    Fract::Job::ParallelFor(0, ELEMENT_COUNT, GRAIN_SIZE, [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; i++) {
+            seen[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    for (const std::atomic<uint32_t> &count : seen) {
+        if (count.load(std::memory_order_relaxed) != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Results Run(const std::vector<float> &input) {
+    Results results;
+    results.sum = Fract::Job::ParallelReduce(
+        0, input.size(), GRAIN_SIZE, 0.0f,
+        [&](uint64_t begin, uint64_t end, float partial) {
+            for (uint64_t i = begin; i < end; i++) {
+                partial += input[i];
+            }
+            return partial;
+        },
+        [](float lhs, float rhs) { return lhs + rhs; });
+    results.scan.resize(input.size());
+    results.scan_total = Fract::Job::ParallelScan(input.data(), results.scan.data(), input.size(), GRAIN_SIZE, 0.0f,
+                                                   [](float lhs, float rhs) { return lhs + rhs; });
+    return results;
+}
+
+} // namespace
+
+int main() {
+    Fract::Memory::initialize();
+
+    // magnitudes spread over many exponents so a different summation order changes the low bits
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> exponent(-8.0f, 8.0f);
+    std::vector<float> input(ELEMENT_COUNT);
+    for (float &value : input) {
+        value = std::exp2(exponent(random)) * (random() & 1 ? 1.0f : -1.0f);
+    }
+
+    // not initialized, everything runs inline on this thread
+    const Results reference = Run(input);
+
+    bool passed = true;
+    for (uint32_t thread_count : THREAD_COUNTS) {
+        if (!Fract::Job::Initialize(thread_count)) {
+            return 1;
+        }
+        bool same = true;
+        bool covered = true;
+        for (uint32_t repeat = 0; repeat < REPEAT_COUNT; repeat++) {
+            const Results results = Run(input);
+            same &= SameBits(results.sum, reference.sum) && SameBits(results.scan, reference.scan) &&
+                    SameBits(results.scan_total, reference.scan_total);
+            covered &= TestFor();
+        }
+        Fract::Job::Shutdown();
+        std::printf("%u threads: for %s, reduce and scan %s\n", thread_count, covered ? "covered" : "FAILED",
+                    same ? "deterministic" : "FAILED");
+        passed &= same && covered;
+    }
+
+    Fract::Memory::destroy();
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/*****************************************************************//**
+ * \file   texture_cache_test.cpp
+ * \brief  TextureCache budget, eviction and tiles pinned by threads that stopped sampling
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <texture/texture_cache.h>
+#include <utils/memory/Memory.h>
+
+namespace {
+
+using Fract::u32;
+using Fract::u64;
+using Fract::u8;
+
+constexpr u32 TILE_COUNT_X = 32;
+constexpr u32 TILE_COUNT_Y = 16;
+constexpr u32 TILE_BYTES = Fract::TEXTURE_TILE_SIZE * Fract::TEXTURE_TILE_SIZE * 4;
+constexpr u32 SAMPLE_COUNT = 1 << 16;
+
+// the smallest budget the cache accepts for one sampling thread, 68 rgba8 tiles
+constexpr u64 MEMORY_BUDGET =
+    (Fract::TEXTURE_MICRO_CACHE_SIZE + 2) * static_cast<u64>(Fract::TEXTURE_TILE_SIZE) * Fract::TEXTURE_TILE_SIZE * 8;
+constexpr u32 BUDGET_TILES = static_cast<u32>(MEMORY_BUDGET / TILE_BYTES);
+constexpr u32 STALLED_THREAD_COUNT =
+    (BUDGET_TILES + Fract::TEXTURE_MICRO_CACHE_SIZE - 1) / Fract::TEXTURE_MICRO_CACHE_SIZE;
+
+// single mip rgba8 texture, every texel of a tile holds the tile index
+bool WriteTexture(const std::filesystem::path &file_name) {
+    Fract::TiledTextureHeader header{};
+    header.magic = Fract::TILED_TEXTURE_MAGIC;
+    header.version = Fract::TILED_TEXTURE_VERSION;
+    header.format = Fract::TexelFormat::RGBA8_UNORM;
+    header.width = TILE_COUNT_X * Fract::TEXTURE_TILE_SIZE;
+    header.height = TILE_COUNT_Y * Fract::TEXTURE_TILE_SIZE;
+    header.mip_count = 1;
+
+    std::ofstream file(file_name, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    std::vector<u8> tile(TILE_BYTES);
+    for (u32 index = 0; index < TILE_COUNT_X * TILE_COUNT_Y; index++) {
+        for (u32 i = 0; i < TILE_BYTES; i += 4) {
+            tile[i] = static_cast<u8>(index);
+            tile[i + 1] = static_cast<u8>(index >> 8);
+            tile[i + 2] = 0;
+            tile[i + 3] = 255;
+        }
+        file.write(reinterpret_cast<const char *>(tile.data()), tile.size());
+    }
+    return static_cast<bool>(file);
+}
+
+// samples the first texel of tile (tile_x, tile_y) and checks it came from that tile
+bool SampleTile(Fract::TextureCache &cache, Fract::TextureHandle texture, u32 tile_x, u32 tile_y) {
+    const Fract::i32 x = static_cast<Fract::i32>(tile_x * Fract::TEXTURE_TILE_SIZE);
+    const Fract::i32 y = static_cast<Fract::i32>(tile_y * Fract::TEXTURE_TILE_SIZE);
+    const Fract::Math::float4 texel = cache.Texel(texture, 0, x, y);
+    const u32 index = static_cast<u32>(texel.x * 255.0f + 0.5f) | static_cast<u32>(texel.y * 255.0f + 0.5f) << 8;
+    return index == tile_y * TILE_COUNT_X + tile_x;
+}
+
+// threads walking the whole texture must stay in the budget and always read the right tile
+bool TestBudget(Fract::TextureHandle texture, Fract::TextureCache &cache, u32 thread_count) {
+    std::atomic<bool> correct{true};
+    std::vector<std::thread> threads;
+    for (u32 t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t] {
+            u32 random = 0x9e3779b9u * (t + 1);
+            for (u32 i = 0; i < SAMPLE_COUNT; i++) {
+                random ^= random << 13;
+                random ^= random >> 17;
+                random ^= random << 5;
+                const u32 tile = random % (TILE_COUNT_X * TILE_COUNT_Y);
+                if (!SampleTile(cache, texture, tile % TILE_COUNT_X, tile / TILE_COUNT_X)) {
+                    correct.store(false, std::memory_order_relaxed);
+                }
+            }
+            cache.FlushThreadCache();
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    const Fract::TextureCacheStatistics statistics = cache.GetStatistics();
+    const bool passed = correct.load() && statistics.resident_bytes <= MEMORY_BUDGET * thread_count &&
+                        statistics.evictions > 0 && statistics.budget_overruns == 0;
+    std::printf("budget, %u threads: %llu misses, %llu evictions, %llu resident bytes, %s\n", thread_count,
+                static_cast<unsigned long long>(statistics.misses),
+                static_cast<unsigned long long>(statistics.evictions),
+                static_cast<unsigned long long>(statistics.resident_bytes), passed ? "passed" : "FAILED");
+    return passed;
+}
+
+// threads pin every tile the budget holds and stop sampling, more than the cache sized for one thread expects. the
+// next thread must still get its tiles, over the budget, and the cache returns under it once the pins are gone.
+bool TestStalledPins(const std::filesystem::path &file_name) {
+    Fract::TextureCacheCreateInfo create_info{};
+    create_info.memory_budget = MEMORY_BUDGET;
+    create_info.shard_count = 1;
+    create_info.thread_count = 1;
+    Fract::TextureCache cache(create_info);
+    const Fract::TextureHandle texture = cache.AddTexture(file_name);
+    if (texture == Fract::INVALID_TEXTURE_HANDLE) {
+        return false;
+    }
+
+    std::atomic<u32> pinned{0};
+    std::atomic<bool> resume{false};
+    std::atomic<bool> correct{true};
+    std::vector<std::thread> stalled;
+    for (u32 row = 0; row < STALLED_THREAD_COUNT; row++) {
+        stalled.emplace_back([&, row] {
+            // one row of tiles lands in distinct micro cache entries, the last thread fills what is left
+            const u32 count =
+                std::min(Fract::TEXTURE_MICRO_CACHE_SIZE, BUDGET_TILES - row * Fract::TEXTURE_MICRO_CACHE_SIZE);
+            for (u32 x = 0; x < count; x++) {
+                if (!SampleTile(cache, texture, x, row)) {
+                    correct.store(false, std::memory_order_relaxed);
+                }
+            }
+            pinned.fetch_add(1, std::memory_order_release);
+            while (!resume.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            cache.FlushThreadCache();
+        });
+        // one after the other, a thread still pinning would drop its pins when a later one asks for them
+        while (pinned.load(std::memory_order_acquire) <= row) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::thread sampler([&] {
+        for (u32 y = STALLED_THREAD_COUNT; y < TILE_COUNT_Y; y++) {
+            for (u32 x = 0; x < TILE_COUNT_X; x++) {
+                if (!SampleTile(cache, texture, x, y)) {
+                    correct.store(false, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    sampler.join();
+    const u64 overruns = cache.GetStatistics().budget_overruns;
+
+    resume.store(true, std::memory_order_release);
+    for (std::thread &thread : stalled) {
+        thread.join();
+    }
+    // misses evict back under the budget once nothing is pinned
+    for (u32 y = 0; y < TILE_COUNT_Y; y++) {
+        for (u32 x = 0; x < TILE_COUNT_X; x++) {
+            correct.store(correct.load() && SampleTile(cache, texture, x, y));
+        }
+    }
+    cache.FlushThreadCache();
+    const u64 resident_bytes = cache.GetStatistics().resident_bytes;
+
+    const bool passed = correct.load() && overruns > 0 && resident_bytes <= MEMORY_BUDGET;
+    std::printf("stalled pins: %llu overruns, %llu resident bytes after, %s\n",
+                static_cast<unsigned long long>(overruns), static_cast<unsigned long long>(resident_bytes),
+                passed ? "passed" : "FAILED");
+    return passed;
+}
+
+} // namespace
+
+int main() {
+    Fract::Memory::initialize();
+    const std::filesystem::path file_name = std::filesystem::temp_directory_path() / "fract_texture_cache_test.ftx";
+    if (!WriteTexture(file_name)) {
+        std::printf("failed to write %s\n", file_name.string().c_str());
+        return 1;
+    }
+
+    bool passed = true;
+    for (u32 thread_count : {1u, 4u}) {
+        Fract::TextureCacheCreateInfo create_info{};
+        create_info.memory_budget = MEMORY_BUDGET * thread_count;
+        create_info.shard_count = 1;
+        create_info.thread_count = thread_count;
+        Fract::TextureCache cache(create_info);
+        const Fract::TextureHandle texture = cache.AddTexture(file_name);
+        if (texture == Fract::INVALID_TEXTURE_HANDLE) {
+            return 1;
+        }
+        passed &= TestBudget(texture, cache, thread_count);
+    }
+    passed &= TestStalledPins(file_name);
+
+    std::filesystem::remove(file_name);
+    Fract::Memory::destroy();
+    return passed ? 0 : 1;
+}
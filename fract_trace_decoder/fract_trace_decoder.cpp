@@ -0,0 +1,212 @@
+/*****************************************************************//**
+ * \file   fract_trace_decoder.cpp
+ * \brief  converts binary trace captures to chrome trace json or text
+ *
+ * \author hylu
+ * \date   November 2022
+ *********************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <utils/trace/TraceFormat.h>
+using namespace Fract::Trace;
+
+namespace {
+
+struct Site {
+    std::string name;
+    std::string file;
+    uint32_t line;
+    Category category;
+    uint8_t payload_count;
+};
+
+struct Event {
+    TraceRecord record;
+    uint32_t thread_index;
+};
+
+struct Capture {
+    TraceFileHeader header{};
+    std::unordered_map<uint64_t, Site> sites;
+    std::vector<Event> events;
+};
+
+template <typename T> bool ReadValue(std::ifstream &file, T &value) {
+    return static_cast<bool>(file.read(reinterpret_cast<char *>(&value), sizeof(T)));
+}
+
+bool ReadCapture(const char *file_name, Capture &capture) {
+    std::ifstream file(file_name, std::ios::binary);
+    if (!file) {
+        std::fprintf(stderr, "failed to open %s\n", file_name);
+        return false;
+    }
+
+    TraceFileHeader &header = capture.header;
+    if (!ReadValue(file, header) || std::memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0) {
+        std::fprintf(stderr, "%s is not a trace file\n", file_name);
+        return false;
+    }
+    if (header.version != TRACE_VERSION || header.record_size != sizeof(TraceRecord)) {
+        std::fprintf(stderr, "unsupported trace version %u, expected %u\n", header.version, TRACE_VERSION);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.site_count; i++) {
+        TraceSiteEntry entry{};
+        if (!ReadValue(file, entry) || entry.category >= Category::COUNT) {
+            std::fprintf(stderr, "corrupted site table\n");
+            return false;
+        }
+        Site site{std::string(entry.name_length, '\0'), std::string(entry.file_length, '\0'), entry.line,
+                  entry.category, std::min<uint8_t>(entry.payload_count, TRACE_PAYLOAD_COUNT)};
+        file.read(site.name.data(), entry.name_length);
+        file.read(site.file.data(), entry.file_length);
+        capture.sites.emplace(entry.site, std::move(site));
+    }
+
+    for (uint32_t i = 0; i < header.chunk_count; i++) {
+        TraceChunkHeader chunk{};
+        if (!ReadValue(file, chunk)) {
+            break;
+        }
+        for (uint32_t j = 0; j < chunk.record_count; j++) {
+            Event event{{}, chunk.thread_index};
+            if (!ReadValue(file, event.record)) {
+                break;
+            }
+            capture.events.push_back(event);
+        }
+    }
+    if (!file) {
+        std::fprintf(stderr, "%s is truncated, decoding the complete records\n", file_name);
+    }
+
+    // chunks are written in capture order per thread only
+    std::stable_sort(capture.events.begin(), capture.events.end(), [](const Event &lhs, const Event &rhs) {
+        return lhs.record.timestamp < rhs.record.timestamp;
+    });
+    return true;
+}
+
+double ToMicroseconds(const TraceFileHeader &header, uint64_t timestamp) {
+    const double ticks = static_cast<double>(static_cast<int64_t>(timestamp - header.start_ticks));
+    return ticks * 1e6 / static_cast<double>(header.ticks_per_second);
+}
+
+std::string EscapeJson(std::string_view text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// chrome://tracing and perfetto, one process with a track per recording thread
+void WriteJson(const Capture &capture, FILE *out) {
+    static constexpr char PHASES[] = {'i', 'B', 'E'};
+    std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_records\":%llu},\"traceEvents\":[\n",
+                 static_cast<unsigned long long>(capture.header.dropped_records));
+    bool first = true;
+    for (const Event &event : capture.events) {
+        const auto site = capture.sites.find(event.record.site);
+        if (site == capture.sites.end()) {
+            continue;
+        }
+        const uint32_t phase = static_cast<uint32_t>(event.record.phase);
+        std::fprintf(out, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%u",
+                     first ? "" : ",\n", EscapeJson(site->second.name).c_str(),
+                     CATEGORY_NAMES[static_cast<uint32_t>(site->second.category)], phase < 3 ? PHASES[phase] : 'i',
+                     ToMicroseconds(capture.header, event.record.timestamp), event.thread_index);
+        if (event.record.phase == Phase::INSTANT) {
+            std::fprintf(out, ",\"s\":\"t\"");
+        }
+        if (site->second.payload_count > 0) {
+            std::fprintf(out, ",\"args\":{");
+            for (uint8_t i = 0; i < site->second.payload_count; i++) {
+                std::fprintf(out, "%s\"%u\":%u", i ? "," : "", i, event.record.payload[i]);
+            }
+            std::fprintf(out, "}");
+        }
+        std::fprintf(out, "}");
+        first = false;
+    }
+    std::fprintf(out, "\n]}\n");
+}
+
+void WriteText(const Capture &capture, FILE *out) {
+    static constexpr const char *PHASES[] = {"event", "begin", "end"};
+    for (const Event &event : capture.events) {
+        const auto site = capture.sites.find(event.record.site);
+        if (site == capture.sites.end()) {
+            continue;
+        }
+        const uint32_t phase = static_cast<uint32_t>(event.record.phase);
+        std::fprintf(out, "%14.3f us  thread %-3u %-8s %-5s %s", ToMicroseconds(capture.header, event.record.timestamp),
+                     event.thread_index, CATEGORY_NAMES[static_cast<uint32_t>(site->second.category)],
+                     phase < 3 ? PHASES[phase] : "?", site->second.name.c_str());
+        for (uint8_t i = 0; i < site->second.payload_count; i++) {
+            std::fprintf(out, " %u", event.record.payload[i]);
+        }
+        std::fprintf(out, "  (%s:%u)\n", site->second.file.c_str(), site->second.line);
+    }
+    if (capture.header.dropped_records > 0) {
+        std::fprintf(out, "%llu records dropped\n", static_cast<unsigned long long>(capture.header.dropped_records));
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *input = nullptr;
+    const char *output = nullptr;
+    bool text = false;
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if (arg == "--text") {
+            text = true;
+        } else if (arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (!input && arg[0] != '-') {
+            input = argv[i];
+        } else {
+            input = nullptr;
+            break;
+        }
+    }
+    if (!input) {
+        std::fprintf(stderr, "usage: fract_trace_decoder <capture.trace> [--text] [-o <output>]\n");
+        return 1;
+    }
+
+    Capture capture;
+    if (!ReadCapture(input, capture)) {
+        return 1;
+    }
+
+    FILE *out = output ? std::fopen(output, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "failed to open %s\n", output);
+        return 1;
+    }
+    if (text) {
+        WriteText(capture, out);
+    } else {
+        WriteJson(capture, out);
+    }
+    if (output) {
+        std::fclose(out);
+    }
+    return 0;
+}